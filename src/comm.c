@@ -26,36 +26,37 @@
 #include "comm.h"
 #include "debug.h"
 
+/* Message buffer, it is reused for all messages. */
+static char *msg;
+static int msg_size;
+
 void comm_send(const char *fmt, ...)
 {
-    /* Code adapted from example in PRINTF(3) */
-    /* Guess we need no more than 100 bytes. */
-    int n, size = 100;
-    char *p;
     va_list ap;
-    p = malloc(size);
+    int n, len;
+
     while (1)
     {
         /* Try to print in the allocated space. */
         va_start(ap, fmt);
-        n = vsnprintf(p, size, fmt, ap);
+        n = vsnprintf(msg, msg_size, fmt, ap);
         va_end(ap);
-        /* If that worked, return the string. */
-        if (n > -1 && n < size)
+        /* If that worked, send the string. */
+        if (n > -1 && n < msg_size)
             break;
         /* Else try again with more space. */
         if (n > -1)
             /* glibc 2.1, set size to precisely what's needed. */
-            size = n+1;
+            msg_size = n + 1;
         else
             /* glibc 2.0, try with twice the old size. */
-            size *= 2;
-        p = realloc(p, size);
+            msg_size = (msg_size ? msg_size * 2 : 100);
+        msg = realloc(msg, msg_size);
     }
 
-    comm_send_str(p);
-    if (p[strlen(p) - 1] == '\n')
-        p[strlen(p) - 1] = 0;
-    DBG_LOG("message to engine: '%s'", p);
-    free(p);
+    comm_send_str(msg);
+    len = strlen(msg);
+    if (len > 0 && msg[len - 1] == '\n')
+        msg[len - 1] = 0;
+    DBG_LOG("message to engine: '%s'", msg);
 }
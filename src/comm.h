@@ -49,7 +49,8 @@ char *comm_poll(void);
 /* Polls the I/O library for input from the xboard engine.
 ** Parameters: (void)
 ** Returns   : (char *), Message that was received from the xboard engine
-**                 (if any).
+**                 (if any). It stays valid until the next call to comm_poll
+**                 and must not be freed.
 **             NULL, otherwise.
 */
 
@@ -24,38 +24,40 @@
 
 #ifdef COMM_SDL_THREADS
 
-#include <stdarg.h>
-#include <stdio.h>
-#include <stdlib.h>
-
 #include "main_sdlthd.h"
 #include "comm.h"
 #include "pipe_mem.h"
 
+/* Number of message slots in each direction. */
+#define COMM_PIPE_SLOTS 4096
+
+pipe_mem_t *to_ui;
+pipe_mem_t *to_engine;
+
 int comm_init(char *engine)
 {
+    to_ui = pipe_mem_new(COMM_PIPE_SLOTS);
+    to_engine = pipe_mem_new(COMM_PIPE_SLOTS);
     return 0;
 }
 
 void comm_exit(void)
 {
+    pipe_mem_free(to_engine);
+    pipe_mem_free(to_ui);
 }
 
 void comm_send_str(const char *str)
 {
-    SDL_mutexP(to_engine_mutex);
-    pipe_mem_send(&to_engine, str);
-    SDL_mutexV(to_engine_mutex);
+    pipe_mem_send(to_engine, str);
 }
 
 char *comm_poll(void)
 {
-    char *retval;
-
-    SDL_mutexP(to_ui_mutex);
-    retval = pipe_mem_poll(&to_ui);
-    SDL_mutexV(to_ui_mutex);
-    return retval;
+    /* This is called every frame, it doesn't take any locks. The message
+    ** points into the pipe and stays valid until the next call.
+    */
+    return pipe_mem_poll(to_ui);
 }
 
 #endif /* COMM_SDL_THREADS */
@@ -697,8 +697,6 @@ int dreamchess(void *data)
                         }
                     }
                 }
-
-                free(s);
             }
             ui->poll();
         }
@@ -0,0 +1,529 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+
+/* The fills use AVX2 registers where the compiler targets them. */
+#if defined(__x86_64__) && defined(__AVX2__)
+#define FILL_AVX2
+#include <immintrin.h>
+#endif
+
+#include "attack.h"
+#include "move.h"
+
+#define FILE_A 0x0101010101010101ULL
+#define FILE_B 0x0202020202020202ULL
+#define FILE_G 0x4040404040404040ULL
+#define FILE_H 0x8080808080808080ULL
+
+/* Directions of the rays. Blockers on the first four are found from the
+** low end of the bitboard, on the others from the high end.
+*/
+#define RAY_N 0
+#define RAY_E 1
+#define RAY_NE 2
+#define RAY_NW 3
+#define RAY_S 4
+#define RAY_W 5
+#define RAY_SE 6
+#define RAY_SW 7
+
+static const int ray_step[8][2] =
+{
+    {0, 1}, {1, 0}, {1, 1}, {-1, 1}, {0, -1}, {-1, 0}, {1, -1}, {-1, -1}
+};
+
+/* Squares from each square to the edge of the board, per direction. */
+static bitboard_t rays[8][64];
+
+static bitboard_t knight_attacks[64];
+static bitboard_t king_attacks[64];
+
+/* Values for the static exchange evaluation, indexed by piece. */
+static const int see_value[NR_PIECES] =
+{
+    100, 100, 300, 300, 350, 350, 500, 500, 900, 900, 2000, 2000
+};
+
+#ifdef __GNUC__
+#define LOWEST(B) __builtin_ctzll(B)
+#define HIGHEST(B) (63 - __builtin_clzll(B))
+#else
+static int LOWEST(bitboard_t bitboard)
+{
+    int square = 0;
+
+    while (!(bitboard & 1))
+    {
+        bitboard >>= 1;
+        square++;
+    }
+
+    return square;
+}
+
+static int HIGHEST(bitboard_t bitboard)
+{
+    int square = 63;
+
+    while (!(bitboard & square_bit[63]))
+    {
+        bitboard <<= 1;
+        square--;
+    }
+
+    return square;
+}
+#endif /* __GNUC__ */
+
+int attack_count(bitboard_t squares)
+{
+#ifdef __GNUC__
+    return __builtin_popcountll(squares);
+#else
+    int n = 0;
+
+    while (squares)
+    {
+        squares &= squares - 1;
+        n++;
+    }
+
+    return n;
+#endif /* __GNUC__ */
+}
+
+static bitboard_t steps(int square, const int (*step)[2], int count)
+{
+    bitboard_t attacks = 0;
+    int i;
+
+    for (i = 0; i < count; i++)
+    {
+        int file = (square & 7) + step[i][0];
+        int rank = (square >> 3) + step[i][1];
+
+        if (file >= 0 && file < 8 && rank >= 0 && rank < 8)
+            attacks |= square_bit[rank * 8 + file];
+    }
+
+    return attacks;
+}
+
+void attack_init(void)
+{
+    static const int knight_step[8][2] =
+    {
+        {-1, -2}, {1, -2}, {-2, -1}, {2, -1}, {-2, 1}, {2, 1}, {-1, 2}, {1, 2}
+    };
+    int square;
+    int dir;
+
+    for (square = 0; square < 64; square++)
+    {
+        knight_attacks[square] = steps(square, knight_step, 8);
+        king_attacks[square] = steps(square, ray_step, 8);
+
+        for (dir = 0; dir < 8; dir++)
+        {
+            int file = (square & 7) + ray_step[dir][0];
+            int rank = (square >> 3) + ray_step[dir][1];
+
+            rays[dir][square] = 0;
+
+            while (file >= 0 && file < 8 && rank >= 0 && rank < 8)
+            {
+                rays[dir][square] |= square_bit[rank * 8 + file];
+                file += ray_step[dir][0];
+                rank += ray_step[dir][1];
+            }
+        }
+    }
+}
+
+/* Returns the squares of a ray up to and including the first piece. */
+static inline bitboard_t ray(int dir, int square, bitboard_t occupied)
+{
+    bitboard_t attacks = rays[dir][square];
+    bitboard_t blockers = attacks & occupied;
+
+    if (blockers)
+        attacks ^= rays[dir][dir < RAY_S ? LOWEST(blockers)
+                                         : HIGHEST(blockers)];
+
+    return attacks;
+}
+
+bitboard_t attack_bishop(int square, bitboard_t occupied)
+{
+    return ray(RAY_NE, square, occupied) | ray(RAY_NW, square, occupied)
+           | ray(RAY_SE, square, occupied) | ray(RAY_SW, square, occupied);
+}
+
+bitboard_t attack_rook(int square, bitboard_t occupied)
+{
+    return ray(RAY_N, square, occupied) | ray(RAY_E, square, occupied)
+           | ray(RAY_S, square, occupied) | ray(RAY_W, square, occupied);
+}
+
+/* Set-wise slider attacks, by Kogge-Stone occluded fills: each
+** direction floods the empty squares from all sliders at once in three
+** doubling steps. With AVX2 a register holds all four directions of a
+** slider. SSE2 can't shift its two halves by different amounts, and the
+** masking that works around it made it slower than plain 64-bit code.
+*/
+#if defined(FILL_AVX2)
+
+/* Shift counts of 64 and more shift in zeroes, so in each lane only one
+** of the two shifts counts.
+*/
+static inline __m256i shift4(__m256i bits, __m256i left, __m256i right)
+{
+    return _mm256_or_si256(_mm256_sllv_epi64(bits, left),
+                           _mm256_srlv_epi64(bits, right));
+}
+
+static inline bitboard_t fill(bitboard_t sliders, bitboard_t empty,
+                              __m256i mask, __m256i left, __m256i right)
+{
+    __m256i gen = _mm256_set1_epi64x((long long)sliders);
+    __m256i pro = _mm256_and_si256(_mm256_set1_epi64x((long long)empty),
+                                   mask);
+    __m256i l = left, r = right;
+    __m128i half;
+    int i;
+
+    for (i = 0; i < 3; i++)
+    {
+        gen = _mm256_or_si256(gen, _mm256_and_si256(pro, shift4(gen, l, r)));
+        pro = _mm256_and_si256(pro, shift4(pro, l, r));
+        l = _mm256_add_epi64(l, l);
+        r = _mm256_add_epi64(r, r);
+    }
+
+    /* One more step from the filled squares gives the attacks, the first
+    ** blocker included.
+    */
+    gen = _mm256_and_si256(mask, shift4(gen, left, right));
+    half = _mm_or_si128(_mm256_castsi256_si128(gen),
+                        _mm256_extracti128_si256(gen, 1));
+
+    return (bitboard_t)_mm_cvtsi128_si64(_mm_or_si128(half,
+                                         _mm_unpackhi_epi64(half, half)));
+}
+
+bitboard_t attack_fill_diagonal(bitboard_t sliders, bitboard_t occupied)
+{
+    /* North-east, north-west, south-east and south-west. */
+    return fill(sliders, ~occupied,
+                _mm256_set_epi64x(~FILE_H, ~FILE_A, ~FILE_H, ~FILE_A),
+                _mm256_set_epi64x(64, 64, 7, 9),
+                _mm256_set_epi64x(9, 7, 64, 64));
+}
+
+bitboard_t attack_fill_straight(bitboard_t sliders, bitboard_t occupied)
+{
+    /* North, east, south and west. */
+    return fill(sliders, ~occupied,
+                _mm256_set_epi64x(~FILE_H, ~0ULL, ~FILE_A, ~0ULL),
+                _mm256_set_epi64x(64, 64, 1, 8),
+                _mm256_set_epi64x(1, 8, 64, 64));
+}
+
+#else
+
+/* Fills one direction, given by a left shift and the squares that can be
+** entered without wrapping around the board.
+*/
+static inline bitboard_t fill_left(bitboard_t gen, bitboard_t pro,
+                                   bitboard_t mask, int shift)
+{
+    pro &= mask;
+    gen |= pro & (gen << shift);
+    pro &= pro << shift;
+    gen |= pro & (gen << (shift * 2));
+    pro &= pro << (shift * 2);
+    gen |= pro & (gen << (shift * 4));
+
+    return (gen << shift) & mask;
+}
+
+/* Likewise, for a right shift. */
+static inline bitboard_t fill_right(bitboard_t gen, bitboard_t pro,
+                                    bitboard_t mask, int shift)
+{
+    pro &= mask;
+    gen |= pro & (gen >> shift);
+    pro &= pro >> shift;
+    gen |= pro & (gen >> (shift * 2));
+    pro &= pro >> (shift * 2);
+    gen |= pro & (gen >> (shift * 4));
+
+    return (gen >> shift) & mask;
+}
+
+bitboard_t attack_fill_diagonal(bitboard_t sliders, bitboard_t occupied)
+{
+    return fill_left(sliders, ~occupied, ~FILE_A, 9)
+           | fill_left(sliders, ~occupied, ~FILE_H, 7)
+           | fill_right(sliders, ~occupied, ~FILE_A, 7)
+           | fill_right(sliders, ~occupied, ~FILE_H, 9);
+}
+
+bitboard_t attack_fill_straight(bitboard_t sliders, bitboard_t occupied)
+{
+    return fill_left(sliders, ~occupied, ~0ULL, 8)
+           | fill_left(sliders, ~occupied, ~FILE_A, 1)
+           | fill_right(sliders, ~occupied, ~0ULL, 8)
+           | fill_right(sliders, ~occupied, ~FILE_H, 1);
+}
+
+#endif /* FILL_AVX2 */
+
+static bitboard_t pawn_attacks(bitboard_t pawns, int side)
+{
+    if (side == SIDE_WHITE)
+        return ((pawns & ~FILE_A) << 7) | ((pawns & ~FILE_H) << 9);
+
+    return ((pawns & ~FILE_A) >> 9) | ((pawns & ~FILE_H) >> 7);
+}
+
+/* Returns the pieces of a side, without phantom kings. */
+static bitboard_t side_pieces(board_t *board, int side)
+{
+    bitboard_t *b = board->bitboard;
+
+    return b[PAWN + side] | b[KNIGHT + side] | b[BISHOP + side]
+           | b[ROOK + side] | b[QUEEN + side] | board_king(board, side);
+}
+
+/* Returns the squares a knight attacks from any of a set of squares. */
+static bitboard_t knight_fill(bitboard_t knights)
+{
+    bitboard_t one = ((knights >> 1) & ~FILE_H) | ((knights << 1) & ~FILE_A);
+    bitboard_t two = ((knights >> 2) & ~(FILE_G | FILE_H))
+                     | ((knights << 2) & ~(FILE_A | FILE_B));
+
+    return (one << 16) | (one >> 16) | (two << 8) | (two >> 8);
+}
+
+/* Returns the squares a king attacks from any of a set of squares, and
+** the squares themselves.
+*/
+static bitboard_t king_fill(bitboard_t kings)
+{
+    kings |= ((kings >> 1) & ~FILE_H) | ((kings << 1) & ~FILE_A);
+
+    return kings | (kings << 8) | (kings >> 8);
+}
+
+int attack_squares(board_t *board, bitboard_t squares, int side)
+{
+    bitboard_t *b = board->bitboard;
+    bitboard_t occupied = side_pieces(board, SIDE_WHITE)
+                          | side_pieces(board, SIDE_BLACK);
+
+    /* Attacks are symmetric, so look from the squares for the pieces. */
+    return ((pawn_attacks(squares, OPPONENT(side)) & b[PAWN + side])
+            | (knight_fill(squares) & b[KNIGHT + side])
+            | (king_fill(squares) & board_king(board, side))
+            | (attack_fill_diagonal(squares, occupied)
+               & (b[BISHOP + side] | b[QUEEN + side]))
+            | (attack_fill_straight(squares, occupied)
+               & (b[ROOK + side] | b[QUEEN + side]))) != 0;
+}
+
+bitboard_t attack_to(board_t *board, int square, bitboard_t occupied)
+{
+    bitboard_t *b = board->bitboard;
+    bitboard_t diagonal = b[WHITE_BISHOP] | b[BLACK_BISHOP] | b[WHITE_QUEEN]
+                          | b[BLACK_QUEEN];
+    bitboard_t straight = b[WHITE_ROOK] | b[BLACK_ROOK] | b[WHITE_QUEEN]
+                          | b[BLACK_QUEEN];
+    bitboard_t kings = board_king(board, SIDE_WHITE)
+                       | board_king(board, SIDE_BLACK);
+
+    return ((pawn_attacks(square_bit[square], SIDE_BLACK) & b[WHITE_PAWN])
+            | (pawn_attacks(square_bit[square], SIDE_WHITE) & b[BLACK_PAWN])
+            | (knight_attacks[square] & (b[WHITE_KNIGHT] | b[BLACK_KNIGHT]))
+            | (king_attacks[square] & kings)
+            | (attack_bishop(square, occupied) & diagonal)
+            | (attack_rook(square, occupied) & straight)) & occupied;
+}
+
+/* Adds the attacks of one piece to the map. */
+static inline void add(attack_map_t *map, int piece, bitboard_t attacks,
+                       bitboard_t safe)
+{
+    int side = piece & 1;
+
+    map->by_piece[piece] |= attacks;
+    map->twice[side] |= map->by_side[side] & attacks;
+    map->by_side[side] |= attacks;
+    map->mobility[piece] += attack_count(attacks & safe);
+}
+
+void attack_map_build(board_t *board, attack_map_t *map)
+{
+    bitboard_t *b = board->bitboard;
+    bitboard_t own[2];
+    bitboard_t occupied;
+    int side;
+
+    own[SIDE_WHITE] = side_pieces(board, SIDE_WHITE);
+    own[SIDE_BLACK] = side_pieces(board, SIDE_BLACK);
+    occupied = own[SIDE_WHITE] | own[SIDE_BLACK];
+
+    /* Pawns go first, as the squares they attack aren't safe for the
+    ** pieces of the other side.
+    */
+    for (side = SIDE_WHITE; side <= SIDE_BLACK; side++)
+    {
+        bitboard_t left = (side == SIDE_WHITE ? (b[WHITE_PAWN] & ~FILE_A) << 7
+                           : (b[BLACK_PAWN] & ~FILE_A) >> 9);
+        bitboard_t right = (side == SIDE_WHITE ? (b[WHITE_PAWN] & ~FILE_H) << 9
+                            : (b[BLACK_PAWN] & ~FILE_H) >> 7);
+
+        map->by_piece[PAWN + side] = left | right;
+        map->by_side[side] = left | right;
+        map->twice[side] = left & right;
+        map->mobility[PAWN + side] = 0;
+    }
+
+    for (side = SIDE_WHITE; side <= SIDE_BLACK; side++)
+    {
+        bitboard_t safe = ~own[side] & ~map->by_piece[PAWN + OPPONENT(side)];
+        bitboard_t pieces;
+        int piece;
+
+        for (piece = KNIGHT + side; piece < NR_PIECES; piece += 2)
+        {
+            map->by_piece[piece] = 0;
+            map->mobility[piece] = 0;
+        }
+
+        for (pieces = b[KNIGHT + side]; pieces; pieces &= pieces - 1)
+            add(map, KNIGHT + side, knight_attacks[LOWEST(pieces)], safe);
+
+        for (pieces = b[BISHOP + side]; pieces; pieces &= pieces - 1)
+            add(map, BISHOP + side, attack_bishop(LOWEST(pieces), occupied),
+                safe);
+
+        for (pieces = b[ROOK + side]; pieces; pieces &= pieces - 1)
+            add(map, ROOK + side, attack_rook(LOWEST(pieces), occupied),
+                safe);
+
+        for (pieces = b[QUEEN + side]; pieces; pieces &= pieces - 1)
+        {
+            int square = LOWEST(pieces);
+
+            add(map, QUEEN + side, attack_bishop(square, occupied)
+                | attack_rook(square, occupied), safe);
+        }
+
+        pieces = board_king(board, side);
+        if (pieces)
+            add(map, KING + side, king_attacks[LOWEST(pieces)], safe);
+    }
+}
+
+int attack_in_check(board_t *board, attack_map_t *map, int side)
+{
+    bitboard_t king = board->bitboard[KING + side];
+
+    if (map)
+        return (map->by_side[OPPONENT(side)] & king) != 0;
+
+    /* Right after castling, the squares that the king crossed count as
+    ** well.
+    */
+    return attack_squares(board, king, OPPONENT(side));
+}
+
+int attack_see(board_t *board, attack_map_t *map, move_t move)
+{
+    bitboard_t *b = board->bitboard;
+    int gain[32];
+    int source = MOVE_GET(move, SOURCE);
+    int dest = MOVE_GET(move, DEST);
+    int piece = MOVE_GET(move, PIECE);
+    int side = piece & 1;
+    int depth = 0;
+    bitboard_t occupied;
+    bitboard_t attackers;
+    bitboard_t diagonal, straight;
+
+    gain[0] = (move & (CAPTURE_MOVE | CAPTURE_MOVE_EN_PASSANT)
+               ? see_value[MOVE_GET(move, CAPTURED)] : 0);
+
+    /* Taking a piece that's worth at least as much, or one that isn't
+    ** defended, can't lose material.
+    */
+    if (gain[0] >= see_value[piece]
+        || (map && !(map->by_side[OPPONENT(side)] & square_bit[dest])))
+        return gain[0];
+
+    occupied = side_pieces(board, SIDE_WHITE)
+               | side_pieces(board, SIDE_BLACK);
+    diagonal = b[WHITE_BISHOP] | b[BLACK_BISHOP] | b[WHITE_QUEEN]
+               | b[BLACK_QUEEN];
+    straight = b[WHITE_ROOK] | b[BLACK_ROOK] | b[WHITE_QUEEN]
+               | b[BLACK_QUEEN];
+    attackers = attack_to(board, dest, occupied);
+
+    for (;;)
+    {
+        int next;
+
+        /* The piece leaves its square, which may uncover a slider behind
+        ** it.
+        */
+        occupied ^= square_bit[source];
+        attackers |= (attack_bishop(dest, occupied) & diagonal)
+                     | (attack_rook(dest, occupied) & straight);
+        attackers &= occupied;
+
+        side = OPPONENT(side);
+        depth++;
+        gain[depth] = see_value[piece] - gain[depth - 1];
+
+        /* Neither side gains by going on. */
+        if ((-gain[depth - 1] > gain[depth] ? -gain[depth - 1] : gain[depth])
+            < 0 || depth == 31)
+            break;
+
+        for (next = PAWN + side; next < NR_PIECES; next += 2)
+            if (attackers & b[next])
+                break;
+
+        if (next >= NR_PIECES)
+            break;
+
+        source = LOWEST(attackers & b[next]);
+        piece = next;
+    }
+
+    while (--depth)
+        gain[depth - 1] = -(-gain[depth - 1] > gain[depth] ? -gain[depth - 1]
+                            : gain[depth]);
+
+    return gain[0];
+}
@@ -0,0 +1,138 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ATTACK_H
+#define ATTACK_H
+
+#include "board.h"
+
+/* The squares that the pieces of a position attack, worked out once per
+** node and shared by the evaluation, the static exchange evaluation and
+** the check test.
+*/
+typedef struct
+{
+    /* Squares attacked by each kind of piece, indexed like the bitboards
+    ** of a board.
+    */
+    bitboard_t by_piece[NR_PIECES];
+
+    /* Squares attacked by each side. */
+    bitboard_t by_side[2];
+
+    /* Squares attacked by at least two pieces of each side. */
+    bitboard_t twice[2];
+
+    /* Squares that the pieces of each kind can move to without being
+    ** taken by a pawn, summed over the pieces.
+    */
+    int mobility[NR_PIECES];
+}
+attack_map_t;
+
+void attack_init(void);
+/* Sets up the attack tables. Must be called once, after board_init().
+** Parameters: (void)
+** Returns   : (void)
+*/
+
+int attack_count(bitboard_t squares);
+/* Counts the squares of a bitboard.
+** Parameters: (bitboard_t) squares: The bitboard.
+** Returns   : (int) Number of squares.
+*/
+
+bitboard_t attack_bishop(int square, bitboard_t occupied);
+/* Returns the squares that a bishop attacks.
+** Parameters: (int) square: Square of the bishop.
+**             (bitboard_t) occupied: Occupied squares.
+** Returns   : (bitboard_t) The attacked squares.
+*/
+
+bitboard_t attack_rook(int square, bitboard_t occupied);
+/* Returns the squares that a rook attacks.
+** Parameters: (int) square: Square of the rook.
+**             (bitboard_t) occupied: Occupied squares.
+** Returns   : (bitboard_t) The attacked squares.
+*/
+
+bitboard_t attack_fill_diagonal(bitboard_t sliders, bitboard_t occupied);
+/* Returns the squares that a set of bishops or queens attack along the
+** diagonals, all at once.
+** Parameters: (bitboard_t) sliders: Squares of the pieces.
+**             (bitboard_t) occupied: Occupied squares.
+** Returns   : (bitboard_t) The attacked squares.
+*/
+
+bitboard_t attack_fill_straight(bitboard_t sliders, bitboard_t occupied);
+/* Returns the squares that a set of rooks or queens attack along the
+** ranks and files, all at once.
+** Parameters: (bitboard_t) sliders: Squares of the pieces.
+**             (bitboard_t) occupied: Occupied squares.
+** Returns   : (bitboard_t) The attacked squares.
+*/
+
+bitboard_t attack_to(board_t *board, int square, bitboard_t occupied);
+/* Returns the pieces of both sides that attack a square.
+** Parameters: (board_t *) board: The position.
+**             (int) square: The square.
+**             (bitboard_t) occupied: Squares that block sliders, normally
+**                 all pieces of the position.
+** Returns   : (bitboard_t) Squares of the attackers.
+*/
+
+void attack_map_build(board_t *board, attack_map_t *map);
+/* Works out the attacks of a position.
+** Parameters: (board_t *) board: The position.
+**             (attack_map_t *) map: Receives the attacks.
+** Returns   : (void)
+*/
+
+int attack_squares(board_t *board, bitboard_t squares, int side);
+/* Returns whether a side attacks any of a set of squares.
+** Parameters: (board_t *) board: The position.
+**             (bitboard_t) squares: The squares.
+**             (int) side: The attacking side, SIDE_WHITE or SIDE_BLACK.
+** Returns   : (int) 1 if one of the squares is attacked, 0 if not.
+*/
+
+int attack_in_check(board_t *board, attack_map_t *map, int side);
+/* Returns whether the king of a side is attacked.
+** Parameters: (board_t *) board: The position.
+**             (attack_map_t *) map: Attacks of the position, or NULL to
+**                 look at the king's square only.
+**             (int) side: SIDE_WHITE or SIDE_BLACK.
+** Returns   : (int) 1 if the king is attacked, 0 if not.
+*/
+
+int attack_see(board_t *board, attack_map_t *map, move_t move);
+/* Static exchange evaluation: the material that a capture wins or loses
+** once all captures on its destination have been played out, with each
+** side choosing its least valuable attacker and stopping when that's
+** better. Captures of a piece worth at least the capturer aren't played
+** out: they return the value of the captured piece.
+** Parameters: (board_t *) board: The position before the move.
+**             (attack_map_t *) map: Attacks of the position, or NULL.
+**                 Captures of undefended pieces are decided from it.
+**             (move_t) move: The capture.
+** Returns   : (int) The material won, negative if it's lost.
+*/
+
+#endif /* ATTACK_H */
@@ -0,0 +1,266 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Compares per-piece slider attacks, one table lookup for every bishop,
+** rook and queen, with the set-wise fills of attack_fill_diagonal() and
+** attack_fill_straight(), on positions from random games. It first checks
+** that both give the same squares.
+**
+** Usage: attack_bench [positions]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "instance.h"
+#include "board.h"
+#include "move.h"
+#include "attack.h"
+#include "commands.h"
+
+#define DEFAULT_POSITIONS 4096
+#define ROUNDS 200
+
+static board_t *positions;
+static int count;
+
+static long long now(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+/* Plays random moves from the starting position, and keeps the final
+** position of games that last long enough.
+*/
+static void make_positions(int wanted)
+{
+    positions = malloc(wanted * sizeof(board_t));
+    count = 0;
+    srand(7);
+
+    while (count < wanted)
+    {
+        dreamer_t *d = dreamer_new(1, NULL);
+        int plies = 16 + rand() % 30;
+        int ply;
+
+        for (ply = 0; ply < plies; ply++)
+        {
+            move_t list[256];
+            int generated = move_generate(dreamer_board(d), list);
+            int tries;
+
+            if (generated <= 0)
+                break;
+
+            /* The list can hold moves that leave the king in check. */
+            for (tries = 0; tries < 20; tries++)
+            {
+                char *s = coord_move_str(list[rand() % generated]);
+                int illegal = dreamer_move(d, s);
+
+                free(s);
+                if (!illegal)
+                    break;
+            }
+
+            if (tries == 20)
+                break;
+        }
+
+        if (ply == plies)
+            positions[count++] = *dreamer_board(d);
+
+        dreamer_free(d);
+    }
+}
+
+static bitboard_t all_pieces(board_t *board)
+{
+    bitboard_t *b = board->bitboard;
+    bitboard_t all = board_king(board, SIDE_WHITE)
+                     | board_king(board, SIDE_BLACK);
+    int piece;
+
+    for (piece = 0; piece < NR_PIECES; piece++)
+        if ((piece & ~1) != KING)
+            all |= b[piece];
+
+    return all;
+}
+
+static bitboard_t lookup_diagonal(bitboard_t sliders, bitboard_t occupied)
+{
+    bitboard_t attacks = 0;
+
+    for (; sliders; sliders &= sliders - 1)
+        attacks |= attack_bishop(__builtin_ctzll(sliders), occupied);
+
+    return attacks;
+}
+
+static bitboard_t lookup_straight(bitboard_t sliders, bitboard_t occupied)
+{
+    bitboard_t attacks = 0;
+
+    for (; sliders; sliders &= sliders - 1)
+        attacks |= attack_rook(__builtin_ctzll(sliders), occupied);
+
+    return attacks;
+}
+
+/* Whether a side's king is attacked, one lookup per square. */
+static int lookup_in_check(board_t *board, int side)
+{
+    bitboard_t occ = all_pieces(board);
+    bitboard_t kings = board->bitboard[KING + side];
+    bitboard_t them = 0;
+    int piece;
+
+    for (piece = OPPONENT(side); piece < NR_PIECES; piece += 2)
+        if ((piece & ~1) != KING)
+            them |= board->bitboard[piece];
+
+    them |= board_king(board, OPPONENT(side));
+
+    /* Phantom kings after castling are checked as well. */
+    for (; kings; kings &= kings - 1)
+        if (attack_to(board, __builtin_ctzll(kings), occ) & them)
+            return 1;
+
+    return 0;
+}
+
+static int check(void)
+{
+    int errors = 0;
+    int i;
+
+    for (i = 0; i < count; i++)
+    {
+        bitboard_t *b = positions[i].bitboard;
+        bitboard_t occ = all_pieces(&positions[i]);
+        int side, square;
+
+        for (side = SIDE_WHITE; side <= SIDE_BLACK; side++)
+        {
+            bitboard_t diagonal = b[BISHOP + side] | b[QUEEN + side];
+            bitboard_t straight = b[ROOK + side] | b[QUEEN + side];
+
+            errors += attack_fill_diagonal(diagonal, occ)
+                      != lookup_diagonal(diagonal, occ);
+            errors += attack_fill_straight(straight, occ)
+                      != lookup_straight(straight, occ);
+            errors += attack_squares(&positions[i], b[KING + side],
+                                     OPPONENT(side))
+                      != lookup_in_check(&positions[i], side);
+        }
+
+        for (square = 0; square < 64; square++)
+        {
+            errors += attack_fill_diagonal(square_bit[square], occ)
+                      != attack_bishop(square, occ);
+            errors += attack_fill_straight(square_bit[square], occ)
+                      != attack_rook(square, occ);
+        }
+    }
+
+    return errors;
+}
+
+/* Prints the time per side of one way to compute the attacks. */
+static void report(const char *name, long long start)
+{
+    printf("%-28s %6.1f ns\n", name,
+           (now() - start) * 1000.0 / ((double)ROUNDS * count * 2));
+}
+
+int main(int argc, char **argv)
+{
+    volatile bitboard_t sink = 0;
+    long long start;
+    int round, i, side, errors;
+
+    dreamer_init();
+    make_positions(argc > 1 ? atoi(argv[1]) : DEFAULT_POSITIONS);
+
+    errors = check();
+    if (errors)
+    {
+        fprintf(stderr, "%i mismatches between lookups and fills\n", errors);
+        return 1;
+    }
+
+    printf("%i positions, time per side:\n", count);
+
+    start = now();
+    for (round = 0; round < ROUNDS; round++)
+        for (i = 0; i < count; i++)
+        {
+            bitboard_t *b = positions[i].bitboard;
+            bitboard_t occ = all_pieces(&positions[i]);
+
+            for (side = SIDE_WHITE; side <= SIDE_BLACK; side++)
+                sink ^= lookup_diagonal(b[BISHOP + side] | b[QUEEN + side],
+                                        occ)
+                        | lookup_straight(b[ROOK + side] | b[QUEEN + side],
+                                          occ);
+        }
+    report("Slider attacks, per piece", start);
+
+    start = now();
+    for (round = 0; round < ROUNDS; round++)
+        for (i = 0; i < count; i++)
+        {
+            bitboard_t *b = positions[i].bitboard;
+            bitboard_t occ = all_pieces(&positions[i]);
+
+            for (side = SIDE_WHITE; side <= SIDE_BLACK; side++)
+                sink ^= attack_fill_diagonal(b[BISHOP + side]
+                                             | b[QUEEN + side], occ)
+                        | attack_fill_straight(b[ROOK + side]
+                                               | b[QUEEN + side], occ);
+        }
+    report("Slider attacks, set-wise", start);
+
+    start = now();
+    for (round = 0; round < ROUNDS; round++)
+        for (i = 0; i < count; i++)
+            for (side = SIDE_WHITE; side <= SIDE_BLACK; side++)
+                sink += lookup_in_check(&positions[i], side);
+    report("King in check, per square", start);
+
+    start = now();
+    for (round = 0; round < ROUNDS; round++)
+        for (i = 0; i < count; i++)
+            for (side = SIDE_WHITE; side <= SIDE_BLACK; side++)
+                sink += attack_squares(&positions[i],
+                                       positions[i].bitboard[KING + side],
+                                       OPPONENT(side));
+    report("King in check, set-wise", start);
+
+    free(positions);
+    dreamer_exit();
+    return 0;
+}
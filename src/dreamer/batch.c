@@ -0,0 +1,422 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "dreamer.h"
+#include "batch.h"
+#include "commands.h"
+#include "epd.h"
+#include "instance.h"
+#include "search.h"
+
+/* Positions per thread that are kept in memory. */
+#define BATCH_WINDOW 16
+
+/* Maximum length of an output line. */
+#define BATCH_LINE 8192
+
+typedef struct
+{
+    char *line; /* The input line, replaced by the output once searched. */
+    int done;
+}
+slot_t;
+
+typedef struct
+{
+    int depth;
+    int score;
+    int nodes;
+    char pv[BATCH_LINE / 2];
+}
+result_t;
+
+/* Guards the slots and the counters. */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+
+/* Line n is kept in slot n % window from when it's read until it's
+** printed.
+*/
+static slot_t *slots;
+static int window;
+static long read_count;
+static long search_count;
+static long write_count;
+static int eof;
+static int errors;
+
+static dreamer_limits_t limits;
+
+/* Holds the transposition table that the threads share. */
+static dreamer_t *table;
+
+static void batch_info(void *data, search_info_t *info)
+{
+    result_t *result = data;
+    int len = 0;
+    int i;
+
+    if (info->rank > 0)
+        return;
+
+    result->depth = info->depth;
+    result->score = info->score;
+    result->nodes = info->nodes;
+
+    for (i = 0; i < info->len && len < (int)sizeof(result->pv) - 8; i++)
+    {
+        char *s = coord_move_str(info->pv[i]);
+        len += sprintf(result->pv + len, "%s%s", i ? " " : "", s);
+        free(s);
+    }
+
+    result->pv[len] = '\0';
+}
+
+/* Returns the FEN of an EPD or FEN line. Sets *end to the end of the
+** position and *ops to the EPD operations following it.
+*/
+static char *batch_fen(char *line, char **end, char **ops)
+{
+    board_t board;
+    char *fen;
+    int counters = -1;
+
+    if (epd_parse(line, &board, end))
+        return NULL;
+
+    *ops = *end;
+
+    /* A FEN has the move counters where EPD has its operations. */
+    sscanf(*ops, " %*d %*d%n", &counters);
+
+    if (counters > 0 && (!(*ops)[counters]
+                         || isspace((unsigned char)(*ops)[counters])))
+    {
+        *ops += counters;
+        fen = malloc(*ops - line + 1);
+        memcpy(fen, line, *ops - line);
+        fen[*ops - line] = '\0';
+    }
+    else
+    {
+        fen = malloc(*end - line + 5);
+        memcpy(fen, line, *end - line);
+        strcpy(fen + (*end - line), " 0 1");
+    }
+
+    return fen;
+}
+
+/* Appends to an output line, cutting it off if it gets too long. */
+static void batch_append(char *out, int *len, const char *fmt, ...)
+{
+    va_list ap;
+    int n;
+
+    va_start(ap, fmt);
+    n = vsnprintf(out + *len, BATCH_LINE - *len, fmt, ap);
+    va_end(ap);
+
+    if (n > 0)
+        *len += n;
+
+    if (*len > BATCH_LINE - 1)
+        *len = BATCH_LINE - 1;
+}
+
+/* Operations that the analysis replaces. */
+static const char *const batch_results[] =
+{
+    "eval", "ce", "dm", "acd", "acn", "bm", "pv", NULL
+};
+
+/* Appends the EPD operations of the input, except those that the analysis
+** replaces.
+*/
+static void batch_copy_ops(char *out, int *len, char *ops)
+{
+    while (*ops)
+    {
+        char *op;
+        int quoted = 0;
+        int code, i;
+
+        ops += strspn(ops, " \t");
+        op = ops;
+
+        /* Semicolons in strings don't end the operation. */
+        while (*ops && (quoted || *ops != ';'))
+        {
+            if (*ops == '"')
+                quoted = !quoted;
+            ops++;
+        }
+
+        code = strcspn(op, " \t;");
+
+        for (i = 0; batch_results[i]; i++)
+            if ((int)strlen(batch_results[i]) == code
+                && !strncmp(op, batch_results[i], code))
+                break;
+
+        if (ops > op && !batch_results[i])
+        {
+            char *last = ops;
+
+            while (last > op && isspace((unsigned char)last[-1]))
+                last--;
+
+            batch_append(out, len, " %.*s;", (int)(last - op), op);
+        }
+
+        if (*ops == ';')
+            ops++;
+    }
+}
+
+/* Analyses a line of input and returns the line of output. Sets *invalid
+** if the line has no valid position.
+*/
+static char *batch_analyse(dreamer_t *d, char *line, int *invalid)
+{
+    char out[BATCH_LINE];
+    result_t result;
+    char *fen, *end, *ops, *s;
+    move_t move;
+    int len = 0;
+
+    line[strcspn(line, "\r\n")] = '\0';
+    line += strspn(line, " \t");
+
+    if (!*line || *line == '#')
+    {
+        batch_append(out, &len, "%s", line);
+        return strdup(out);
+    }
+
+    fen = batch_fen(line, &end, &ops);
+
+    if (!fen || dreamer_set_position(d, fen, NULL))
+    {
+        free(fen);
+        batch_append(out, &len, "%s c0 \"Invalid position\";", line);
+        *invalid = 1;
+        return strdup(out);
+    }
+
+    free(fen);
+
+    /* The position, then the operations of the input. */
+    batch_append(out, &len, "%.*s", (int)(end - line), line);
+    batch_copy_ops(out, &len, ops);
+    batch_append(out, &len, " eval %i;", dreamer_eval(d));
+
+    result.depth = 0;
+    move = dreamer_search(d, &limits, batch_info, &result);
+
+    if (move == RESIGN_MOVE || move == STALEMATE_MOVE)
+    {
+        batch_append(out, &len, " c0 \"%s\";",
+                     move == RESIGN_MOVE ? "Checkmate" : "Stalemate");
+        return strdup(out);
+    }
+
+    if (move == NO_MOVE)
+        return strdup(out);
+
+    if (result.depth > 0)
+    {
+        if (result.score > ALPHABETA_MAX - 1000)
+            batch_append(out, &len, " dm %i;",
+                         (ALPHABETA_MAX - result.score + 1) / 2);
+        else if (result.score < ALPHABETA_MIN + 1000)
+            batch_append(out, &len, " dm %i;",
+                         -(result.score - ALPHABETA_MIN + 1) / 2);
+        else
+            batch_append(out, &len, " ce %i;", result.score);
+
+        batch_append(out, &len, " acd %i; acn %i;", result.depth,
+                     result.nodes);
+    }
+
+    s = coord_move_str(move);
+    batch_append(out, &len, " bm %s;", s);
+    free(s);
+
+    if (result.depth > 0)
+        batch_append(out, &len, " pv %s;", result.pv);
+
+    return strdup(out);
+}
+
+static void *batch_worker(void *arg)
+{
+    dreamer_t *d = dreamer_new(0, table);
+
+    while (d)
+    {
+        slot_t *slot;
+        char *out;
+        int invalid = 0;
+
+        pthread_mutex_lock(&lock);
+
+        while (search_count == read_count && !eof)
+            pthread_cond_wait(&cond, &lock);
+
+        if (search_count == read_count)
+        {
+            pthread_mutex_unlock(&lock);
+            break;
+        }
+
+        slot = &slots[search_count++ % window];
+        pthread_mutex_unlock(&lock);
+
+        out = batch_analyse(d, slot->line, &invalid);
+
+        pthread_mutex_lock(&lock);
+        errors += invalid;
+        free(slot->line);
+        slot->line = out;
+        slot->done = 1;
+
+        /* Print what is ready, in input order. */
+        while (write_count < search_count && slots[write_count % window].done)
+        {
+            slot = &slots[write_count++ % window];
+            puts(slot->line);
+            free(slot->line);
+            slot->line = NULL;
+            slot->done = 0;
+        }
+
+        pthread_cond_broadcast(&cond);
+        pthread_mutex_unlock(&lock);
+    }
+
+    if (d)
+        dreamer_free(d);
+
+    dreamer_thread_exit();
+    return NULL;
+}
+
+int batch_eval(char *filename, int depth, int nodes, int threads, int hash)
+{
+    FILE *f = (strcmp(filename, "-") ? fopen(filename, "r") : stdin);
+    char line[4096];
+    pthread_t *thread;
+    long number = 0;
+    int i;
+
+    if (depth <= 0 && nodes <= 0)
+    {
+        fprintf(stderr, "A depth or node limit is needed\n");
+        return 1;
+    }
+
+    if (!f)
+    {
+        fprintf(stderr, "Error opening %s\n", filename);
+        return 1;
+    }
+
+    table = dreamer_new(hash, NULL);
+
+    if (!table)
+    {
+        fprintf(stderr, "Not enough memory for %i MB of hash\n", hash);
+        return 1;
+    }
+
+    if (threads < 1)
+        threads = 1;
+
+    limits.depth = depth;
+    limits.nodes = nodes;
+    limits.msec = 0;
+    limits.multipv = 1;
+
+    window = threads * BATCH_WINDOW;
+    slots = calloc(window, sizeof(slot_t));
+    thread = malloc(threads * sizeof(pthread_t));
+
+    for (i = 0; i < threads; i++)
+        pthread_create(&thread[i], NULL, batch_worker, NULL);
+
+    while (fgets(line, sizeof(line), f))
+    {
+        int too_long = !strchr(line, '\n') && !feof(f);
+
+        number++;
+
+        /* A line that doesn't fit is rejected whole, leaving a comment in
+        ** its place so that the output stays in step with the input.
+        */
+        if (too_long)
+        {
+            int c;
+
+            while ((c = getc(f)) != EOF && c != '\n')
+                ;
+
+            fprintf(stderr, "Line %li is too long\n", number);
+            sprintf(line, "# Line %li is too long\n", number);
+        }
+
+        pthread_mutex_lock(&lock);
+
+        while (read_count - write_count >= window)
+            pthread_cond_wait(&cond, &lock);
+
+        errors += too_long;
+        slots[read_count++ % window].line = strdup(line);
+        pthread_cond_broadcast(&cond);
+        pthread_mutex_unlock(&lock);
+    }
+
+    pthread_mutex_lock(&lock);
+    eof = 1;
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&lock);
+
+    for (i = 0; i < threads; i++)
+        pthread_join(thread[i], NULL);
+
+    fflush(stdout);
+
+    if (f != stdin)
+        fclose(f);
+
+    free(thread);
+    free(slots);
+    dreamer_free(table);
+
+    return errors > 0;
+}
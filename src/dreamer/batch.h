@@ -0,0 +1,58 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#define BATCH_DEFAULT_DEPTH 6
+#define BATCH_DEFAULT_HASH 64
+
+int batch_eval(char *filename, int depth, int nodes, int threads, int hash);
+/* Evaluates a stream of positions, one per line in FEN or EPD, and prints
+** every line back in EPD with the analysis appended:
+**
+**   eval <n>        Static evaluation in centipawns.
+**   ce <n>/dm <n>   Search score in centipawns, or moves to mate.
+**   acd <n>         Depth of the search.
+**   acn <n>         Nodes searched.
+**   bm <move>       Best move.
+**   pv <moves>      Principal variation.
+**
+** Moves are in coordinate notation and scores are from the point of view
+** of the side to move. Empty lines and lines starting with '#' are passed
+** through. Operations of the input are kept, except those listed above,
+** which are replaced. The output is in input order, while only a few positions per
+** thread are kept in memory, so the input can be of any size. Results
+** can vary with the number of threads, as the threads share the
+** transposition table.
+** Parameters: (char *) filename: The input file, or "-" for stdin.
+**             (int) depth: Depth to search each position to, or 0 for no
+**                 limit.
+**             (int) nodes: Nodes to search each position for, or 0 for no
+**                 limit. At least one of depth and nodes must be given.
+**             (int) threads: Number of positions to search at once.
+**             (int) hash: Size of the transposition table that the threads
+**                 share, in megabytes.
+** Returns   : (int) 0 on success, 1 if the input can't be read, has
+**                 invalid positions or lines longer than 4095 characters,
+**                 or neither limit is given.
+*/
+
+#endif /* BATCH_H */
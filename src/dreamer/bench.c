@@ -0,0 +1,176 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+
+#include "dreamer.h"
+#include "bench.h"
+#include "e_comm.h"
+#include "history.h"
+#include "repetition.h"
+#include "search.h"
+#include "timer.h"
+#include "transposition.h"
+
+/* Openings, middlegames, tactical positions and endgames. */
+static char *positions[] =
+{
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 11",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+    "rq3rk1/ppp2ppp/1bnpb3/3N2B1/3NP3/7P/PPPQ1PP1/2KR3R w - - 7 14",
+    "r1bq1r1k/1pp1n1pp/1p1p4/4p2Q/4Pp2/1BNP4/PPP2PPP/3R1RK1 w - - 2 14",
+    "r3r1k1/2p2ppp/p1p1bn2/8/1q2P3/2NPQN2/PPP3PP/R4RK1 b - - 2 15",
+    "r1bbk1nr/pp3p1p/2n5/1N4p1/2Np1B2/8/PPP2PPP/2KR1B1R w kq - 0 13",
+    "r1bq1rk1/ppp1nppp/4n3/3p3Q/3P4/1BP1B3/PP1N2PP/R4RK1 w - - 1 16",
+    "4r1k1/r1q2ppp/ppp2n2/4P3/5Rb1/1N1BQ3/PPP3PP/R5K1 w - - 1 17",
+    "2rqkb1r/ppp2p2/2npb1p1/1N1Nn2p/2P1PP2/8/PP2B1PP/R1BQK2R b KQ - 0 11",
+    "r1bq1r1k/b1p1npp1/p2p3p/1p6/3PP3/1B2NN2/PP3PPP/R2Q1RK1 w - - 1 16",
+    "3r1rk1/p5pp/bpp1pp2/8/q1PP1P2/b3P3/P2NQRPP/1R2B1K1 b - - 6 22",
+    "r1q2rk1/2p1bppp/2Pp4/p6b/Q1PNp3/4B3/PP1R1PPP/2K4R w - - 2 18",
+    "4k2r/1pb2ppp/1p2p3/1R1p4/3P4/2r1PN2/P4PPP/1R4K1 b - - 3 22",
+    "3q2k1/pb3p1p/4pbp1/2r5/PpN2N2/1P2P2P/5PP1/Q2R2K1 b - - 4 26",
+    "r3k2r/3nnpbp/q2pp1p1/p7/Pp1PPPP1/4BNN1/1P5P/R2Q1RK1 w kq - 0 16",
+    "4rrk1/1p1nq3/p7/2p1P1pp/3P2bp/3Q1Bn1/PPPB4/1K2R1NR w - - 40 21",
+    "2rr3k/pp3pp1/1nnqbN1p/3pN3/2pP4/2P3Q1/PPB4P/R4RK1 w - - 0 1",
+    "r1b1kb1r/3q1ppp/pBp1pn2/8/Np3P2/5B2/PPP3PP/R2Q1RK1 w kq - 0 1",
+    "5rk1/1ppb3p/p1pb4/6q1/3P1p1r/2P1R2P/PP1BQ1P1/5RKN w - - 0 1",
+    "r1bq2rk/pp3pbp/2p1p1pQ/7P/3P4/2PB1N2/PP3PPR/2KR4 w - - 0 1",
+    "5k2/6pp/p1qN4/1p1p4/3P4/2PKP2Q/PP3r2/3R4 b - - 0 1",
+    "3b4/5kp1/1p1p1p1p/pP1PpP1P/P1P1P3/3KN3/8/8 w - - 0 1",
+    "6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/3N4 b - - 0 1",
+    "2K5/p7/7P/5pR1/8/5k2/r7/8 w - - 0 1",
+    "8/6pk/1p6/8/PP3p1p/5P2/4KP1q/3Q4 w - - 0 1",
+    "7k/3p2pp/4q3/8/4Q3/5Kp1/P6b/8 w - - 0 1",
+    "8/2p5/8/2kPKp1p/2p4P/2P5/3P4/8 w - - 0 1",
+    "8/1p3pp1/7p/5P1P/2k3P1/8/2K2P2/8 w - - 0 1",
+    "8/pp2r1k1/2p1p3/3pP2p/1P1P1P1P/P5KR/8/8 w - - 0 1",
+    "8/3p4/p1bk3p/Pp6/1Kp1PpPp/2P2P1P/2P5/5B2 b - - 0 1",
+    "5k2/7R/4P2p/5K2/p1r2P1p/8/8/8 b - - 0 1",
+    "6k1/6p1/P6p/r1N5/5p2/7P/1b3PP1/4R1K1 w - - 0 1",
+    "6k1/4pp1p/3p2p1/P1pPb3/R7/1r2P1PP/3B1P2/6K1 w - - 0 1",
+    "8/3p3B/5p2/5P2/p7/PP5b/k7/6K1 w - - 0 1",
+    "8/8/8/8/5kp1/P7/8/1K1N4 w - - 0 1",
+    "8/8/1P6/5pr1/8/4R3/7k/2K5 w - - 0 1",
+    "8/2p4P/8/kr6/6R1/8/8/1K6 w - - 0 1",
+    "8/8/3k4/8/8/3K4/3P4/8 w - - 0 1",
+    NULL
+};
+
+void bench(state_t *state, int depth, int threads, int hash)
+{
+    state_t saved = *state;
+    int old_hash = transposition_size();
+    long long total_nodes = 0;
+    long long start = timer_now();
+    long long elapsed;
+    int count = 0;
+    int i;
+
+    if (depth < 1 || depth > MAX_DEPTH)
+        depth = BENCH_DEFAULT_DEPTH;
+
+    if (hash < 1)
+        hash = BENCH_DEFAULT_HASH;
+
+    /* The search is single-threaded. */
+    if (threads != 1)
+        e_comm_send("Using 1 thread instead of %i\n", threads);
+
+    if (hash != old_hash)
+    {
+        transposition_exit();
+        transposition_init(hash);
+    }
+
+    set_option(OPTION_POST, 0);
+
+    for (i = 0; positions[i]; i++)
+    {
+        long long pos_start = timer_now();
+        int nodes;
+
+        if (setup_board_fen(&state->board, positions[i]))
+        {
+            e_comm_send("Invalid bench position %s\n", positions[i]);
+            continue;
+        }
+
+        /* Every position starts from scratch, so the node count doesn't
+        ** depend on the order or on what was searched before.
+        */
+        clear_table();
+        forget_history();
+        pv_clear();
+        repetition_init(&state->board);
+
+        state->depth = depth;
+        state->nodes = 0;
+        state->flags = FLAG_INFINITE;
+        find_best_move(state);
+
+        if (state->mode == MODE_QUIT || (state->flags & FLAG_IGNORE_MOVE))
+            break;
+
+        nodes = search_nodes();
+        total_nodes += nodes;
+        count++;
+
+        e_comm_send("Position %2i/%i: %10i nodes %6lli ms\n", count,
+                    (int)(sizeof(positions) / sizeof(positions[0]) - 1),
+                    nodes, timer_now() - pos_start);
+    }
+
+    elapsed = timer_now() - start;
+
+    e_comm_send("===========================\n");
+    e_comm_send("Positions       : %i\n", count);
+    e_comm_send("Depth           : %i\n", depth);
+    e_comm_send("Total time (ms) : %lli\n", elapsed);
+    e_comm_send("Nodes searched  : %lli\n", total_nodes);
+    e_comm_send("Nodes/second    : %lli\n",
+                elapsed > 0 ? total_nodes * 1000 / elapsed : 0);
+
+    if (hash != old_hash)
+    {
+        transposition_exit();
+        transposition_init(old_hash);
+    }
+
+    clear_table();
+    forget_history();
+    pv_clear();
+
+    if (state->mode == MODE_QUIT)
+        saved.mode = MODE_QUIT;
+
+    *state = saved;
+    restore_repetition(state);
+}
+
+void bench_command(state_t *state, char *args)
+{
+    int depth = strtol(args, &args, 10);
+    int threads = strtol(args, &args, 10);
+    int hash = strtol(args, &args, 10);
+
+    bench(state, depth, threads > 0 ? threads : 1, hash);
+}
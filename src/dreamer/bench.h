@@ -0,0 +1,49 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "dreamer.h"
+
+#define BENCH_DEFAULT_DEPTH 5
+#define BENCH_DEFAULT_HASH 16
+
+void bench(state_t *state, int depth, int threads, int hash);
+/* Searches a fixed set of positions to a fixed depth and prints the node
+** counts and speed. The total node count is a signature of the search: it
+** only changes when the search itself changes.
+** Parameters: (state_t *) state: The engine state. The current game is
+**                 restored afterwards, the transposition table is not.
+**             (int) depth: Depth to search each position to.
+**             (int) threads: Number of search threads.
+**             (int) hash: Transposition table size in megabytes.
+** Returns   : (void)
+*/
+
+void bench_command(state_t *state, char *args);
+/* Runs bench with the arguments of a "bench [depth] [threads] [hash]"
+** command.
+** Parameters: (state_t *) state: The engine state.
+**             (char *) args: The arguments, missing ones take the defaults.
+** Returns   : (void)
+*/
+
+#endif /* BENCH_H */
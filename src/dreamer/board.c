@@ -276,6 +276,33 @@ void clear_board(board_t *board)
     board->material_value[SIDE_BLACK] = 0;
 }
 
+void board_add_piece(board_t *board, int square, int piece)
+{
+    add_piece(board, square, piece);
+}
+
+bitboard_t board_king(board_t *board, int side)
+{
+    bitboard_t king = board->bitboard[KING + side];
+
+    if (side == SIDE_WHITE)
+    {
+        if (board->castle_flags & WHITE_PHANTOM_KINGS_KINGSIDE)
+            king &= ~WHITE_PHANTOM_KINGSIDE;
+        if (board->castle_flags & WHITE_PHANTOM_KINGS_QUEENSIDE)
+            king &= ~WHITE_PHANTOM_QUEENSIDE;
+    }
+    else
+    {
+        if (board->castle_flags & BLACK_PHANTOM_KINGS_KINGSIDE)
+            king &= ~BLACK_PHANTOM_KINGSIDE;
+        if (board->castle_flags & BLACK_PHANTOM_KINGS_QUEENSIDE)
+            king &= ~BLACK_PHANTOM_QUEENSIDE;
+    }
+
+    return king;
+}
+
 int find_black_piece(board_t *board, int square)
 {
     bitboard_t mask = square_bit[square];
@@ -617,184 +644,14 @@ void execute_move(board_t *board, move_t move)
     board->hash_key ^= black_to_move;
 }
 
-void unmake_move(board_t *board, move_t move, bitboard_t
-                 old_en_passant,                int
-                 old_castle_flags, int old_fifty_moves)
+void board_make(board_t *board, move_t move, board_undo_t *undo)
 {
-    int castle_diff;
-
-    /* Switch players. */
-    board->current_player = OPPONENT(board->current_player);
-    board->hash_key ^= black_to_move;
-
-    /* Promotion moves. */
-    switch (move & MOVE_PROMOTION_MASK)
-    {
-    case PROMOTION_MOVE_KNIGHT:
-        remove_piece(board, MOVE_GET(move, DEST), KNIGHT + board->current_player);
-        add_piece(board, MOVE_GET(move, DEST), MOVE_GET(move, PIECE));
-        break;
-    case PROMOTION_MOVE_BISHOP:
-        remove_piece(board, MOVE_GET(move, DEST), BISHOP + board->current_player);
-        add_piece(board, MOVE_GET(move, DEST), MOVE_GET(move, PIECE));
-        break;
-    case PROMOTION_MOVE_ROOK:
-        remove_piece(board, MOVE_GET(move, DEST), ROOK + board->current_player);
-        add_piece(board, MOVE_GET(move, DEST), MOVE_GET(move, PIECE));
-        break;
-    case PROMOTION_MOVE_QUEEN:
-        remove_piece(board, MOVE_GET(move, DEST), QUEEN + board->current_player);
-        add_piece(board, MOVE_GET(move, DEST), MOVE_GET(move, PIECE));
-    }
-
-    switch (move & MOVE_NO_PROMOTION_MASK)
-    {
-    case NORMAL_MOVE:
-        remove_piece(board, MOVE_GET(move, DEST), MOVE_GET(move, PIECE));
-        add_piece(board, MOVE_GET(move, SOURCE), MOVE_GET(move, PIECE));
-        break;
-
-    case CAPTURE_MOVE:
-        remove_piece(board, MOVE_GET(move, DEST), MOVE_GET(move, PIECE));
-        add_piece(board, MOVE_GET(move, DEST), MOVE_GET(move, CAPTURED));
-        add_piece(board, MOVE_GET(move, SOURCE), MOVE_GET(move, PIECE));
-        break;
-
-    case CAPTURE_MOVE_EN_PASSANT:
-        remove_piece(board, MOVE_GET(move, DEST), MOVE_GET(move, PIECE));
-        add_piece(board, MOVE_GET(move, DEST) + (MOVE_GET(move, PIECE) & 1? 8 : -8),
-                  MOVE_GET(move, CAPTURED));
-        add_piece(board, MOVE_GET(move, SOURCE), MOVE_GET(move, PIECE));
-        break;
-
-    case CASTLING_MOVE_KINGSIDE:
-        {
-            /* We have to move the rook as well. */
-            int rook = ROOK + board->current_player;
-
-            /* Remove the phantom kings. */
-            if (!board->current_player)
-            {
-                board->bitboard[WHITE_KING] ^= WHITE_PHANTOM_KINGSIDE;
-                board->bitboard[WHITE_ALL] ^= WHITE_PHANTOM_KINGSIDE;
-
-                /* Put back the rook. */
-                board->bitboard[WHITE_ALL] |= board->bitboard[WHITE_ROOK];
-                board->castle_flags ^= WHITE_HAS_CASTLED
-                                       | WHITE_PHANTOM_KINGS_KINGSIDE;
-            }
-            else
-            {
-                board->bitboard[BLACK_KING] ^= BLACK_PHANTOM_KINGSIDE;
-                board->bitboard[BLACK_ALL] ^= BLACK_PHANTOM_KINGSIDE;
-
-                /* Put back the rook. */
-                board->bitboard[BLACK_ALL] |= board->bitboard[BLACK_ROOK];
-                board->castle_flags ^= BLACK_HAS_CASTLED
-                                       | BLACK_PHANTOM_KINGS_KINGSIDE;
-            }
-
-            remove_piece(board, MOVE_GET(move, DEST) - 1, rook);
-            add_piece(board, MOVE_GET(move, DEST) + 1, rook);
-            remove_piece(board, MOVE_GET(move, DEST), MOVE_GET(move, PIECE));
-            add_piece(board, MOVE_GET(move, SOURCE), MOVE_GET(move, PIECE));
-
-            break;
-        }
-    case CASTLING_MOVE_QUEENSIDE:
-        {
-            /* We have to move the rook as well. */
-            int rook = ROOK + board->current_player;
-
-            /* Remove the phantom kings. */
-            if (!board->current_player)
-            {
-                board->bitboard[WHITE_KING] ^= WHITE_PHANTOM_QUEENSIDE;
-                board->bitboard[WHITE_ALL] ^= WHITE_PHANTOM_QUEENSIDE;
-
-                /* Put back the rook. */
-                board->bitboard[WHITE_ALL] |= board->bitboard[WHITE_ROOK];
-                board->castle_flags ^= WHITE_HAS_CASTLED
-                                       | WHITE_PHANTOM_KINGS_QUEENSIDE;
-            }
-            else
-            {
-                board->bitboard[BLACK_KING] ^= BLACK_PHANTOM_QUEENSIDE;
-                board->bitboard[BLACK_ALL] ^= BLACK_PHANTOM_QUEENSIDE;
-
-                /* Put back the rook. */
-                board->bitboard[BLACK_ALL] |= board->bitboard[BLACK_ROOK];
-                board->castle_flags ^= BLACK_HAS_CASTLED
-                                       | BLACK_PHANTOM_KINGS_QUEENSIDE;
-            }
-
-            remove_piece(board, MOVE_GET(move, DEST) + 1, rook);
-            add_piece(board, MOVE_GET(move, DEST) - 2, rook);
-            remove_piece(board, MOVE_GET(move, DEST), MOVE_GET(move, PIECE));
-            add_piece(board, MOVE_GET(move, SOURCE), MOVE_GET(move, PIECE));
-
-            break;
-        }
-    case RESIGN_MOVE:
-        /* Resign or checkmate, do nothing. */
-        return;
-    case STALEMATE_MOVE:
-        /* Stalemate, do nothing. */
-        return;
-    }
-
-    /* Restore en passant possibility. */
-    if (board->en_passant || old_en_passant)
-    {
-        int square;
-        for (square = 0; square < 64; square++)
-        {
-            if (board->en_passant & square_bit[square])
-                board->hash_key ^= ep_hash[square];
-            if (old_en_passant & square_bit[square])
-                board->hash_key ^= ep_hash[square];
-        }
-        board->en_passant = old_en_passant;
-    }
-
-    castle_diff = board->castle_flags ^ old_castle_flags;
-
-    /* Restore phantom kings. */
-    switch ((castle_diff & PHANTOM_FLAGS) & old_castle_flags)
-    {
-    case WHITE_PHANTOM_KINGS_KINGSIDE:
-        board->castle_flags |= WHITE_PHANTOM_KINGS_KINGSIDE;
-        board->bitboard[WHITE_KING] |= WHITE_PHANTOM_KINGSIDE;
-        board->bitboard[WHITE_ALL] |= WHITE_PHANTOM_KINGSIDE;
-        break;
-
-    case WHITE_PHANTOM_KINGS_QUEENSIDE:
-        board->castle_flags |= WHITE_PHANTOM_KINGS_QUEENSIDE;
-        board->bitboard[WHITE_KING] |= WHITE_PHANTOM_QUEENSIDE;
-        board->bitboard[WHITE_ALL] |= WHITE_PHANTOM_QUEENSIDE;
-        break;
-
-    case BLACK_PHANTOM_KINGS_KINGSIDE:
-        board->castle_flags |= BLACK_PHANTOM_KINGS_KINGSIDE;
-        board->bitboard[BLACK_KING] |= BLACK_PHANTOM_KINGSIDE;
-        board->bitboard[BLACK_ALL] |= BLACK_PHANTOM_KINGSIDE;
-        break;
-
-    case BLACK_PHANTOM_KINGS_QUEENSIDE:
-        board->castle_flags |= BLACK_PHANTOM_KINGS_QUEENSIDE;
-        board->bitboard[BLACK_KING] |= BLACK_PHANTOM_QUEENSIDE;
-        board->bitboard[BLACK_ALL] |= BLACK_PHANTOM_QUEENSIDE;
-        break;
-    }
+    undo->board = *board;
+    undo->move = move;
+    execute_move(board, move);
+}
 
-    /* Restore castle flags. */
-    if (castle_diff & 15)
-    {
-        int i;
-        for (i = 0; i < 4; i++)
-            if (castle_diff & (1 << i))
-                board->hash_key ^= castle_hash[i];
-        board->castle_flags = old_castle_flags;
-    }
-    board->fifty_moves = old_fifty_moves;
+void board_unmake(board_t *board, board_undo_t *undo)
+{
+    *board = undo->board;
 }
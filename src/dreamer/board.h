@@ -208,6 +208,18 @@ typedef struct board
 board_t;
 
 typedef int move_t;
+
+/* What it takes to take back a move. Callers keep one for every move they
+** have made, normally as a local of the ply that makes it. The board is
+** small enough that copying it is faster than undoing the move piece by
+** piece.
+*/
+typedef struct
+{
+    board_t board;
+    move_t move;
+}
+board_undo_t;
 #if 0
 /* Structure describing a move on the board. */
 typedef struct move
@@ -276,26 +288,49 @@ setup_board(board_t *board);
 ** Returns   : (void)
 */
 
+void
+board_add_piece(board_t *board, int square, int piece);
+/* Puts a piece on an empty square. The hash key is updated, but it's only
+** valid once the castling, en-passant and side to move flags are set.
+** Parameters: (board_t *) board: The board.
+**             (int) square: The square.
+**             (int) piece: The piece.
+** Returns   : (void)
+*/
+
+bitboard_t
+board_king(board_t *board, int side);
+/* Returns the king of a side, without the phantom kings that stand on the
+** squares it crossed when it has just castled.
+** Parameters: (board_t *) board: The board.
+**             (int) side: SIDE_WHITE or SIDE_BLACK.
+** Returns   : (bitboard_t) The square of the king.
+*/
+
 void
 execute_move(board_t *board, move_t move);
-/* Makes a move on a board.
+/* Makes a move on a board for good. Use board_make() for a move that is
+** to be taken back.
 ** Parameters: (board_t *) board: Board to make the move on.
 **             (move_t) move: The move to make.
 ** Returns   : (void)
 */
 
 void
-unmake_move(board_t *board, move_t move, bitboard_t old_en_passant,
-            int old_castle_flags, int old_fifty_moves);
-/* Unmakes a move on a board.
-** Parameters: (board_t *) board: Board to unmake the move on.
-**             (move_t) move: The move to unmake.
-**             (bitboard_t) old_en_passant: The en-passant flags before the
-**                 last move.
-**             (int) old_castle_flags: The castling flags before the last
-**                 move.
-**             (int) old_fifty_moves: The 50 moves value before the last
-**                 move.
+board_make(board_t *board, move_t move, board_undo_t *undo);
+/* Makes a move on a board, so that it can be taken back.
+** Parameters: (board_t *) board: The board.
+**             (move_t) move: The move to make.
+**             (board_undo_t *) undo: Receives what board_unmake() needs.
+** Returns   : (void)
+*/
+
+void
+board_unmake(board_t *board, board_undo_t *undo);
+/* Takes back a move made with board_make(). Moves must be taken back in
+** the reverse order of making them.
+** Parameters: (board_t *) board: The board.
+**             (board_undo_t *) undo: Filled in when the move was made.
 ** Returns   : (void)
 */
 
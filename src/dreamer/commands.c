@@ -35,6 +35,11 @@
 #include "search.h"
 #include "san.h"
 #include "timer.h"
+#include "uci.h"
+#include "bench.h"
+#include "perft.h"
+#include "stats.h"
+#include "syzygy.h"
 
 static int is_coord_move(char *ms)
 {
@@ -111,9 +116,7 @@ static move_t get_san_move(board_t *board, int ply, san_move_t *san)
 {
     move_t move;
     int piece;
-    bitboard_t en_passant = board->en_passant;
-    int castle_flags = board->castle_flags;
-    int fifty_moves = board->fifty_moves;
+    board_undo_t undo;
     int found = 0;
     move_t found_move;
 
@@ -137,7 +140,7 @@ static move_t get_san_move(board_t *board, int ply, san_move_t *san)
     compute_legal_moves(board, ply);
 
     /* Look for move in list. */
-    while ((move = move_next(board, ply)) != NO_MOVE)
+    while ((move = move_next(board, ply, NULL)) != NO_MOVE)
     {
         int move_piece;
 
@@ -180,16 +183,15 @@ static move_t get_san_move(board_t *board, int ply, san_move_t *san)
 
         /* TODO verify check and checkmate flags? */
 
-        execute_move(board, move);
+        board_make(board, move, &undo);
         board->current_player = OPPONENT(board->current_player);
         if (!is_check(board, ply + 1))
         {
             found++;
             found_move = move;
         }
- 
-        board->current_player = OPPONENT(board->current_player);
-        unmake_move(board, move, en_passant, castle_flags, fifty_moves);
+
+        board_unmake(board, &undo);
     }
 
     if (found != 1)
@@ -209,25 +211,21 @@ static move_t get_coord_move(board_t *board, int ply, char *ms)
     compute_legal_moves(board, ply);
 
     /* Look for move in list. */
-    while ((move = move_next(board, ply)) != NO_MOVE)
+    while ((move = move_next(board, ply, NULL)) != NO_MOVE)
     {
         if ((MOVE_GET(move, SOURCE) == source) && (MOVE_GET(move, DEST) == dest))
         {
-            bitboard_t en_passant = board->en_passant;
-            int castle_flags = board->castle_flags;
-            int fifty_moves = board->fifty_moves;
+            board_undo_t undo;
 
             /* Move found. */
-            execute_move(board, move);
+            board_make(board, move, &undo);
             board->current_player = OPPONENT(board->current_player);
             if (!is_check(board, ply + 1))
             {
-                board->current_player = OPPONENT(board->current_player);
-                unmake_move(board, move, en_passant, castle_flags, fifty_moves);
+                board_unmake(board, &undo);
                 break;
             }
-            board->current_player = OPPONENT(board->current_player);
-            unmake_move(board, move, en_passant, castle_flags, fifty_moves);
+            board_unmake(board, &undo);
         }
     }
     if (move != NO_MOVE)
@@ -297,13 +295,11 @@ char *san_move_str(board_t *board, int ply, move_t move)
     san_move_t san_move;
     int state;
     int move_piece;
-    bitboard_t en_passant = board->en_passant;
-    int castle_flags = board->castle_flags;
-    int fifty_moves = board->fifty_moves;
+    board_undo_t undo;
 
-    execute_move(board, move);
+    board_make(board, move, &undo);
     state = check_game_state(board, ply);
-    unmake_move(board, move, en_passant, castle_flags, fifty_moves);
+    board_unmake(board, &undo);
 
     switch (state)
     {
@@ -317,7 +313,7 @@ char *san_move_str(board_t *board, int ply, move_t move)
         san_move.state = SAN_STATE_NORMAL;
     }
 
-    switch (MOVE_GET(move, TYPE))
+    switch (MOVE_GET(move, TYPE) & MOVE_NO_PROMOTION_MASK)
     {
     case CASTLING_MOVE_QUEENSIDE:
         san_move.type = SAN_QUEENSIDE_CASTLE;
@@ -340,10 +336,23 @@ char *san_move_str(board_t *board, int ply, move_t move)
 
     san_move.piece = san_piece(move_piece);
 
-    if (MOVE_GET(move, TYPE) & MOVE_PROMOTION_MASK)
-        san_move.promotion_piece = san_piece(MOVE_GET(move, CAPTURED) & PIECE_MASK);
-    else
+    switch (move & MOVE_PROMOTION_MASK)
+    {
+    case PROMOTION_MOVE_QUEEN:
+        san_move.promotion_piece = SAN_QUEEN;
+        break;
+    case PROMOTION_MOVE_ROOK:
+        san_move.promotion_piece = SAN_ROOK;
+        break;
+    case PROMOTION_MOVE_BISHOP:
+        san_move.promotion_piece = SAN_BISHOP;
+        break;
+    case PROMOTION_MOVE_KNIGHT:
+        san_move.promotion_piece = SAN_KNIGHT;
+        break;
+    default:
         san_move.promotion_piece = SAN_NOT_SPECIFIED;
+    }
 
     san_move.source_file = SAN_NOT_SPECIFIED;
     san_move.source_rank = SAN_NOT_SPECIFIED;
@@ -431,7 +440,8 @@ static int parse_time_control(state_t *state, char *s)
             return 1;
     }
 
-    t.inc = strtol(end + 1, &end, 10) * 100;
+    /* Fast games have increments of a fraction of a second. */
+    t.inc = (int)(strtod(end + 1, &end) * 100 + 0.5);
 
     if (errno || *end != 0)
         return 1;
@@ -440,6 +450,7 @@ static int parse_time_control(state_t *state, char *s)
     if (t.mps != 0 && t.inc != 0)
         return 1;
 
+    t.fixed = 0;
     state->time = t;
     timer_set(&state->engine_time, t.base);
     return 0;
@@ -499,6 +510,15 @@ int parse_move(board_t *board, int ply, char *command, move_t *move)
     return 1;
 }
 
+int parse_coord_move(board_t *board, int ply, char *command, move_t *move)
+{
+    if (!is_coord_move(command))
+        return 1;
+
+    *move = get_coord_move(board, ply, command);
+    return 0;
+}
+
 int command_usermove(state_t *state, char *command)
 {
     move_t move;
@@ -520,7 +540,10 @@ int command_usermove(state_t *state, char *command)
 		timer_start(&state->engine_time);
 
         do_move(state, move);
-        check_game_end(state);
+
+        /* There's no game to end while analyzing. */
+        if (state->mode != MODE_ANALYZE)
+            check_game_end(state);
 
         if (state->mode == MODE_IDLE)
             state->mode = (state->board.current_player == SIDE_WHITE?
@@ -543,8 +566,42 @@ int command_usermove(state_t *state, char *command)
     return 1;
 }
 
+void command_new(state_t *state)
+{
+    setup_board(&state->board);
+    forget_history();
+    clear_table();
+    pv_clear();
+    repetition_init(&state->board);
+    state->done = 0;
+    state->mode = MODE_BLACK;
+    state->flags = 0;
+    state->depth = MAX_DEPTH;
+    state->nodes = 0;
+
+    if (state->undo_data != NULL)
+        free(state->undo_data);
+    state->undo_data = NULL;
+
+    state->moves = 0;
+    timer_init(&state->engine_time, 1);
+    timer_set(&state->engine_time, state->time.base * 60 * 100);
+    timer_init(&state->move_time, 1);
+
+    state->hint = NO_MOVE;
+    state->ponder_opp_move = NO_MOVE;
+    state->ponder_my_move = NO_MOVE;
+    state->ponder_actual_move = NO_MOVE;
+}
+
 void command_handle(state_t *state, char *command)
 {
+    if (state->protocol == PROTOCOL_UCI)
+    {
+        uci_handle(state, command);
+        return;
+    }
+
     if (command_always(state, command))
         return;
 
@@ -554,6 +611,13 @@ void command_handle(state_t *state, char *command)
         return;
     }
 
+    if (!strcmp(command, "uci"))
+    {
+        state->protocol = PROTOCOL_UCI;
+        uci_handle(state, command);
+        return;
+    }
+
     if (!strncmp(command, "protover ", 9))
     {
         char *endptr;
@@ -566,6 +630,12 @@ void command_handle(state_t *state, char *command)
         e_comm_send("feature myname=\"Dreamer v" PACKAGE_VERSION " (" GIT_REV ")\"\n");
         e_comm_send("feature setboard=1\n");
         e_comm_send("feature colors=0\n");
+        e_comm_send("feature option=\"MultiPV -spin 1 1 %i\"\n", MULTIPV_MAX);
+#ifdef HAVE_SYZYGY
+        e_comm_send("feature egt=\"syzygy\"\n");
+        e_comm_send("feature option=\"SyzygyProbeLimit -spin %i 0 7\"\n",
+                    SYZYGY_DEFAULT_LIMIT);
+#endif /* HAVE_SYZYGY */
         e_comm_send("feature done=1\n");
         return;
     }
@@ -578,10 +648,75 @@ void command_handle(state_t *state, char *command)
         return;
     }
 
+    if (!strncmp(command, "st ", 3))
+    {
+        int val;
+        char *end;
+        errno = 0;
+        val = strtol(command + 3, &end, 10);
+        if (errno || *end != 0 || val < 0)
+            BADPARAM(command);
+        else
+            /* "st 0" turns the clock off, for reproducible searches that
+            ** are limited by "sd" or "nodes" only.
+            */
+            state->time.fixed = (val > 0 ? val * 100 : TIME_NO_CLOCK);
+        return;
+    }
+
+    if (!strncmp(command, "nodes ", 6))
+    {
+        int val;
+        char *end;
+        errno = 0;
+        val = strtol(command + 6, &end, 10);
+        if (errno || *end != 0 || val < 0)
+            BADPARAM(command);
+        else
+            state->nodes = val;
+        return;
+    }
+
+    if (!strncmp(command, "option MultiPV=", 15))
+    {
+        int val;
+        char *end;
+        errno = 0;
+        val = strtol(command + 15, &end, 10);
+        if (errno || *end != 0 || val < 1 || val > MULTIPV_MAX)
+            BADPARAM(command);
+        else
+            state->multipv = val;
+        return;
+    }
+
+    if (!strncmp(command, "option SyzygyProbeLimit=", 24))
+    {
+        int val;
+        char *end;
+        errno = 0;
+        val = strtol(command + 24, &end, 10);
+        if (errno || *end != 0 || val < 0 || val > 7)
+            BADPARAM(command);
+        else
+            syzygy_set_limit(val);
+        return;
+    }
+
+    if (!strncmp(command, "egtpath syzygy ", 15))
+    {
+        if (syzygy_init(command + 15) == 0)
+            e_comm_send("tellusererror No tablebases found in %s\n",
+                        command + 15);
+        return;
+    }
+
     if (!strncmp(command, "accepted ", 9))
     {
         if (!strcmp(command + 9, "setboard") || !strcmp(command + 9, "done")
-            || !strcmp(command + 9, "myname") || !strcmp(command + 9, "colors"))
+            || !strcmp(command + 9, "myname") || !strcmp(command + 9, "colors")
+            || !strcmp(command + 9, "option")
+            || !strcmp(command + 9, "egt"))
             return;
 
         BADPARAM(command);
@@ -590,29 +725,7 @@ void command_handle(state_t *state, char *command)
 
     if (!strcmp(command, "new"))
     {
-        setup_board(&state->board);
-        forget_history();
-        clear_table();
-        pv_clear();
-        repetition_init(&state->board);
-        state->done = 0;
-        state->mode = MODE_BLACK;
-        state->flags = 0;
-        state->depth = MAX_DEPTH;
-
-	if (state->undo_data != NULL)
-		free(state->undo_data);
-	state->undo_data = NULL;
-
-	state->moves = 0;
-	timer_init(&state->engine_time, 1);
-	timer_set(&state->engine_time, state->time.base * 60 * 100);
-	timer_init(&state->move_time, 1);
-
-        state->hint = NO_MOVE;
-        state->ponder_opp_move = NO_MOVE;
-        state->ponder_my_move = NO_MOVE;
-        state->ponder_actual_move = NO_MOVE;
+        command_new(state);
         return;
     }
 
@@ -628,6 +741,60 @@ void command_handle(state_t *state, char *command)
         return;
     }
 
+    if (!strcmp(command, "analyze"))
+    {
+        state->mode = MODE_ANALYZE;
+        return;
+    }
+
+    if (!strcmp(command, "exit"))
+    {
+        if (state->mode != MODE_ANALYZE)
+        {
+            NOT_NOW(command);
+            return;
+        }
+
+        state->mode = MODE_FORCE;
+        return;
+    }
+
+    if (!strcmp(command, "."))
+    {
+        if (state->mode != MODE_ANALYZE)
+        {
+            NOT_NOW(command);
+            return;
+        }
+
+        search_status();
+        return;
+    }
+
+    if (!strcmp(command, "bench") || !strncmp(command, "bench ", 6))
+    {
+        bench_command(state, command + 5);
+        return;
+    }
+
+    if (!strcmp(command, "stats"))
+    {
+        stats_print();
+        return;
+    }
+
+    if (!strncmp(command, "perft ", 6))
+    {
+        perft_command(&state->board, command + 5, 0);
+        return;
+    }
+
+    if (!strncmp(command, "divide ", 7))
+    {
+        perft_command(&state->board, command + 6, 1);
+        return;
+    }
+
     if (!strcmp(command, "white"))
     {
         if (state->board.current_player != SIDE_WHITE)
@@ -729,6 +896,20 @@ void command_handle(state_t *state, char *command)
         return;
     }
 
+    if (!strcmp(command, "undo"))
+    {
+        if ((state->mode != MODE_FORCE && state->mode != MODE_ANALYZE)
+            || state->moves < 1)
+        {
+            NOT_NOW(command);
+            return;
+        }
+
+        undo_move(state);
+        state->done = 0;
+        return;
+    }
+
     if (!strcmp(command, "?"))
     {
         NOT_NOW(command);
@@ -739,7 +920,7 @@ void command_handle(state_t *state, char *command)
     {
         board_t board;
 
-        if (state->mode != MODE_FORCE)
+        if (state->mode != MODE_FORCE && state->mode != MODE_ANALYZE)
         {
             NOT_NOW(command);
             return;
@@ -751,9 +932,12 @@ void command_handle(state_t *state, char *command)
             return;
         }
 
+        /* The transposition table is kept, as it's likely that the new
+        ** position is related to the old one.
+        */
         state->board = board;
+        state->moves = 0;
         forget_history();
-        clear_table();
         repetition_init(&state->board);
         state->done = 0;
         return;
@@ -799,6 +983,9 @@ void command_handle(state_t *state, char *command)
 
 int command_check_abort(state_t *state, int ply, char *command)
 {
+    if (state->protocol == PROTOCOL_UCI)
+        return uci_check_abort(state, command);
+
     if (!strcmp(command, "?"))
     {
         if (my_turn(state))
@@ -808,6 +995,21 @@ int command_check_abort(state_t *state, int ply, char *command)
     if (command_always(state, command))
         return 0;
 
+    if (state->mode == MODE_ANALYZE)
+    {
+        if (!strcmp(command, "."))
+        {
+            search_status();
+            return 0;
+        }
+
+        /* Anything else may change the position, so stop analyzing and
+        ** let the main loop handle it.
+        */
+        state->flags = FLAG_IGNORE_MOVE;
+        return COMMAND_DEFER;
+    }
+
     if (!strcmp(command, "new"))
     {
         state->flags = FLAG_NEW_GAME | FLAG_IGNORE_MOVE;
@@ -859,8 +1061,12 @@ int command_check_abort(state_t *state, int ply, char *command)
 
             if (move == state->ponder_opp_move)
             {
-                /* User made the expected move. */
+                /* User made the expected move, derive a time budget from
+                ** the clock as it is now and keep searching.
+                */
                 state->flags = 0;
+                set_move_time();
+                search_ponder_hit(state, timer_get(&state->move_time));
                 return 0;
             }
             else
@@ -23,6 +23,12 @@
 
 #include "dreamer.h"
 
+/* Return value of command_check_abort() for commands that end the search
+** and must be handled once it has unwound.
+*/
+#define COMMAND_DEFER 2
+
+void command_new(state_t *state);
 void command_handle(state_t *state, char *command);
 int command_check_abort(state_t *state, int ply, char *command);
 int command_usermove(state_t *state, char *command);
@@ -32,4 +38,9 @@ char *coord_move_str(move_t move);
 
 int parse_move(board_t *board, int ply, char *command, move_t *move);
 
+/* Like parse_move(), but only accepts coordinate notation. Unlike the SAN
+** parser this can be used by several threads at once.
+*/
+int parse_coord_move(board_t *board, int ply, char *command, move_t *move);
+
 #endif /* COMMANDS_H */
@@ -25,12 +25,16 @@
 #include <sys/types.h>
 
 #include "dreamer.h"
+#include "attack.h"
 #include "board.h"
 #include "move.h"
 #include "search.h"
 #include "hashing.h"
 #include "e_comm.h"
 #include "commands.h"
+#include "bench.h"
+#include "perft.h"
+#include "suite.h"
 #include "repetition.h"
 #include "transposition.h"
 
@@ -38,34 +42,31 @@
 #include "config.h"
 #endif
 
-#ifdef __WIN32__
-
-#include <windows.h>
-#define drm_sleep(M) Sleep(M)
-
-#elif defined __BEOS__
-
-#define drm_sleep(M) snooze((M) * 1000)
-
-#elif defined HAVE_USLEEP
+static int start_time;
+static state_t state;
 
-#define drm_sleep(M) usleep((M) * 1000)
+/* Command that ended the search, to be handled by the main loop. */
+static char *deferred;
 
-#else
+/* Hash key of the position that was analyzed to the end in analyze mode,
+** so that it isn't searched again until something changes.
+*/
+static int analyzed;
+static long long analyzed_key;
 
-static void drm_sleep(unsigned long usec)
+/* Returns whether the engine has nothing to do until the next command comes
+** in.
+*/
+static int is_idle(state_t *state)
 {
-    struct timeval tv;
-
-    tv.tv_sec = 0;
-    tv.tv_usec = usec;
-    select(0, 0, 0, 0, &tv);
-}
+    if (state->mode == MODE_ANALYZE)
+        return analyzed && state->board.hash_key == analyzed_key;
 
-#endif
+    if (state->mode == MODE_IDLE || state->mode == MODE_FORCE || state->done)
+        return 1;
 
-static int start_time;
-static state_t state;
+    return !my_turn(state) && !(state->flags & FLAG_PONDER);
+}
 
 int my_turn(state_t *state)
 {
@@ -77,16 +78,7 @@ int my_turn(state_t *state)
 
 int is_check(board_t *board, int ply)
 {
-    /* FIXME */
-    board->current_player = OPPONENT(board->current_player);
-    if (compute_legal_moves(board, ply) < 0)
-    {
-        /* We're in check. */
-        board->current_player = OPPONENT(board->current_player);
-        return 1;
-    }
-    board->current_player = OPPONENT(board->current_player);
-    return 0;
+    return attack_in_check(board, NULL, board->current_player);
 }
 
 int check_game_state(board_t *board, int ply)
@@ -95,23 +87,19 @@ int check_game_state(board_t *board, int ply)
     int mate = STATE_MATE;
     compute_legal_moves(board, ply);
 
-    while ((move = move_next(board, ply)) != NO_MOVE)
+    while ((move = move_next(board, ply, NULL)) != NO_MOVE)
     {
-        bitboard_t en_passant = board->en_passant;
-        int castle_flags = board->castle_flags;
-        int fifty_moves = board->fifty_moves;
+        board_undo_t undo;
 
-        execute_move(board, move);
+        board_make(board, move, &undo);
         board->current_player = OPPONENT(board->current_player);
         if (!is_check(board, ply + 1))
         {
             mate = STATE_NORMAL;
-            board->current_player = OPPONENT(board->current_player);
-            unmake_move(board, move, en_passant, castle_flags, fifty_moves);
+            board_unmake(board, &undo);
             break;
         }
-        board->current_player = OPPONENT(board->current_player);
-        unmake_move(board, move, en_passant, castle_flags, fifty_moves);
+        board_unmake(board, &undo);
     }
     /* We're either stalemated or checkmated. */
     if (!is_check(board, ply) && (mate == STATE_MATE))
@@ -166,33 +154,42 @@ void check_game_end(state_t *state)
 
 }
 
-int check_abort(int ply)
+int check_time(state_t *state)
+{
+    return !(state->flags & (FLAG_PONDER | FLAG_INFINITE))
+           && (timer_get(&state->move_time) <= 0);
+}
+
+int check_input(int ply)
 {
     char *s;
 
-    if (!(state.flags & FLAG_PONDER) && (timer_get(&state.move_time) <= 0))
-        return 1;
+    while ((s = e_comm_poll()))
+    {
+        int abort = command_check_abort(&state, ply, s);
+
+        if (abort == COMMAND_DEFER)
+        {
+            deferred = s;
+            return 1;
+        }
+
+        free(s);
+
+        /* Leave any remaining input for the main loop. */
+        if (abort)
+            return 1;
+    }
 
-    s = e_comm_poll();
-    if (!s)
-        return 0;
-    return command_check_abort(&state, ply, s);
+    return 0;
 }
 
 void do_move(state_t *state, move_t move)
 {
     state->moves++;
     state->undo_data = realloc(state->undo_data,
-                               sizeof(undo_data_t) * state->moves);
-    state->undo_data[state->moves - 1].en_passant =
-        state->board.en_passant;
-    state->undo_data[state->moves - 1].castle_flags =
-        state->board.castle_flags;
-    state->undo_data[state->moves - 1].fifty_moves =
-        state->board.fifty_moves;
-    state->undo_data[state->moves - 1].move =
-        move;
-    execute_move(&state->board, move);
+                               sizeof(board_undo_t) * state->moves);
+    board_make(&state->board, move, &state->undo_data[state->moves - 1]);
     repetition_add(&state->board, move);
 }
 
@@ -203,16 +200,32 @@ void undo_move(state_t *state)
 
     state->moves--;
 
-    unmake_move(&state->board,
-                state->undo_data[state->moves].move,
-                state->undo_data[state->moves].en_passant,
-                state->undo_data[state->moves].castle_flags,
-                state->undo_data[state->moves].fifty_moves);
+    board_unmake(&state->board, &state->undo_data[state->moves]);
 
     repetition_remove();
 }
 
-static void set_start_time(void)
+/* Rebuilds the repetition history of the current thread from the game in
+** state.
+*/
+void restore_repetition(state_t *state)
+{
+    board_t board = state->board;
+    int i;
+
+    for (i = state->moves - 1; i >= 0; i--)
+        board_unmake(&board, &state->undo_data[i]);
+
+    repetition_init(&board);
+
+    for (i = 0; i < state->moves; i++)
+    {
+        execute_move(&board, state->undo_data[i].move);
+        repetition_add(&board, state->undo_data[i].move);
+    }
+}
+
+void set_start_time(void)
 {
     struct timeval tv;
 
@@ -227,6 +240,18 @@ void set_move_time(void)
 
     timer_init(&state.move_time, 1);
 
+    if (state.time.fixed == TIME_NO_CLOCK)
+    {
+        state.flags |= FLAG_INFINITE;
+        return;
+    }
+
+    if (state.time.fixed > 0)
+    {
+        timer_set(&state.move_time, state.time.fixed);
+        return;
+    }
+
     if (safe_time > 0)
     {
         if (state.time.mps == 0)
@@ -279,35 +304,116 @@ void send_move(state_t *state, move_t move)
     check_game_end(state);
 }
 
-int engine(void *data)
+static void init_state(void)
 {
-    e_comm_init();
     set_start_time();
 
+    /* Size the move lists of this thread for a search of the default
+    ** depth up front.
+    */
+    move_stack_init(MAX_DEPTH + QUIESCE_PLIES);
+
     state.time.mps = 40;
     state.time.base = 5;
     state.time.inc = 0;
+    state.time.fixed = 0;
+    state.multipv = 1;
     set_option(OPTION_QUIESCE, 1);
     set_option(OPTION_PONDER, 0);
     set_option(OPTION_POST, 0);
 
     command_handle(&state, "new");
+}
+
+int engine_bench(int depth, int threads, int hash)
+{
+    e_comm_init(0);
+    init_state();
+    bench(&state, depth, threads, hash);
+    e_comm_exit();
+    transposition_exit();
+    return 0;
+}
+
+int engine_perft(char *filename, int depth, int threads, int hash)
+{
+    int retval;
+
+    e_comm_init(0);
+    retval = perft_epd(filename, depth, threads, hash);
+    e_comm_exit();
+    return retval;
+}
+
+int engine_epd(char *filename, int msec, int workers)
+{
+    int retval;
+
+    e_comm_init(0);
+    init_state();
+    retval = epd_suite(&state, filename, msec, workers);
+    e_comm_exit();
+    transposition_exit();
+    return retval;
+}
+
+/* Searches the current position until the search completes or is
+** interrupted by a command.
+*/
+static void analyze(state_t *state)
+{
+    int depth = state->depth;
+    int nodes = state->nodes;
+
+    state->flags = FLAG_INFINITE;
+    state->depth = MAX_DEPTH;
+    state->nodes = 0;
+
+    find_best_move(state);
+
+    state->depth = depth;
+    state->nodes = nodes;
+
+    analyzed = !(state->flags & FLAG_IGNORE_MOVE);
+    analyzed_key = state->board.hash_key;
+    state->flags = 0;
+}
+
+int engine(void *data)
+{
+    e_comm_init(1);
+    init_state();
 
     while (state.mode != MODE_QUIT)
     {
         char *s;
         move_t move;
 
-        s = e_comm_poll();
-
-        if (!s)
-            drm_sleep(10);
+        if (deferred)
+        {
+            s = deferred;
+            deferred = NULL;
+        }
+        else if (is_idle(&state))
+            s = e_comm_wait();
         else
+            s = e_comm_poll();
+
+        if (s)
         {
             command_handle(&state, s);
             free(s);
         }
 
+        if (state.mode == MODE_ANALYZE)
+        {
+            if (!is_idle(&state))
+                analyze(&state);
+            continue;
+        }
+
+        analyzed = 0;
+
         if (state.mode != MODE_IDLE && state.mode != MODE_FORCE && !state.done)
         {
             if (my_turn(&state))
@@ -359,6 +465,8 @@ int engine(void *data)
         }
     }
 
+    e_comm_flush();
     transposition_exit();
+    move_stack_exit();
     return 0;
 }
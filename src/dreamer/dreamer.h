@@ -29,39 +29,74 @@
 #define MODE_IDLE 2
 #define MODE_FORCE 3
 #define MODE_QUIT 4
+#define MODE_ANALYZE 5
 
 #define FLAG_IGNORE_MOVE (1<<0)
 #define FLAG_NEW_GAME (1<<1)
 #define FLAG_PONDER (1<<2)
 #define FLAG_DELAY_MOVE (1<<2)
+#define FLAG_INFINITE (1<<3)
 
-#define MAX_DEPTH 30
+/* Default and maximum search depth for the protocols. The search itself
+** sizes its ply stack at runtime.
+*/
+#define MAX_DEPTH 64
+
+/* Storage class of per-thread search data. */
+#if defined(__GNUC__)
+#define THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL
+#endif
+
+#define PROTOCOL_XBOARD 0
+#define PROTOCOL_UCI 1
+#define PROTOCOL_LIBRARY 2 /* Engine instance, see instance.h. */
 
-typedef struct
+/* Value of time_control.fixed to search without a clock, until the depth
+** or node limit is reached.
+*/
+#define TIME_NO_CLOCK -1
+
+/* Thinking output of a search for library instances. */
+typedef struct search_info
 {
-    bitboard_t en_passant;
-    int castle_flags;
-    int fifty_moves;
-    move_t move;
+    int depth;      /* Depth of the iteration. */
+    int sel_depth;  /* Highest ply reached, including quiescence search. */
+    int rank;       /* Rank of the line in MultiPV mode, 0 for the best. */
+    int score;      /* Score for the side to move, see search.h. */
+    int nodes;
+    int tb_hits;    /* Positions found in the endgame tablebases. */
+    int msec;
+    int len;        /* Number of moves in pv. */
+    move_t *pv;
 }
-undo_data_t;
+search_info_t;
+
+typedef void (*search_info_fn)(void *data, search_info_t *info);
 
 struct time_control
 {
     int mps;
     int base;
     int inc;
+    int fixed; /* Fixed time per move, or 0 for none. */
 };
 
 typedef struct state
 {
     int done;
+    int protocol;
     int mode;
     int flags;
     int depth;
+    int nodes;
+    int multipv; /* Number of best lines to search for. */
     board_t board;
     board_t root_board;
-    undo_data_t *undo_data;
+    board_undo_t *undo_data;
     int moves;
     int options;
     struct time_control time;
@@ -71,6 +106,9 @@ typedef struct state
     move_t ponder_opp_move;
     move_t ponder_my_move;
     move_t ponder_actual_move;
+    int stop; /* Set by another thread to stop a library search. */
+    search_info_fn info; /* Receives the thinking output of a library search. */
+    void *info_data;
 }
 state_t;
 
@@ -86,16 +124,22 @@ int my_turn(state_t *state);
 #define OPTION_PONDER 2
 
 int engine(void *data);
+int engine_bench(int depth, int threads, int hash);
+int engine_perft(char *filename, int depth, int threads, int hash);
+int engine_epd(char *filename, int msec, int workers);
 int check_game_state(board_t *board, int ply);
 void check_game_end(state_t *state);
 void do_move(state_t *state, move_t move);
 void undo_move(state_t *state);
-int check_abort(int ply);
+int check_time(state_t *state);
+int check_input(int ply);
 int get_option(int option);
 void set_option(int option, int value);
 int get_time(void);
 int is_check(board_t *board, int ply);
 void send_move(state_t *state, move_t move);
 void set_move_time(void);
+void set_start_time(void);
+void restore_repetition(state_t *state);
 
 #endif /* DREAMER_H */
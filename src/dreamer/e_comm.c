@@ -21,36 +21,158 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
+#include <pthread.h>
 
 #include "e_comm.h"
+#include "msglist.h"
+
+/* Messages received by the input thread, waiting to be processed. */
+static msglist_t queue;
+static pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t input_thread;
+
+/* Set by the input thread when the queue is non-empty. The search only reads
+** this flag, so it never has to take the mutex or make a system call unless
+** there is something to do. It is stored with release and loaded with acquire
+** semantics, as it is read without the mutex.
+*/
+static int pending;
+
+/* Flush the output buffer when it grows beyond this size. */
+#define OUT_FLUSH_SIZE 4096
+
+/* Output buffer, it is reused for all messages. */
+static char *out;
+static int out_size;
+static int out_len;
+
+static void *input_loop(void *data)
+{
+    while (1)
+    {
+        char *s = e_comm_pipe_receive();
+        int quit = !strcmp(s, "quit");
+
+        pthread_mutex_lock(&queue_mutex);
+        msglist_add(&queue, s);
+        __atomic_store_n(&pending, 1, __ATOMIC_RELEASE);
+        pthread_cond_signal(&queue_cond);
+        pthread_mutex_unlock(&queue_mutex);
+
+        /* The ui will close the pipe after this, don't treat that as an
+        ** error.
+        */
+        if (quit)
+            return NULL;
+    }
+}
+
+void e_comm_init(int input)
+{
+    e_comm_pipe_init();
+    msglist_init(&queue);
+
+    out_size = OUT_FLUSH_SIZE * 2;
+    out = malloc(out_size);
+    out_len = 0;
+
+    if (!input)
+        return;
+
+    if (pthread_create(&input_thread, NULL, input_loop, NULL))
+    {
+        fprintf(stderr, "Failed to create input thread\n");
+        exit(1);
+    }
+
+    pthread_detach(input_thread);
+}
+
+void e_comm_exit(void)
+{
+    e_comm_flush();
+    e_comm_pipe_exit();
+    free(out);
+}
+
+char *e_comm_poll(void)
+{
+    char *s;
+
+    e_comm_flush();
+
+    if (!__atomic_load_n(&pending, __ATOMIC_ACQUIRE))
+        return NULL;
+
+    pthread_mutex_lock(&queue_mutex);
+    s = msglist_remove(&queue);
+    __atomic_store_n(&pending, msglist_poll(&queue), __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&queue_mutex);
+
+    return s;
+}
+
+char *e_comm_wait(void)
+{
+    char *s;
+
+    e_comm_flush();
+
+    pthread_mutex_lock(&queue_mutex);
+
+    while (!msglist_poll(&queue))
+        pthread_cond_wait(&queue_cond, &queue_mutex);
+
+    s = msglist_remove(&queue);
+    __atomic_store_n(&pending, msglist_poll(&queue), __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&queue_mutex);
+
+    return s;
+}
+
+int e_comm_pending(void)
+{
+    return __atomic_load_n(&pending, __ATOMIC_ACQUIRE);
+}
 
 void e_comm_send(const char *fmt, ...)
 {
-    /* Code adapted from example in PRINTF(3) */
-    /* Guess we need no more than 100 bytes. */
-    int n, size = 100;
-    char *p;
     va_list ap;
-    p = (char *)malloc(size);
+    int n;
+
     while (1)
     {
-        /* Try to print in the allocated space. */
+        /* Try to print in the space that is left. */
         va_start(ap, fmt);
-        n = vsnprintf(p, size, fmt, ap);
+        n = vsnprintf(out + out_len, out_size - out_len, fmt, ap);
         va_end(ap);
-        /* If that worked, return the string. */
-        if (n > -1 && n < size)
+
+        if (n > -1 && n < out_size - out_len)
             break;
+
         /* Else try again with more space. */
-        if (n > -1)
-            /* glibc 2.1, set size to precisely what's needed. */
-            size = n+1;
+        if (n > -1 && out_len + n + 1 > out_size * 2)
+            /* C99 vsnprintf, grow to precisely what's needed. */
+            out_size = out_len + n + 1;
         else
-            /* glibc 2.0, try with twice the old size. */
-            size *= 2;
-        p = realloc(p, size);
+            out_size *= 2;
+
+        out = realloc(out, out_size);
     }
 
-    e_comm_send_str(p);
-    free(p);
+    out_len += n;
+
+    if (out_len >= OUT_FLUSH_SIZE)
+        e_comm_flush();
+}
+
+void e_comm_flush(void)
+{
+    if (out_len == 0)
+        return;
+
+    e_comm_pipe_write(out, out_len);
+    out_len = 0;
 }
@@ -21,9 +21,10 @@
 #ifndef E_COMM_H
 #define E_COMM_H
 
-void e_comm_init(void);
+void e_comm_init(int input);
 /* Initializes the I/O library for communication with an xboard ui.
-** Parameters: (void)
+** Parameters: (int) input: 1 to read commands from the ui, 0 for modes
+**                 that only produce output.
 ** Returns   : (void)
 */
 
@@ -34,14 +35,16 @@ void e_comm_exit(void);
 */
 
 void e_comm_send(const char *fmt, ...);
-/* Sends a message to the xboard ui.
+/* Sends a message to the xboard ui. Messages are collected in an output
+** buffer and written out by e_comm_flush.
 ** Parameters: (char *) fmt, ...: Message to be sent.
 ** Returns   : (void)
 */
 
-void e_comm_send_str(const char *m);
-/* Sends a message to the xboard ui.
-** Parameters: (char *) m: Message to be sent.
+void e_comm_flush(void);
+/* Writes out all buffered messages. This is done automatically before
+** waiting for or polling for input.
+** Parameters: (void)
 ** Returns   : (void)
 */
 
@@ -53,4 +56,46 @@ char *e_comm_poll(void);
 **             NULL, otherwise.
 */
 
+char *e_comm_wait(void);
+/* Waits for input from the xboard ui.
+** Parameters: (void)
+** Returns   : (char *), Message that was received from the I/O library.
+*/
+
+int e_comm_pending(void);
+/* Checks whether there is input from the xboard ui waiting to be processed.
+** This is cheap enough to be called at every node of the search.
+** Parameters: (void)
+** Returns   : (int) 1 if input is waiting, 0 otherwise.
+*/
+
+/* The functions below are implemented by the platform specific backends. */
+
+void e_comm_pipe_init(void);
+/* Initializes the pipe to the xboard ui.
+** Parameters: (void)
+** Returns   : (void)
+*/
+
+void e_comm_pipe_exit(void);
+/* Closes the pipe to the xboard ui.
+** Parameters: (void)
+** Returns   : (void)
+*/
+
+void e_comm_pipe_write(const char *m, int len);
+/* Writes a block of messages to the xboard ui.
+** Parameters: (char *) m: Messages to be sent.
+**             (int) len: Length of the messages in bytes.
+** Returns   : (void)
+*/
+
+char *e_comm_pipe_receive(void);
+/* Waits for a message from the xboard ui. This is called from the input
+** thread only.
+** Parameters: (void)
+** Returns   : (char *) Message that was received. It stays valid until the
+**                 next call.
+*/
+
 #endif /* E_COMM_H */
@@ -32,7 +32,7 @@
 #include "e_comm.h"
 #include "pipe_unix.h"
 
-void e_comm_init(void)
+void e_comm_pipe_init(void)
 {
     /* xboard ui's may send SIGINT to stop thinking or pondering.
     ** We don't need this signal, so we ignore it.
@@ -43,20 +43,20 @@ void e_comm_init(void)
     pipe_unix_init(0, 1);
 }
 
-void e_comm_exit(void)
+void e_comm_pipe_exit(void)
 {
     pipe_unix_exit();
 }
 
-void e_comm_send_str(const char *str)
+void e_comm_pipe_write(const char *m, int len)
 {
-    pipe_unix_send(str);
+    pipe_unix_write(m, len);
 }
 
-char *e_comm_poll(void)
+char *e_comm_pipe_receive(void)
 {
     int error;
-    char *retval = pipe_unix_poll(&error);
+    char *retval = pipe_unix_receive(&error);
 
     if (error)
         exit(1);
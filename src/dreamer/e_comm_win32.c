@@ -30,7 +30,7 @@
 #include "e_comm.h"
 #include "pipe_win32.h"
 
-void e_comm_init(void)
+void e_comm_pipe_init(void)
 {
     HANDLE h_in, h_out;
     DWORD mode;
@@ -47,20 +47,20 @@ void e_comm_init(void)
     pipe_win32_init(h_in, h_out, GetConsoleMode(h_in, &mode) != 0);
 }
 
-void e_comm_exit(void)
+void e_comm_pipe_exit(void)
 {
     pipe_win32_exit();
 }
 
-void e_comm_send_str(const char *str)
+void e_comm_pipe_write(const char *m, int len)
 {
-    pipe_win32_send(str);
+    pipe_win32_write(m, len);
 }
 
-char *e_comm_poll(void)
+char *e_comm_pipe_receive(void)
 {
     int error;
-    char *retval = pipe_win32_poll(&error);
+    char *retval = pipe_win32_receive(&error);
 
     if (error)
         exit(1);
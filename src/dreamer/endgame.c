@@ -0,0 +1,440 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "endgame.h"
+
+/* Squares of the same colour as a1. */
+#define DARK_SQUARES 0xAA55AA55AA55AA55ULL
+
+/* King and pawn versus king positions, indexed by kpk_index(). The pawn is
+** on files a-d, other positions are mirrored.
+*/
+#define KPK_SIZE (2 * 24 * 64 * 64)
+
+/* Results during the generation of the bitbase. */
+#define KPK_INVALID 0
+#define KPK_UNKNOWN 1
+#define KPK_DRAW 2
+#define KPK_WIN 4
+
+/* One bit per position, set if white wins. */
+static unsigned int kpk_bits[KPK_SIZE / 32];
+
+/* Squares next to each square. */
+static bitboard_t king_area[64];
+
+/* Material key of one side, see side_key(). */
+#define KEY_PAWNS 15
+#define KEY_SIDE_BITS 12
+
+typedef struct
+{
+    /* Pieces of the strong side, then those of the weak side. */
+    char *code;
+    /* Whether the evaluator applies for any number of pawns. */
+    int any_pawns;
+    /* ENDGAME_EXACT or ENDGAME_SCALE. */
+    int type;
+    /* Returns the score for the strong side, or the scale. */
+    int (*eval)(board_t *board, int strong);
+    int key;
+}
+endgame_t;
+
+static int distance(int a, int b)
+{
+    int files = abs((a & 7) - (b & 7));
+    int ranks = abs((a >> 3) - (b >> 3));
+
+    return (files > ranks ? files : ranks);
+}
+
+/* Returns how far a square is from the centre, from 0 to 6. */
+static int centre_distance(int square)
+{
+    int file = square & 7;
+    int rank = square >> 3;
+
+    return (file < 4 ? 3 - file : file - 4) + (rank < 4 ? 3 - rank : rank - 4);
+}
+
+static int first_square(bitboard_t bitboard)
+{
+    int square;
+
+    for (square = 0; square < 63; square++)
+        if (bitboard & square_bit[square])
+            break;
+
+    return square;
+}
+
+static int count(bitboard_t bitboard)
+{
+    int n = 0;
+
+    while (bitboard)
+    {
+        bitboard &= bitboard - 1;
+        n++;
+    }
+
+    return n;
+}
+
+static bitboard_t white_pawn_attacks(int square)
+{
+    bitboard_t attacks = 0;
+
+    if (square < 56)
+    {
+        if ((square & 7) > 0)
+            attacks |= square_bit[square + 7];
+        if ((square & 7) < 7)
+            attacks |= square_bit[square + 9];
+    }
+
+    return attacks;
+}
+
+static int kpk_index(int side, int defender, int king, int pawn)
+{
+    return king | (defender << 6) | (side << 12) | ((pawn & 7) << 13)
+           | ((6 - (pawn >> 3)) << 15);
+}
+
+/* Returns the result of a position that's decided without looking at the
+** moves, or KPK_UNKNOWN.
+*/
+static int kpk_initial(int side, int king, int pawn, int defender)
+{
+    if (distance(king, defender) <= 1 || king == pawn || defender == pawn
+        || (side == SIDE_WHITE && (white_pawn_attacks(pawn)
+                                   & square_bit[defender])))
+        return KPK_INVALID;
+
+    /* The pawn promotes and can't be taken. */
+    if (side == SIDE_WHITE && (pawn >> 3) == 6 && king != pawn + 8
+        && (distance(defender, pawn + 8) > 1
+            || (king_area[king] & square_bit[pawn + 8])))
+        return KPK_WIN;
+
+    /* Stalemate, or the pawn is lost. */
+    if (side == SIDE_BLACK
+        && (!(king_area[defender] & ~(king_area[king]
+                                      | white_pawn_attacks(pawn)))
+            || (king_area[defender] & square_bit[pawn]
+                & ~king_area[king])))
+        return KPK_DRAW;
+
+    return KPK_UNKNOWN;
+}
+
+/* Returns the result of a position from those of the positions after each
+** move. White needs one move that wins, black one that draws.
+*/
+static int kpk_classify(unsigned char *db, int side, int king, int pawn,
+                        int defender)
+{
+    int good = (side == SIDE_WHITE ? KPK_WIN : KPK_DRAW);
+    int bad = (side == SIDE_WHITE ? KPK_DRAW : KPK_WIN);
+    int from = (side == SIDE_WHITE ? king : defender);
+    int result = KPK_INVALID;
+    int square;
+
+    for (square = 0; square < 64; square++)
+    {
+        if (!(king_area[from] & square_bit[square]))
+            continue;
+
+        if (side == SIDE_WHITE)
+            result |= db[kpk_index(SIDE_BLACK, defender, square, pawn)];
+        else
+            result |= db[kpk_index(SIDE_WHITE, square, king, pawn)];
+    }
+
+    if (side == SIDE_WHITE)
+    {
+        if ((pawn >> 3) < 6)
+            result |= db[kpk_index(SIDE_BLACK, defender, king, pawn + 8)];
+
+        if ((pawn >> 3) == 1 && pawn + 8 != king && pawn + 8 != defender)
+            result |= db[kpk_index(SIDE_BLACK, defender, king, pawn + 16)];
+    }
+
+    if (result & good)
+        return good;
+
+    return (result & KPK_UNKNOWN ? KPK_UNKNOWN : bad);
+}
+
+/* Generates the bitbase by retrograde analysis. Positions that aren't
+** known after the last pass are draws.
+*/
+static void kpk_generate(void)
+{
+    unsigned char *db = malloc(KPK_SIZE);
+    int changed = 1;
+    int i;
+
+    for (i = 0; i < KPK_SIZE; i++)
+        db[i] = kpk_initial((i >> 12) & 1, i & 63,
+                            8 * (6 - (i >> 15)) + ((i >> 13) & 3),
+                            (i >> 6) & 63);
+
+    while (changed)
+    {
+        changed = 0;
+
+        for (i = 0; i < KPK_SIZE; i++)
+        {
+            if (db[i] != KPK_UNKNOWN)
+                continue;
+
+            db[i] = kpk_classify(db, (i >> 12) & 1, i & 63,
+                                 8 * (6 - (i >> 15)) + ((i >> 13) & 3),
+                                 (i >> 6) & 63);
+
+            if (db[i] != KPK_UNKNOWN)
+                changed = 1;
+        }
+    }
+
+    memset(kpk_bits, 0, sizeof(kpk_bits));
+
+    for (i = 0; i < KPK_SIZE; i++)
+        if (db[i] == KPK_WIN)
+            kpk_bits[i / 32] |= 1u << (i % 32);
+
+    free(db);
+}
+
+int kpk_probe(int king, int pawn, int defender, int side)
+{
+    int i;
+
+    if ((pawn & 7) > 3)
+    {
+        king ^= 7;
+        pawn ^= 7;
+        defender ^= 7;
+    }
+
+    i = kpk_index(side, defender, king, pawn);
+    return (kpk_bits[i / 32] >> (i % 32)) & 1;
+}
+
+static int material(board_t *board, int strong)
+{
+    return board->material_value[strong]
+           - board->material_value[OPPONENT(strong)];
+}
+
+/* Neither side can mate. */
+static int eval_draw(board_t *board, int strong)
+{
+    return 0;
+}
+
+static int eval_kpk(board_t *board, int strong)
+{
+    int king = first_square(board_king(board, strong));
+    int pawn = first_square(board->bitboard[PAWN + strong]);
+    int defender = first_square(board_king(board, OPPONENT(strong)));
+    int side = board->current_player;
+
+    if (strong == SIDE_BLACK)
+    {
+        king ^= 56;
+        pawn ^= 56;
+        defender ^= 56;
+        side = OPPONENT(side);
+    }
+
+    if (!kpk_probe(king, pawn, defender, side))
+        return 0;
+
+    return ENDGAME_WIN + material(board, strong) + 10 * (pawn >> 3);
+}
+
+/* A queen or rook mates on the edge, with the help of its king. */
+static int eval_kxk(board_t *board, int strong)
+{
+    int king = first_square(board_king(board, strong));
+    int defender = first_square(board_king(board, OPPONENT(strong)));
+
+    return ENDGAME_WIN + material(board, strong)
+           + 20 * centre_distance(defender) + 10 * (7 - distance(king, defender));
+}
+
+/* Bishop and knight mate in a corner of the bishop's colour. */
+static int eval_kbnk(board_t *board, int strong)
+{
+    int king = first_square(board_king(board, strong));
+    int defender = first_square(board_king(board, OPPONENT(strong)));
+    int corner;
+
+    if (board->bitboard[BISHOP + strong] & DARK_SQUARES)
+        corner = distance(defender, SQUARE_A1) < distance(defender, SQUARE_H8)
+                 ? distance(defender, SQUARE_A1) : distance(defender, SQUARE_H8);
+    else
+        corner = distance(defender, SQUARE_H1) < distance(defender, SQUARE_A8)
+                 ? distance(defender, SQUARE_H1) : distance(defender, SQUARE_A8);
+
+    return ENDGAME_WIN + material(board, strong) + 5 * centre_distance(defender)
+           + 20 * (7 - corner) + 10 * (7 - distance(king, defender));
+}
+
+/* Bishops of opposite colours make it hard to win with extra pawns. */
+static int scale_opposite_bishops(board_t *board, int strong)
+{
+    int white = (board->bitboard[WHITE_BISHOP] & DARK_SQUARES) != 0;
+    int black = (board->bitboard[BLACK_BISHOP] & DARK_SQUARES) != 0;
+
+    return (white != black ? ENDGAME_SCALE_NORMAL / 2 : ENDGAME_SCALE_NORMAL);
+}
+
+static endgame_t endgames[] =
+{
+    {"KK", 0, ENDGAME_EXACT, eval_draw},
+    {"KNK", 0, ENDGAME_EXACT, eval_draw},
+    {"KBK", 0, ENDGAME_EXACT, eval_draw},
+    {"KNNK", 0, ENDGAME_EXACT, eval_draw},
+    {"KPK", 0, ENDGAME_EXACT, eval_kpk},
+    {"KQK", 0, ENDGAME_EXACT, eval_kxk},
+    {"KRK", 0, ENDGAME_EXACT, eval_kxk},
+    {"KBNK", 0, ENDGAME_EXACT, eval_kbnk},
+    {"KBKB", 1, ENDGAME_SCALE, scale_opposite_bishops}
+};
+
+#define ENDGAMES ((int)(sizeof(endgames) / sizeof(endgames[0])))
+
+/* Returns the material of a side: pawns in bits 0-3, then two bits for
+** each of knights, bishops, rooks and queens.
+*/
+static int side_key(board_t *board, int side)
+{
+    bitboard_t *b = board->bitboard;
+
+    return count(b[PAWN + side]) | count(b[KNIGHT + side]) << 4
+           | count(b[BISHOP + side]) << 6 | count(b[ROOK + side]) << 8
+           | count(b[QUEEN + side]) << 10;
+}
+
+static int code_key(char *code)
+{
+    int key = 0;
+    int shift = -KEY_SIDE_BITS;
+
+    for (; *code; code++)
+    {
+        switch (*code)
+        {
+        case 'K':
+            shift += KEY_SIDE_BITS;
+            break;
+        case 'P':
+            key += 1 << shift;
+            break;
+        case 'N':
+            key += 1 << (shift + 4);
+            break;
+        case 'B':
+            key += 1 << (shift + 6);
+            break;
+        case 'R':
+            key += 1 << (shift + 8);
+            break;
+        case 'Q':
+            key += 1 << (shift + 10);
+        }
+    }
+
+    return key;
+}
+
+void endgame_init(void)
+{
+    int square;
+    int i;
+
+    for (square = 0; square < 64; square++)
+    {
+        int other;
+
+        king_area[square] = 0;
+
+        for (other = 0; other < 64; other++)
+            if (distance(square, other) == 1)
+                king_area[square] |= square_bit[other];
+    }
+
+    for (i = 0; i < ENDGAMES; i++)
+        endgames[i].key = code_key(endgames[i].code);
+
+    kpk_generate();
+}
+
+int endgame_probe(board_t *board, int *score)
+{
+    bitboard_t *b = board->bitboard;
+    bitboard_t pieces = b[WHITE_KNIGHT] | b[BLACK_KNIGHT] | b[WHITE_BISHOP]
+                        | b[BLACK_BISHOP] | b[WHITE_ROOK] | b[BLACK_ROOK]
+                        | b[WHITE_QUEEN] | b[BLACK_QUEEN];
+    int white, black;
+    int i;
+
+    /* None of the endings has more than two pieces besides kings and
+    ** pawns.
+    */
+    pieces &= pieces - 1;
+    if (pieces & (pieces - 1))
+        return ENDGAME_NONE;
+
+    white = side_key(board, SIDE_WHITE);
+    black = side_key(board, SIDE_BLACK);
+
+    for (i = 0; i < ENDGAMES; i++)
+    {
+        endgame_t *e = &endgames[i];
+        int mask = (e->any_pawns ? ~(KEY_PAWNS | KEY_PAWNS << KEY_SIDE_BITS)
+                    : ~0);
+        int strong;
+
+        if (((white | black << KEY_SIDE_BITS) & mask) == e->key)
+            strong = SIDE_WHITE;
+        else if (((black | white << KEY_SIDE_BITS) & mask) == e->key)
+            strong = SIDE_BLACK;
+        else
+            continue;
+
+        *score = e->eval(board, strong);
+
+        if (e->type == ENDGAME_EXACT && strong == SIDE_BLACK)
+            *score = -*score;
+
+        return e->type;
+    }
+
+    return ENDGAME_NONE;
+}
@@ -0,0 +1,67 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENDGAME_H
+#define ENDGAME_H
+
+#include "board.h"
+
+/* Endings that the general evaluation doesn't understand, recognised by
+** the material on the board and scored by an evaluator of their own.
+*/
+
+/* Results of endgame_probe(). */
+#define ENDGAME_NONE 0  /* No evaluator applies. */
+#define ENDGAME_EXACT 1 /* The score replaces the evaluation. */
+#define ENDGAME_SCALE 2 /* The evaluation is scaled by the score. */
+
+/* Scale that leaves the evaluation unchanged. */
+#define ENDGAME_SCALE_NORMAL 64
+
+/* Bonus for a position that is known to be won. */
+#define ENDGAME_WIN 1000
+
+void endgame_init(void);
+/* Sets up the endgame evaluators and generates the king and pawn versus
+** king bitbase. Must be called once before the first evaluation.
+** Parameters: (void)
+** Returns   : (void)
+*/
+
+int endgame_probe(board_t *board, int *score);
+/* Looks for an evaluator for the material on the board.
+** Parameters: (board_t *) board: The position.
+**             (int *) score: Receives the score for white if the result is
+**                 ENDGAME_EXACT, or the factor to scale the evaluation by,
+**                 out of ENDGAME_SCALE_NORMAL, if it's ENDGAME_SCALE.
+** Returns   : (int) ENDGAME_NONE, ENDGAME_EXACT or ENDGAME_SCALE.
+*/
+
+int kpk_probe(int king, int pawn, int defender, int side);
+/* Looks up whether king and pawn win against a lone king. The pawn is
+** white, with black's pieces mirrored vertically to use it for black.
+** Parameters: (int) king: Square of the white king.
+**             (int) pawn: Square of the white pawn.
+**             (int) defender: Square of the black king.
+**             (int) side: Side to move.
+** Returns   : (int) 1 if white wins, 0 if it's a draw.
+*/
+
+#endif /* ENDGAME_H */
@@ -0,0 +1,108 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "board.h"
+#include "epd.h"
+
+/* EPD positions lack the move counters of FEN. */
+#define EPD_COUNTERS " 0 1"
+
+int epd_parse(char *line, board_t *board, char **ops)
+{
+    char *fen;
+    char *end;
+    int fields;
+    int retval;
+
+    while (isspace((unsigned char)*line))
+        line++;
+
+    /* The position is made up of the first four fields. */
+    end = line;
+    for (fields = 0; fields < 4; fields++)
+    {
+        while (isspace((unsigned char)*end))
+            end++;
+
+        if (!*end)
+            return 1;
+
+        while (*end && !isspace((unsigned char)*end))
+            end++;
+    }
+
+    fen = malloc(end - line + strlen(EPD_COUNTERS) + 1);
+    memcpy(fen, line, end - line);
+    strcpy(fen + (end - line), EPD_COUNTERS);
+
+    retval = setup_board_fen(board, fen);
+    free(fen);
+
+    *ops = end;
+    return retval;
+}
+
+char *epd_operand(char *ops, const char *opcode)
+{
+    int len = strlen(opcode);
+
+    while (*ops)
+    {
+        char *end;
+
+        while (*ops == ';' || isspace((unsigned char)*ops))
+            ops++;
+
+        end = strchr(ops, ';');
+        if (!end)
+            end = ops + strlen(ops);
+
+        if (!strncmp(ops, opcode, len) && isspace((unsigned char)ops[len]))
+        {
+            char *operand = ops + len;
+            char *retval;
+
+            while (isspace((unsigned char)*operand))
+                operand++;
+
+            while (end > operand && isspace((unsigned char)end[-1]))
+                end--;
+
+            if (end - operand >= 2 && *operand == '"' && end[-1] == '"')
+            {
+                operand++;
+                end--;
+            }
+
+            retval = malloc(end - operand + 1);
+            memcpy(retval, operand, end - operand);
+            retval[end - operand] = '\0';
+            return retval;
+        }
+
+        ops = end;
+    }
+
+    return NULL;
+}
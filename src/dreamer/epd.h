@@ -0,0 +1,44 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef EPD_H
+#define EPD_H
+
+#include "board.h"
+
+int epd_parse(char *line, board_t *board, char **ops);
+/* Sets up a board from a line in EPD format.
+** Parameters: (char *) line: The EPD line.
+**             (board_t *) board: The board to set up.
+**             (char **) ops: Set to the operations following the position.
+** Returns   : (int) 0 on success, 1 if the position is invalid.
+*/
+
+char *epd_operand(char *ops, const char *opcode);
+/* Looks up an operation in the operations of an EPD line. Operations are
+** separated by semicolons, e.g. 'bm Qg6; id "WAC.001";' or ';D1 20 ;D2 400'.
+** Parameters: (char *) ops: The operations.
+**             (const char *) opcode: The opcode to look for.
+** Returns   : (char *), The operand of the first operation with that
+**                 opcode, with quotes removed. Must be freed by the caller.
+**             NULL, if there is no such operation.
+*/
+
+#endif /* EPD_H */
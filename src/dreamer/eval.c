@@ -20,11 +20,55 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "dreamer.h"
 #include "board.h"
 #include "move.h"
 #include "move_data.h"
+#include "attack.h"
 #include "eval.h"
+#include "endgame.h"
+#include "stats.h"
+
+int eval_param[EVAL_PARAMS] =
+{
+    1, -2, -1,                  /* King tropism. */
+    22, 10, 4, 25,              /* Rooks. */
+    -15, -10, -8,               /* Development. */
+    10, -24, -40, -80, -120,    /* Castling. */
+    -8,                         /* Bad bishops. */
+    -8, -15, -10, -8,           /* Pawn structure. */
+    0, 1, 4, 9, 16, 25, 36, 49, /* Passed pawns. */
+    4, 4, 2, 1,                 /* Mobility. */
+    3, -20                      /* Attacks. */
+};
+
+static const char *param_name[EVAL_PARAMS] =
+{
+    "knight_tropism", "rook_tropism", "queen_tropism",
+    "rook_seventh", "rook_open_file", "rook_half_open_file",
+    "rook_behind_passer",
+    "center_pawn_unmoved", "minor_undeveloped", "queen_early",
+    "castled", "castle_both", "castle_kingside", "castle_queenside",
+    "castle_none",
+    "bad_bishop",
+    "doubled_pawn", "isolated_pawn", "eight_pawns", "pawn_ram",
+    "passed_pawn_0", "passed_pawn_1", "passed_pawn_2", "passed_pawn_3",
+    "passed_pawn_4", "passed_pawn_5", "passed_pawn_6", "passed_pawn_7",
+    "knight_mobility", "bishop_mobility", "rook_mobility", "queen_mobility",
+    "king_zone_attack", "hanging_piece"
+};
+
+/* When set, the coefficient of every parameter that adds to the evaluation
+** is added to trace, times trace_sign. See eval_trace().
+*/
+static THREAD_LOCAL int *trace;
+static THREAD_LOCAL int trace_sign;
+
+/* Parameter P times N. */
+#define TERM(P, N) \
+    ((trace ? trace[P] += trace_sign * (N) : 0), (N) * eval_param[P])
 
 static int
 min(int a, int b)
@@ -70,16 +114,19 @@ eval_king_tropism(board_t *board, int side)
             piece_file = square & 7;
 
             if (board->bitboard[WHITE_ROOK] & square_bit[square])
-                score -= min(abs(king_rank - piece_rank),
-                             abs(king_file - piece_file)) << 1;
+                score += TERM(EVAL_ROOK_TROPISM,
+                              min(abs(king_rank - piece_rank),
+                                  abs(king_file - piece_file)));
             else
                 if (board->bitboard[WHITE_KNIGHT] & square_bit[square])
-                    score += 5 - abs(king_rank - piece_rank)
-                             - abs(king_file - piece_file);
+                    score += TERM(EVAL_KNIGHT_TROPISM,
+                                  5 - abs(king_rank - piece_rank)
+                                  - abs(king_file - piece_file));
                 else
                     if (board->bitboard[WHITE_QUEEN] & square_bit[square])
-                        score -= min(abs(king_rank - piece_rank),
-                                     abs(king_file - piece_file));
+                        score += TERM(EVAL_QUEEN_TROPISM,
+                                      min(abs(king_rank - piece_rank),
+                                          abs(king_file - piece_file)));
         }
     }
     else
@@ -98,16 +145,19 @@ eval_king_tropism(board_t *board, int side)
             piece_file = square & 7;
 
             if (board->bitboard[BLACK_ROOK] & square_bit[square])
-                score -= min(abs(king_rank - piece_rank),
-                             abs(king_file - piece_file)) << 1;
+                score += TERM(EVAL_ROOK_TROPISM,
+                              min(abs(king_rank - piece_rank),
+                                  abs(king_file - piece_file)));
             else
                 if (board->bitboard[BLACK_KNIGHT] & square_bit[square])
-                    score += 5 - abs(king_rank - piece_rank)
-                             - abs(king_file - piece_file);
+                    score += TERM(EVAL_KNIGHT_TROPISM,
+                                  5 - abs(king_rank - piece_rank)
+                                  - abs(king_file - piece_file));
                 else
                     if (board->bitboard[BLACK_QUEEN] & square_bit[square])
-                        score -= min(abs(king_rank - piece_rank),
-                                     abs(king_file - piece_file));
+                        score += TERM(EVAL_QUEEN_TROPISM,
+                                      min(abs(king_rank - piece_rank),
+                                          abs(king_file - piece_file)));
         }
     }
 
@@ -129,18 +179,18 @@ eval_rook_bonus(board_t *board, eval_data_t *eval_data, int side)
                 int piece_file = square & 7;
 
                 if (piece_rank == 6)
-                    score += 22;
+                    score += TERM(EVAL_ROOK_SEVENTH, 1);
 
                 if (eval_data->max_pawn_file_bins[piece_file] == 0)
                 {
                     if (eval_data->min_pawn_file_bins[piece_file] == 0)
-                        score += 10;
+                        score += TERM(EVAL_ROOK_OPEN_FILE, 1);
                     else
-                        score += 4;
+                        score += TERM(EVAL_ROOK_HALF_OPEN_FILE, 1);
                 }
 
                 if (square < eval_data->max_passed_pawns[piece_file])
-                    score += 25;
+                    score += TERM(EVAL_ROOK_BEHIND_PASSER, 1);
                 bitboard ^= square_bit[square];
 
                 if (!bitboard)
@@ -156,18 +206,18 @@ eval_rook_bonus(board_t *board, eval_data_t *eval_data, int side)
                 int piece_file = square & 7;
 
                 if (piece_rank == 1)
-                    score += 22;
+                    score += TERM(EVAL_ROOK_SEVENTH, 1);
 
                 if (eval_data->max_pawn_file_bins[piece_file] == 0)
                 {
                     if (eval_data->min_pawn_file_bins[piece_file] == 0)
-                        score += 10;
+                        score += TERM(EVAL_ROOK_OPEN_FILE, 1);
                     else
-                        score += 4;
+                        score += TERM(EVAL_ROOK_HALF_OPEN_FILE, 1);
                 }
 
                 if (square > eval_data->max_passed_pawns[piece_file])
-                    score += 25;
+                    score += TERM(EVAL_ROOK_BEHIND_PASSER, 1);
                 bitboard ^= square_bit[square];
 
                 if (!bitboard)
@@ -189,9 +239,9 @@ eval_development(board_t *board, int side)
     if (side == SIDE_WHITE)
     {
         if (board->bitboard[WHITE_PAWN] & square_bit[SQUARE_D2])
-            score -= 15;
+            score += TERM(EVAL_CENTER_PAWN_UNMOVED, 1);
         if (board->bitboard[WHITE_PAWN] & square_bit[SQUARE_E2])
-            score -= 15;
+            score += TERM(EVAL_CENTER_PAWN_UNMOVED, 1);
 
         bitboard = board->bitboard[WHITE_KNIGHT] |
                    board->bitboard[WHITE_BISHOP];
@@ -199,7 +249,7 @@ eval_development(board_t *board, int side)
         for (square = SQUARE_A1; square <= SQUARE_H1; square++)
         {
             if (bitboard & square_bit[square])
-                score -= 10;
+                score += TERM(EVAL_MINOR_UNDEVELOPED, 1);
         }
 
         bitboard = board->bitboard[WHITE_QUEEN];
@@ -222,33 +272,33 @@ eval_development(board_t *board, int side)
             /* if (board->bitboard[WHITE_KING] & square_bit[SQUARE_E1])
                 count++; */
 
-            score -= count << 3;
+            score += TERM(EVAL_QUEEN_EARLY, count);
         }
 
         if (board->bitboard[BLACK_QUEEN])
         {
             if (board->castle_flags & WHITE_HAS_CASTLED)
-                score += 10;
+                score += TERM(EVAL_CASTLED, 1);
             else
                 if ((board->castle_flags & WHITE_CAN_CASTLE_KINGSIDE) &&
                         (board->castle_flags & WHITE_CAN_CASTLE_QUEENSIDE))
-                    score -= 24;
+                    score += TERM(EVAL_CASTLE_BOTH, 1);
                 else
                     if (board->castle_flags & WHITE_CAN_CASTLE_KINGSIDE)
-                        score -= 40;
+                        score += TERM(EVAL_CASTLE_KINGSIDE, 1);
                     else
                         if (board->castle_flags & WHITE_CAN_CASTLE_QUEENSIDE)
-                            score -= 80;
+                            score += TERM(EVAL_CASTLE_QUEENSIDE, 1);
                         else
-                            score -= 120;
+                            score += TERM(EVAL_CASTLE_NONE, 1);
         }
     }
     else
     {
         if (board->bitboard[BLACK_PAWN] & square_bit[SQUARE_D7])
-            score -= 15;
+            score += TERM(EVAL_CENTER_PAWN_UNMOVED, 1);
         if (board->bitboard[BLACK_PAWN] & square_bit[SQUARE_E7])
-            score -= 15;
+            score += TERM(EVAL_CENTER_PAWN_UNMOVED, 1);
 
         bitboard = board->bitboard[BLACK_KNIGHT] |
                    board->bitboard[BLACK_BISHOP];
@@ -256,7 +306,7 @@ eval_development(board_t *board, int side)
         for (square = SQUARE_A8; square <= SQUARE_H8; square++)
         {
             if (bitboard & square_bit[square])
-                score -= 10;
+                score += TERM(EVAL_MINOR_UNDEVELOPED, 1);
         }
 
         bitboard = board->bitboard[BLACK_QUEEN];
@@ -279,25 +329,25 @@ eval_development(board_t *board, int side)
             /* if (board->bitboard[BLACK_KING] & square_bit[SQUARE_E8])
                 count++; */
 
-            score -= count << 3;
+            score += TERM(EVAL_QUEEN_EARLY, count);
         }
 
         if (board->bitboard[WHITE_QUEEN])
         {
             if (board->castle_flags & BLACK_HAS_CASTLED)
-                score += 10;
+                score += TERM(EVAL_CASTLED, 1);
             else
                 if ((board->castle_flags & BLACK_CAN_CASTLE_KINGSIDE) &&
                         (board->castle_flags & BLACK_CAN_CASTLE_QUEENSIDE))
-                    score -= 24;
+                    score += TERM(EVAL_CASTLE_BOTH, 1);
                 else
                     if (board->castle_flags & BLACK_CAN_CASTLE_KINGSIDE)
-                        score -= 40;
+                        score += TERM(EVAL_CASTLE_KINGSIDE, 1);
                     else
                         if (board->castle_flags & BLACK_CAN_CASTLE_QUEENSIDE)
-                            score -= 80;
+                            score += TERM(EVAL_CASTLE_QUEENSIDE, 1);
                         else
-                            score -= 120;
+                            score += TERM(EVAL_CASTLE_NONE, 1);
         }
     }
 
@@ -322,9 +372,11 @@ eval_bad_bishops(board_t *board, eval_data_t *eval_data, int side)
             int piece_file = square & 7;
 
             if ((piece_rank & 1) == (piece_file & 1))
-                score -= eval_data->max_pawn_color_bins[0] << 3;
+                score += TERM(EVAL_BAD_BISHOP,
+                              eval_data->max_pawn_color_bins[0]);
             else
-                score -= eval_data->max_pawn_color_bins[1] << 3;
+                score += TERM(EVAL_BAD_BISHOP,
+                              eval_data->max_pawn_color_bins[1]);
 
             bitboard ^= square_bit[square];
 
@@ -344,39 +396,39 @@ eval_pawn_structure(board_t *board, eval_data_t *eval_data, int side)
 
     for (bin = 0; bin < 8; bin++)
         if (eval_data->max_pawn_file_bins[bin] > 1)
-            score -= 8;
+            score += TERM(EVAL_DOUBLED_PAWN, 1);
 
     if ((eval_data->max_pawn_file_bins[0] > 0) &&
             eval_data->max_pawn_file_bins[1] == 0)
-        score -= 15;
+        score += TERM(EVAL_ISOLATED_PAWN, 1);
     if ((eval_data->max_pawn_file_bins[7] > 0) &&
             eval_data->max_pawn_file_bins[6] == 0)
-        score -= 15;
+        score += TERM(EVAL_ISOLATED_PAWN, 1);
 
     for (bin = 1; bin < 7; bin++)
         if ((eval_data->max_pawn_file_bins[bin] > 0) &&
                 (eval_data->max_pawn_file_bins[bin - 1] == 0) &&
                 (eval_data->max_pawn_file_bins[bin + 1] == 0))
-            score -= 15;
+            score += TERM(EVAL_ISOLATED_PAWN, 1);
 
     if (eval_data->max_total_pawns == 8)
-        score -= 10;
+        score += TERM(EVAL_EIGHT_PAWNS, 1);
 
-    score -= 8 * eval_data->pawn_rams;
+    score += TERM(EVAL_PAWN_RAM, eval_data->pawn_rams);
 
     if (side == SIDE_WHITE)
     {
         for (bin = 0; bin < 8; bin++)
             if (eval_data->max_passed_pawns[bin] > 0)
-                score += (eval_data->max_passed_pawns[bin] >> 3) *
-                         (eval_data->max_passed_pawns[bin] >> 3);
+                score += TERM(EVAL_PASSED_PAWN
+                              + (eval_data->max_passed_pawns[bin] >> 3), 1);
     }
     else
     {
         for (bin = 0; bin < 8; bin++)
             if (eval_data->max_passed_pawns[bin] < 63)
-                score += (7 - (eval_data->max_passed_pawns[bin] >> 3)) *
-                         (7 - (eval_data->max_passed_pawns[bin] >> 3));
+                score += TERM(EVAL_PASSED_PAWN + 7
+                              - (eval_data->max_passed_pawns[bin] >> 3), 1);
     }
 
     return score;
@@ -517,6 +569,39 @@ analyze_pawn_structure(board_t *board, eval_data_t *eval_data, int side)
     }
 }
 
+static int
+eval_attacks(board_t *board, attack_map_t *map, int side)
+{
+    bitboard_t *b = board->bitboard;
+    int opponent = OPPONENT(side);
+    bitboard_t zone;
+    bitboard_t pieces;
+    int score = 0;
+
+    score += TERM(EVAL_KNIGHT_MOBILITY, map->mobility[KNIGHT + side]);
+    score += TERM(EVAL_BISHOP_MOBILITY, map->mobility[BISHOP + side]);
+    score += TERM(EVAL_ROOK_MOBILITY, map->mobility[ROOK + side]);
+    score += TERM(EVAL_QUEEN_MOBILITY, map->mobility[QUEEN + side]);
+
+    /* Squares next to the other king that are attacked, counted twice when
+    ** two pieces attack them.
+    */
+    zone = map->by_piece[KING + opponent] | board_king(board, opponent);
+    score += TERM(EVAL_KING_ZONE_ATTACK,
+                  attack_count(zone & map->by_side[side])
+                  + attack_count(zone & map->twice[side]));
+
+    /* Pieces that are attacked and not defended, or attacked by a pawn. */
+    pieces = b[KNIGHT + side] | b[BISHOP + side] | b[ROOK + side]
+             | b[QUEEN + side];
+    score += TERM(EVAL_HANGING_PIECE,
+                  attack_count(pieces & ((map->by_side[opponent]
+                                          & ~map->by_side[side])
+                                         | map->by_piece[PAWN + opponent])));
+
+    return score;
+}
+
 static int
 board_eval_material(board_t *board, int side)
 {
@@ -558,6 +643,113 @@ board_eval_material(board_t *board, int side)
     }
 }
 
+const char *
+eval_param_name(int param)
+{
+    return param_name[param];
+}
+
+int
+eval_params_read(char *filename)
+{
+    FILE *f = fopen(filename, "r");
+    char line[256];
+
+    if (!f)
+    {
+        fprintf(stderr, "Error opening %s\n", filename);
+        return 1;
+    }
+
+    while (fgets(line, sizeof(line), f))
+    {
+        char name[64];
+        int value;
+        int i;
+
+        if (sscanf(line, "%63s %i", name, &value) != 2 || name[0] == '#')
+            continue;
+
+        for (i = 0; i < EVAL_PARAMS; i++)
+            if (!strcmp(name, param_name[i]))
+                break;
+
+        if (i == EVAL_PARAMS)
+        {
+            fprintf(stderr, "Unknown parameter %s in %s\n", name, filename);
+            fclose(f);
+            return 1;
+        }
+
+        eval_param[i] = value;
+    }
+
+    fclose(f);
+    return 0;
+}
+
+void
+eval_params_write(FILE *f)
+{
+    int i;
+
+    for (i = 0; i < EVAL_PARAMS; i++)
+        fprintf(f, "%s %i\n", param_name[i], eval_param[i]);
+}
+
+/* The positional terms of one side. The evaluation and eval_trace() both
+** count them for white and for black, so the tuner fits what is searched.
+*/
+static int
+eval_positional(board_t *board, attack_map_t *map, int side)
+{
+    eval_data_t eval_data;
+
+    analyze_pawn_structure(board, &eval_data, side);
+    return eval_pawn_structure(board, &eval_data, side) +
+           eval_bad_bishops(board, &eval_data, side) +
+           eval_development(board, side) +
+           eval_rook_bonus(board, &eval_data, side) +
+           eval_king_tropism(board, side) +
+           eval_attacks(board, map, side);
+}
+
+int
+eval_trace(board_t *board, int *coef)
+{
+    attack_map_t map;
+    int side;
+    int score;
+    int type = endgame_probe(board, &score);
+
+    memset(coef, 0, EVAL_PARAMS * sizeof(int));
+
+    if (type == ENDGAME_EXACT)
+        return score;
+
+    attack_map_build(board, &map);
+    trace = coef;
+
+    for (side = SIDE_WHITE; side <= SIDE_BLACK; side++)
+    {
+        trace_sign = (side == SIDE_WHITE ? 1 : -1);
+        eval_positional(board, &map, side);
+    }
+
+    trace = NULL;
+
+    if (type == ENDGAME_SCALE)
+    {
+        for (side = 0; side < EVAL_PARAMS; side++)
+            coef[side] = coef[side] * score / ENDGAME_SCALE_NORMAL;
+
+        return board_eval_material(board, SIDE_WHITE) * score
+               / ENDGAME_SCALE_NORMAL;
+    }
+
+    return board_eval_material(board, SIDE_WHITE);
+}
+
 int
 board_eval_quick(board_t *board, int side)
 {
@@ -569,11 +761,22 @@ board_eval_quick(board_t *board, int side)
 }
 
 int
-board_eval_complete(board_t *board, int side, int alpha, int beta)
+board_eval_complete(board_t *board, int side, attack_map_t *map, int alpha,
+                    int beta)
 {
-    eval_data_t eval_data;
+    attack_map_t own_map;
     int eval2;
-    int eval1 = board_eval_material(board, side);
+    int eval1;
+    int score;
+    int type = endgame_probe(board, &score);
+
+    STATS_INC(evals);
+
+    /* Endings with an evaluator of their own need nothing else. */
+    if (type == ENDGAME_EXACT)
+        return (board->current_player == SIDE_WHITE ? score : -score);
+
+    eval1 = board_eval_material(board, side);
 
     if (board->current_player != side)
         eval1 = -eval1;
@@ -584,16 +787,21 @@ board_eval_complete(board_t *board, int side, int alpha, int beta)
     if (eval1 + 200 <= alpha)
         return alpha;
 #endif
-    analyze_pawn_structure(board, &eval_data, side);
-    eval2 = eval_pawn_structure(board, &eval_data, side) +
-            eval_bad_bishops(board, &eval_data, side) +
-            eval_development(board, side) +
-            eval_rook_bonus(board, &eval_data, side) +
-            eval_king_tropism(board, side) + 192; /* Add 192 to have the starting position score 0 */
+    if (!map)
+    {
+        map = &own_map;
+        attack_map_build(board, map);
+    }
 
-    if (board->current_player == side)
-        return eval1 + eval2;
-    else
-        return eval1 - eval2;
+    eval2 = eval_positional(board, map, side)
+            - eval_positional(board, map, OPPONENT(side));
+
+    if (board->current_player != side)
+        eval2 = -eval2;
+
+    if (type == ENDGAME_SCALE)
+        return (eval1 + eval2) * score / ENDGAME_SCALE_NORMAL;
+
+    return eval1 + eval2;
 }
 
@@ -21,8 +21,41 @@
 #ifndef EVAL_H
 #define EVAL_H
 
+#include <stdio.h>
+
+#include "attack.h"
 #include "board.h"
 
+/* Weights of the evaluation terms, indexes into eval_param. */
+#define EVAL_KNIGHT_TROPISM 0
+#define EVAL_ROOK_TROPISM 1
+#define EVAL_QUEEN_TROPISM 2
+#define EVAL_ROOK_SEVENTH 3
+#define EVAL_ROOK_OPEN_FILE 4
+#define EVAL_ROOK_HALF_OPEN_FILE 5
+#define EVAL_ROOK_BEHIND_PASSER 6
+#define EVAL_CENTER_PAWN_UNMOVED 7
+#define EVAL_MINOR_UNDEVELOPED 8
+#define EVAL_QUEEN_EARLY 9
+#define EVAL_CASTLED 10
+#define EVAL_CASTLE_BOTH 11
+#define EVAL_CASTLE_KINGSIDE 12
+#define EVAL_CASTLE_QUEENSIDE 13
+#define EVAL_CASTLE_NONE 14
+#define EVAL_BAD_BISHOP 15
+#define EVAL_DOUBLED_PAWN 16
+#define EVAL_ISOLATED_PAWN 17
+#define EVAL_EIGHT_PAWNS 18
+#define EVAL_PAWN_RAM 19
+#define EVAL_PASSED_PAWN 20 /* 8 entries, by rank from the pawn's side. */
+#define EVAL_KNIGHT_MOBILITY 28
+#define EVAL_BISHOP_MOBILITY 29
+#define EVAL_ROOK_MOBILITY 30
+#define EVAL_QUEEN_MOBILITY 31
+#define EVAL_KING_ZONE_ATTACK 32
+#define EVAL_HANGING_PIECE 33
+#define EVAL_PARAMS 34
+
 typedef struct eval_data
 {
 	int max_pawn_file_bins[8];
@@ -39,6 +72,55 @@ int
 board_eval_quick(board_t *board, int side);
 
 int
-board_eval_complete(board_t *board, int side, int alpha, int beta);
+board_eval_complete(board_t *board, int side, attack_map_t *map, int alpha,
+                    int beta);
+/* Evaluates a position.
+** Parameters: (board_t *) board: The position.
+**             (int) side: The side to move at the root of the search. The
+**                 score is the same for either side.
+**             (attack_map_t *) map: Attacks of the position, as built by
+**                 attack_map_build(), or NULL to build them here.
+**             (int) alpha, beta: Search window, unused.
+** Returns   : (int) The score for the side to move.
+*/
+
+/* The weights that the evaluation uses. They may only be changed while no
+** thread is evaluating.
+*/
+extern int eval_param[EVAL_PARAMS];
+
+const char *
+eval_param_name(int param);
+/* Returns the name of a weight, as used in parameter files.
+** Parameters: (int) param: The weight.
+** Returns   : (const char *) The name.
+*/
+
+int
+eval_params_read(char *filename);
+/* Reads weights from a file with a name and a value per line, as written
+** by eval_params_write(). Weights that aren't in the file are unchanged.
+** Parameters: (char *) filename: The file.
+** Returns   : (int) 0 on success, 1 if the file can't be read or has an
+**                 unknown name.
+*/
+
+void
+eval_params_write(FILE *f);
+/* Writes all weights in the format of eval_params_read().
+** Parameters: (FILE *) f: The file.
+** Returns   : (void)
+*/
+
+int
+eval_trace(board_t *board, int *coef);
+/* Splits the evaluation of a position into its material score and its
+** weights, for tuning: the evaluation of the terms of white minus those of
+** black is the sum of coef[i] * eval_param[i]. Endings with an evaluator of
+** their own have no coefficients or scaled ones, see endgame.h.
+** Parameters: (board_t *) board: The position.
+**             (int *) coef: Where to store the EVAL_PARAMS coefficients.
+** Returns   : (int) The material score for white.
+*/
 
 #endif /* EVAL_H */
@@ -26,18 +26,53 @@
 #include "move.h"
 #include "history.h"
 
-static int history[2][64][64];
+/* Per thread, like the rest of the search state. */
+static THREAD_LOCAL int history[2][64][64];
 
+/* Returns 0 for a capture that shouldn't lose material, 1 for a capture
+** of a defended piece by a more valuable one and 3 for a move that doesn't
+** capture.
+*/
 static inline int
-move_compare(move_t move1, move_t move2, int current_side)
+move_class(move_t move, attack_map_t *map, int side)
 {
+    if (!(move & (CAPTURE_MOVE | CAPTURE_MOVE_EN_PASSANT)))
+        return 3;
 
-    if ((move1 & (CAPTURE_MOVE | CAPTURE_MOVE_EN_PASSANT)) && !(move2 & (CAPTURE_MOVE | CAPTURE_MOVE_EN_PASSANT)))
-        return -1;
-
-    if (!(move1 & (CAPTURE_MOVE | CAPTURE_MOVE_EN_PASSANT)) && (move2 & (CAPTURE_MOVE | CAPTURE_MOVE_EN_PASSANT)))
+    if (map && (MOVE_GET(move, PIECE) & PIECE_MASK)
+               > (MOVE_GET(move, CAPTURED) & PIECE_MASK)
+        && (map->by_side[OPPONENT(side)] & square_bit[MOVE_GET(move, DEST)]))
         return 1;
 
+    return 0;
+}
+
+static inline int
+move_compare(move_t move1, move_t move2, int current_side, attack_map_t *map)
+{
+    int class1 = move_class(move1, map, current_side);
+    int class2 = move_class(move2, map, current_side);
+
+    if (class1 != class2)
+        return (class1 < class2 ? -1 : 1);
+
+    /* Among captures, the most valuable victim goes first, and then the
+    ** least valuable attacker. Pieces are numbered by value.
+    */
+    if (class1 != 3)
+    {
+        int victim1 = MOVE_GET(move1, CAPTURED) & PIECE_MASK;
+        int victim2 = MOVE_GET(move2, CAPTURED) & PIECE_MASK;
+        int attacker1 = MOVE_GET(move1, PIECE) & PIECE_MASK;
+        int attacker2 = MOVE_GET(move2, PIECE) & PIECE_MASK;
+
+        if (victim1 != victim2)
+            return (victim1 > victim2 ? -1 : 1);
+
+        if (attacker1 != attacker2)
+            return (attacker1 < attacker2 ? -1 : 1);
+    }
+
     if (history[current_side][MOVE_GET(move1, SOURCE)][MOVE_GET(move1, DEST)]
             > history[current_side][MOVE_GET(move2, SOURCE)][MOVE_GET(move2, DEST)])
         return -1;
@@ -59,20 +94,25 @@ void best_first(int ply, move_t move)
 }
 
 void
-sort_next(int ply, int side)
+sort_next(int ply, int side, attack_map_t *map)
 {
-    int i, min;
-    move_t swap;
+    move_t *list = moves;
+    int i, min, cur = moves_cur[ply], end = moves_start[ply + 1];
+    move_t best;
  
-    min = moves_cur[ply];
+    min = cur;
+    best = list[cur];
 
-    for (i = moves_cur[ply] + 1; i < moves_start[ply + 1]; i++)
-       if (move_compare(moves[i], moves[min], side) < 0)
+    /* Track the best move in a local so it isn't reloaded from the list. */
+    for (i = cur + 1; i < end; i++)
+       if (move_compare(list[i], best, side, map) < 0)
+       {
           min = i;
+          best = list[i];
+       }
 
-    swap = moves[moves_cur[ply]];
-    moves[moves_cur[ply]] = moves[min];
-    moves[min] = swap;
+    list[min] = list[cur];
+    list[cur] = best;
 }
 
 void
@@ -21,13 +21,14 @@
 #ifndef HISTORY_H
 #define HISTORY_H
 
+#include "attack.h"
 #include "board.h"
 
 void
 sort_moves(int ply, int side, move_t best_move);
 
 void
-sort_next(int ply, int side);
+sort_next(int ply, int side, attack_map_t *map);
 
 void
 add_count(move_t move, int side);
@@ -0,0 +1,245 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "instance.h"
+#include "attack.h"
+#include "board.h"
+#include "commands.h"
+#include "endgame.h"
+#include "eval.h"
+#include "hashing.h"
+#include "history.h"
+#include "move.h"
+#include "repetition.h"
+#include "search.h"
+#include "stats.h"
+#include "transposition.h"
+
+struct dreamer
+{
+    state_t state;
+    transposition_t *tt;
+};
+
+/* The search state lives in the thread that calls into an instance. Makes
+** it that of instance d.
+*/
+static void bind(dreamer_t *d)
+{
+    move_stack_init(MAX_DEPTH + QUIESCE_PLIES);
+    transposition_bind(d->tt);
+    restore_repetition(&d->state);
+}
+
+void dreamer_init(void)
+{
+    board_init();
+    init_hash();
+    move_init();
+    attack_init();
+    endgame_init();
+    set_start_time();
+}
+
+void dreamer_exit(void)
+{
+    move_exit();
+}
+
+void dreamer_thread_exit(void)
+{
+    move_stack_exit();
+    search_exit();
+    stats_exit();
+    repetition_exit();
+    transposition_bind(NULL);
+}
+
+dreamer_t *dreamer_new(int hash, dreamer_t *share)
+{
+    dreamer_t *d = calloc(1, sizeof(dreamer_t));
+    state_t *state;
+
+    if (!d)
+        return NULL;
+
+    d->tt = (share ? transposition_ref(share->tt) : transposition_new(hash));
+
+    if (!d->tt)
+    {
+        free(d);
+        return NULL;
+    }
+
+    state = &d->state;
+    state->protocol = PROTOCOL_LIBRARY;
+    state->mode = MODE_FORCE;
+    state->depth = MAX_DEPTH;
+    state->multipv = 1;
+    setup_board(&state->board);
+    timer_init(&state->engine_time, 1);
+    timer_init(&state->move_time, 1);
+    state->hint = NO_MOVE;
+    state->ponder_opp_move = NO_MOVE;
+    state->ponder_my_move = NO_MOVE;
+    state->ponder_actual_move = NO_MOVE;
+
+    return d;
+}
+
+void dreamer_free(dreamer_t *d)
+{
+    free(d->state.undo_data);
+    transposition_free(d->tt);
+    free(d);
+}
+
+static int play(state_t *state, char *s)
+{
+    move_t move;
+
+    if (parse_coord_move(&state->board, 0, s, &move) || move == NO_MOVE)
+        return 1;
+
+    do_move(state, move);
+    return 0;
+}
+
+int dreamer_set_position(dreamer_t *d, char *fen, char *moves)
+{
+    state_t *state = &d->state;
+    board_t board;
+
+    if (!fen)
+        setup_board(&board);
+    else if (setup_board_fen(&board, fen))
+        return 1;
+
+    state->board = board;
+    free(state->undo_data);
+    state->undo_data = NULL;
+    state->moves = 0;
+    state->hint = NO_MOVE;
+
+    bind(d);
+
+    while (moves && *moves)
+    {
+        /* Coordinate moves are at most 5 characters. */
+        char s[6];
+        int len;
+
+        moves += strspn(moves, " ");
+        len = strcspn(moves, " ");
+
+        if (len == 0)
+            break;
+
+        if (len >= (int)sizeof(s))
+            return 1;
+
+        memcpy(s, moves, len);
+        s[len] = '\0';
+        moves += len;
+
+        if (play(state, s))
+            return 1;
+    }
+
+    return 0;
+}
+
+int dreamer_move(dreamer_t *d, char *move)
+{
+    bind(d);
+    d->state.hint = NO_MOVE;
+    return play(&d->state, move);
+}
+
+int dreamer_eval(dreamer_t *d)
+{
+    board_t *board = &d->state.board;
+
+    return board_eval_complete(board, board->current_player, NULL,
+                               ALPHABETA_MIN, ALPHABETA_MAX);
+}
+
+int dreamer_side_to_move(dreamer_t *d)
+{
+    return d->state.board.current_player;
+}
+
+board_t *dreamer_board(dreamer_t *d)
+{
+    return &d->state.board;
+}
+
+move_t dreamer_search(dreamer_t *d, dreamer_limits_t *limits,
+                      search_info_fn info, void *data)
+{
+    state_t *state = &d->state;
+    move_t move;
+
+    bind(d);
+
+    /* The history table belongs to the thread, not to the game. Start
+    ** every search without it, so the result doesn't depend on which
+    ** thread searched what before.
+    */
+    forget_history();
+
+    state->depth = (limits->depth > 0 ? limits->depth : MAX_DEPTH);
+    state->nodes = limits->nodes;
+    state->multipv = (limits->multipv > 0 ? limits->multipv : 1);
+    state->options = (1 << OPTION_QUIESCE) | (info ? 1 << OPTION_POST : 0);
+    state->info = info;
+    state->info_data = data;
+
+    timer_init(&state->move_time, 1);
+
+    if (limits->msec > 0)
+    {
+        state->flags = 0;
+        timer_set(&state->move_time, limits->msec / 10);
+    }
+    else
+        state->flags = FLAG_INFINITE;
+
+    /* A stop that came before the search is kept and ends it right after
+    ** the first move, so the flag is only cleared once the search is over.
+    */
+    move = find_best_move(state);
+    __atomic_store_n(&state->stop, 0, __ATOMIC_RELEASE);
+
+    return move;
+}
+
+move_t dreamer_ponder_move(dreamer_t *d)
+{
+    return d->state.hint;
+}
+
+void dreamer_stop(dreamer_t *d)
+{
+    __atomic_store_n(&d->state.stop, 1, __ATOMIC_RELEASE);
+}
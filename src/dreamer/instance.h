@@ -0,0 +1,147 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INSTANCE_H
+#define INSTANCE_H
+
+#include "dreamer.h"
+#include "move.h"
+
+/* An engine instance plays one game, without any protocol. Instances don't
+** share any state unless asked to, so a program can host many games at
+** once, searching each on whatever thread is free. A single instance must
+** not be used by two threads at the same time.
+*/
+typedef struct dreamer dreamer_t;
+
+typedef struct
+{
+    int depth;   /* Maximum depth in plies, or 0 for MAX_DEPTH. */
+    int nodes;   /* Maximum number of nodes, or 0 for no limit. */
+    int msec;    /* Time for the search in milliseconds, or 0 for no limit. */
+    int multipv; /* Number of best lines to search for, or 0 for 1. */
+}
+dreamer_limits_t;
+
+void dreamer_init(void);
+/* Sets up the tables that all instances use. Must be called once before
+** the first instance is created.
+** Parameters: (void)
+** Returns   : (void)
+*/
+
+void dreamer_exit(void);
+/* Frees the tables set up by dreamer_init().
+** Parameters: (void)
+** Returns   : (void)
+*/
+
+void dreamer_thread_exit(void);
+/* Frees the search buffers of the current thread. Threads that used an
+** instance should call this before they exit.
+** Parameters: (void)
+** Returns   : (void)
+*/
+
+dreamer_t *dreamer_new(int hash, dreamer_t *share);
+/* Creates an instance at the starting position.
+** Parameters: (int) hash: Size of the transposition table in megabytes.
+**             (dreamer_t *) share: Instance to share the transposition
+**                 table with, or NULL for a table of its own.
+** Returns   : (dreamer_t *) The new instance, or NULL if there's not
+**                 enough memory.
+*/
+
+void dreamer_free(dreamer_t *d);
+/* Destroys an instance. A shared transposition table is freed with the
+** last instance that uses it.
+** Parameters: (dreamer_t *) d: The instance.
+** Returns   : (void)
+*/
+
+int dreamer_set_position(dreamer_t *d, char *fen, char *moves);
+/* Sets up a position, like the UCI position command.
+** Parameters: (dreamer_t *) d: The instance.
+**             (char *) fen: The position in FEN, or NULL for the starting
+**                 position.
+**             (char *) moves: Moves played from there in coordinate
+**                 notation, separated by spaces, or NULL.
+** Returns   : (int) 0 on success, 1 if the FEN is invalid or a move is
+**                 illegal. An invalid FEN leaves the position unchanged, an
+**                 illegal move leaves it after the move before.
+*/
+
+int dreamer_move(dreamer_t *d, char *move);
+/* Plays a move.
+** Parameters: (dreamer_t *) d: The instance.
+**             (char *) move: The move in coordinate notation.
+** Returns   : (int) 0 on success, 1 if the move is illegal.
+*/
+
+int dreamer_eval(dreamer_t *d);
+/* Evaluates the current position without searching.
+** Parameters: (dreamer_t *) d: The instance.
+** Returns   : (int) The static evaluation in centipawns, from the point of
+**                 view of the side to move.
+*/
+
+int dreamer_side_to_move(dreamer_t *d);
+/* Returns the side to move.
+** Parameters: (dreamer_t *) d: The instance.
+** Returns   : (int) SIDE_WHITE or SIDE_BLACK.
+*/
+
+board_t *dreamer_board(dreamer_t *d);
+/* Returns the current position. It belongs to the instance and must not be
+** changed.
+** Parameters: (dreamer_t *) d: The instance.
+** Returns   : (board_t *) The position.
+*/
+
+move_t dreamer_search(dreamer_t *d, dreamer_limits_t *limits,
+                      search_info_fn info, void *data);
+/* Searches the current position. The best move isn't played.
+** Parameters: (dreamer_t *) d: The instance.
+**             (dreamer_limits_t *) limits: When to stop the search.
+**             (search_info_fn) info: Called with the best lines as the
+**                 search progresses, or NULL.
+**             (void *) data: Passed to info.
+** Returns   : (move_t) The best move, RESIGN_MOVE if the side to move is
+**                 checkmated or STALEMATE_MOVE if it's stalemated. Use
+**                 coord_move_str() to print it.
+*/
+
+move_t dreamer_ponder_move(dreamer_t *d);
+/* Returns the expected reply to the best move of the last search.
+** Parameters: (dreamer_t *) d: The instance.
+** Returns   : (move_t) The move, or NO_MOVE if there is none.
+*/
+
+void dreamer_stop(dreamer_t *d);
+/* Stops a running search, which then returns the best move found so far.
+** If no search is running, the next one stops as soon as it has a move,
+** so a stop is never lost to a search that is just starting. This is the
+** only call that can be made from another thread while the instance is
+** searching.
+** Parameters: (dreamer_t *) d: The instance.
+** Returns   : (void)
+*/
+
+#endif /* INSTANCE_H */
@@ -19,24 +19,221 @@
 */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
 
+#include "attack.h"
 #include "board.h"
+#include "dreamer.h"
 #include "hashing.h"
 #include "move.h"
 #include "transposition.h"
+#include "bench.h"
+#include "suite.h"
+#include "server.h"
+#include "batch.h"
+#include "selfplay.h"
+#include "tune.h"
+#include "eval.h"
+#include "endgame.h"
 #include "git_rev.h"
 #include "config.h"
 
-int engine(void *data);
+#ifdef HAVE_GETOPT_H
+#include <getopt.h>
+#endif /* HAVE_GETOPT_H */
+
+#ifdef HAVE_GETOPT_LONG
+#define OPTION_TEXT(L, S, T) "  " L "\t" S "\t" T "\n"
+#else
+#define OPTION_TEXT(L, S, T) "  " S "\t" T "\n"
+#endif
+
+static int next_arg(int argc, char **argv, int def)
+{
+    if (optind < argc)
+        return atoi(argv[optind++]);
+
+    return def;
+}
 
 int main(int argc, char **argv)
 {
+    int c;
+    int run_bench = 0;
+    int run_server = 0;
+    int run_server_bench = 0;
+    char *perft_file = NULL;
+    char *epd_file = NULL;
+    char *batch_file = NULL;
+    char *selfplay_file = NULL;
+    char *tune_file = NULL;
+    char *params_file = NULL;
+    double epd_time = SUITE_DEFAULT_TIME;
+    int threads = 1;
+
+#ifdef HAVE_GETOPT_LONG
+    int optindex;
+
+    struct option options[] =
+        {
+            {"help", no_argument, NULL, 'h'},
+            {"bench", no_argument, NULL, 'b'},
+            {"perft", required_argument, NULL, 'p'},
+            {"epd", required_argument, NULL, 'e'},
+            {"batch", required_argument, NULL, 'B'},
+            {"selfplay", required_argument, NULL, 'G'},
+            {"tune", required_argument, NULL, 'T'},
+            {"params", required_argument, NULL, 'P'},
+            {"time", required_argument, NULL, 't'},
+            {"threads", required_argument, NULL, 'j'},
+            {"server", no_argument, NULL, 's'},
+            {"server-bench", no_argument, NULL, 'S'},
+            {0, 0, 0, 0}
+        };
+
+    while ((c = getopt_long(argc, argv, "bhp:e:B:G:T:P:t:j:sS", options, &optindex)) > -1) {
+#else
+
+    while ((c = getopt(argc, argv, "bhp:e:B:G:T:P:t:j:sS")) > -1) {
+#endif /* HAVE_GETOPT_LONG */
+        switch (c)
+        {
+        case 'h':
+            printf("Usage: dreamer [options]\n\n"
+                   "An xboard and UCI compatible chess engine.\n\n"
+                   "Options:\n"
+                   OPTION_TEXT("--help\t\t", "-h\t", "Show help.")
+                   OPTION_TEXT("--bench [d] [t] [h]", "-b\t", "Search the benchmark positions to depth d\n\t\t\t\t  with t threads and h MB of hash and exit.")
+                   OPTION_TEXT("--perft <f> [d] [t] [h]", "-p<f>\t", "Check the perft results in EPD file f up\n\t\t\t\t  to depth d with t threads and h MB of\n\t\t\t\t  hash and exit.")
+                   OPTION_TEXT("--epd <f>\t", "-e<f>\t", "Run the test suite in EPD file f and exit.")
+                   OPTION_TEXT("--batch <f> [d] [n] [h]", "-B<f>\t", "Search the positions in EPD or FEN file f,\n\t\t\t\t  or stdin if f is -, to depth d or for n\n\t\t\t\t  nodes with h MB of hash, print the\n\t\t\t\t  results and exit.")
+                   OPTION_TEXT("--selfplay <f> [g] [n] [h]", "-G<f>\t", "Play g games against itself at n nodes per\n\t\t\t\t  move with h MB of hash per thread, append\n\t\t\t\t  the positions to training data file f\n\t\t\t\t  and exit.")
+                   OPTION_TEXT("--tune <f> [e]\t", "-T<f>\t", "Fit the evaluation to the games in training\n\t\t\t\t  data file f in e epochs, print the\n\t\t\t\t  parameters and exit.")
+                   OPTION_TEXT("--params <f>\t", "-P<f>\t", "Read the evaluation parameters from file f.")
+                   OPTION_TEXT("--time <t>\t", "-t<t>\t", "Search each test position for t seconds.")
+                   OPTION_TEXT("--threads <n>\t", "-j<n>\t", "Use n threads, or search n test positions\n\t\t\t\t  at once.")
+                   OPTION_TEXT("--server [h] [f]", "-s\t", "Play many games at once on stdin/stdout,\n\t\t\t\t  or Unix socket f, sharing h MB of hash.")
+                   OPTION_TEXT("--server-bench [g] [s] [h]", "-S\t", "Load test the server with g games of s\n\t\t\t\t  seconds and h MB of hash and exit.")
+                  );
+            exit(0);
+        case 'b':
+            run_bench = 1;
+            break;
+        case 'p':
+            perft_file = optarg;
+            break;
+        case 'e':
+            epd_file = optarg;
+            break;
+        case 'B':
+            batch_file = optarg;
+            break;
+        case 'G':
+            selfplay_file = optarg;
+            break;
+        case 'T':
+            tune_file = optarg;
+            break;
+        case 'P':
+            params_file = optarg;
+            break;
+        case 't':
+            epd_time = atof(optarg);
+            break;
+        case 'j':
+            threads = atoi(optarg);
+            break;
+        case 's':
+            run_server = 1;
+            break;
+        case 'S':
+            run_server_bench = 1;
+            break;
+        default:
+            exit(1);
+        }
+    }
+
     fprintf(stderr, "Dreamer v" PACKAGE_VERSION " (" GIT_REV ")\n");
 
     board_init();
     init_hash();
     move_init();
-    transposition_init(128);
+    attack_init();
+    endgame_init();
+
+    if (params_file && eval_params_read(params_file))
+        return 1;
+
+    if (run_bench)
+    {
+        int depth = next_arg(argc, argv, BENCH_DEFAULT_DEPTH);
+        int hash;
+
+        threads = next_arg(argc, argv, threads);
+        hash = next_arg(argc, argv, BENCH_DEFAULT_HASH);
+
+        transposition_init(hash);
+        return engine_bench(depth, threads, hash);
+    }
+
+    if (batch_file)
+    {
+        int depth = next_arg(argc, argv, BATCH_DEFAULT_DEPTH);
+        int nodes = next_arg(argc, argv, 0);
+
+        return batch_eval(batch_file, depth, nodes, threads,
+                          next_arg(argc, argv, BATCH_DEFAULT_HASH));
+    }
+
+    if (selfplay_file)
+    {
+        int games = next_arg(argc, argv, SELFPLAY_DEFAULT_GAMES);
+        int nodes = next_arg(argc, argv, SELFPLAY_DEFAULT_NODES);
+
+        return selfplay(selfplay_file, games, nodes, threads,
+                        next_arg(argc, argv, SELFPLAY_DEFAULT_HASH));
+    }
+
+    if (tune_file)
+        return tune(tune_file, next_arg(argc, argv, TUNE_DEFAULT_EPOCHS),
+                    threads);
+
+    if (run_server)
+    {
+        int hash = next_arg(argc, argv, SERVER_DEFAULT_HASH);
+
+        return server(optind < argc ? argv[optind] : NULL, threads, hash);
+    }
+
+    if (run_server_bench)
+    {
+        int games = next_arg(argc, argv, SERVER_BENCH_GAMES);
+        int clock = next_arg(argc, argv, SERVER_BENCH_CLOCK);
+
+        return server_bench(games, clock, threads,
+                            next_arg(argc, argv, SERVER_DEFAULT_HASH));
+    }
+
+    if (perft_file)
+    {
+        int depth = next_arg(argc, argv, MAX_DEPTH);
+        int hash;
+
+        threads = next_arg(argc, argv, threads);
+        hash = next_arg(argc, argv, 0);
+
+        return engine_perft(perft_file, depth, threads, hash);
+    }
+
+    if (epd_file)
+    {
+        transposition_init(SUITE_DEFAULT_HASH);
+        return engine_epd(epd_file, (int)(epd_time * 1000), threads);
+    }
+
+    transposition_init(TRANSPOSITION_DEFAULT_SIZE);
 
     /* return makebook("/home/walter/tmp/GM2001.pgn", "/home/walter/tmp/opening.dcb"); */
 
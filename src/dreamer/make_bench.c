@@ -0,0 +1,193 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Times board_make() and board_unmake() on positions from random games:
+** once for every pseudo-legal move of each position, and as a perft to
+** depth 3 from some of them. The search and perft only reach the board
+** through these two calls, so another way of taking moves back can be
+** compared by building this against it.
+**
+** Usage: make_bench [positions]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "instance.h"
+#include "board.h"
+#include "move.h"
+#include "commands.h"
+
+#define DEFAULT_POSITIONS 2048
+#define ROUNDS 5
+#define MAKE_PASSES 50
+#define PERFT_POSITIONS 64
+#define PERFT_DEPTH 3
+
+static board_t *positions;
+static int count;
+
+static long long now(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+/* Plays random moves from the starting position, and keeps the final
+** position of games that last long enough.
+*/
+static void make_positions(int wanted)
+{
+    positions = malloc(wanted * sizeof(board_t));
+    count = 0;
+    srand(3);
+
+    while (count < wanted)
+    {
+        dreamer_t *d = dreamer_new(1, NULL);
+        int plies = 10 + rand() % 40;
+        int ply;
+
+        for (ply = 0; ply < plies; ply++)
+        {
+            move_t list[MOVES_MAX];
+            int generated = move_generate(dreamer_board(d), list);
+            int tries;
+
+            if (generated <= 0)
+                break;
+
+            /* The list can hold moves that leave the king in check. */
+            for (tries = 0; tries < 20; tries++)
+            {
+                char *s = coord_move_str(list[rand() % generated]);
+                int illegal = dreamer_move(d, s);
+
+                free(s);
+                if (!illegal)
+                    break;
+            }
+
+            if (tries == 20)
+                break;
+        }
+
+        if (ply == plies)
+            positions[count++] = *dreamer_board(d);
+
+        dreamer_free(d);
+    }
+}
+
+/* Counts the leaves, the list holds MOVES_MAX moves per ply. */
+static long long perft(board_t *board, int depth, move_t *list)
+{
+    int generated = move_generate(board, list);
+    long long leaves = 0;
+    int i;
+
+    if (generated < 0)
+        return 0;
+
+    if (depth == 0)
+        return 1;
+
+    for (i = 0; i < generated; i++)
+    {
+        board_undo_t undo;
+
+        board_make(board, list[i], &undo);
+        leaves += perft(board, depth - 1, list + MOVES_MAX);
+        board_unmake(board, &undo);
+    }
+
+    return leaves;
+}
+
+int main(int argc, char **argv)
+{
+    static move_t list[(PERFT_DEPTH + 2) * MOVES_MAX];
+    move_t (*move_lists)[MOVES_MAX];
+    int *generated;
+    volatile long long sink = 0;
+    double best_make = 0, best_perft = 0;
+    int round, i;
+
+    dreamer_init();
+    make_positions(argc > 1 ? atoi(argv[1]) : DEFAULT_POSITIONS);
+
+    move_lists = malloc(count * sizeof(*move_lists));
+    generated = malloc(count * sizeof(int));
+
+    for (i = 0; i < count; i++)
+        generated[i] = move_generate(&positions[i], move_lists[i]);
+
+    /* The best of a few rounds, as other processes only make it slower. */
+    for (round = 0; round < ROUNDS; round++)
+    {
+        long long start = now();
+        long long made = 0, leaves = 0;
+        double ns;
+        int pass;
+
+        for (pass = 0; pass < MAKE_PASSES; pass++)
+            for (i = 0; i < count; i++)
+            {
+                int m;
+
+                for (m = 0; m < generated[i]; m++)
+                {
+                    board_undo_t undo;
+
+                    board_make(&positions[i], move_lists[i][m], &undo);
+                    sink += positions[i].hash_key;
+                    board_unmake(&positions[i], &undo);
+                    made++;
+                }
+            }
+
+        ns = (now() - start) * 1000.0 / made;
+        if (round == 0 || ns < best_make)
+            best_make = ns;
+
+        start = now();
+
+        for (i = 0; i < PERFT_POSITIONS && i < count; i++)
+            leaves += perft(&positions[i], PERFT_DEPTH, list);
+
+        ns = (now() - start) * 1000.0 / leaves;
+        if (round == 0 || ns < best_perft)
+            best_perft = ns;
+    }
+
+    printf("%i positions, board_t is %i bytes, board_undo_t %i bytes\n",
+           count, (int)sizeof(board_t), (int)sizeof(board_undo_t));
+    printf("Make and unmake    %6.1f ns per move\n", best_make);
+    printf("Perft to depth %i   %6.1f ns per leaf\n", PERFT_DEPTH, best_perft);
+
+    free(generated);
+    free(move_lists);
+    free(positions);
+    dreamer_exit();
+    return 0;
+}
@@ -0,0 +1,1245 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Plays games between two xboard engines and reports the score, an Elo
+** estimate and the state of a sequential probability ratio test, to tell
+** whether a change made the engine stronger. Games are played in pairs
+** from the same opening with colours reversed.
+**
+** Usage: dreamer-match [options] <engine1> <engine2>
+*/
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <math.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <pthread.h>
+
+#include "dreamer.h"
+#include "attack.h"
+#include "board.h"
+#include "commands.h"
+#include "endgame.h"
+#include "epd.h"
+#include "hashing.h"
+#include "move.h"
+#include "repetition.h"
+#include "search.h"
+#include "timer.h"
+#include "transposition.h"
+#include "pipe_unix.h"
+
+#define MATCH_GAMES 100
+#define MATCH_TIME_CONTROL "10+0.1"
+#define MATCH_OPENING_PLIES 8
+
+/* Games this long are drawn. */
+#define MATCH_MAX_PLIES 400
+
+/* An engine loses when its score is at most -score for this many moves. */
+#define MATCH_RESIGN "1000,3"
+
+/* A game is drawn when, from this move on, both engines' scores are
+** within score of 0 for this many moves each.
+*/
+#define MATCH_DRAW "40,8,10"
+
+/* Time to wait for an engine to start or answer a ping. */
+#define MATCH_INIT_MSEC 5000
+
+/* Time to wait for a move after the flag has fallen, before the engine is
+** considered hung and restarted.
+*/
+#define MATCH_HANG_MSEC 5000
+
+#define RESULT_WHITE_WINS SIDE_WHITE
+#define RESULT_BLACK_WINS SIDE_BLACK
+#define RESULT_DRAW 2
+
+typedef struct
+{
+    char *fen;    /* NULL for the starting position. */
+    int fullmove; /* Move number of the position. */
+    move_t *moves;
+    int count;
+}
+opening_t;
+
+typedef struct
+{
+    char *command;
+    char *name;
+    pipe_unix_t *pipe;
+    int fd_in, fd_out;
+    pid_t pid;
+    int usermove;
+    int ping;
+    int setboard;
+    int score;   /* Last score reported, for its own side. */
+    int scored;  /* A score was reported during the current move. */
+}
+engine_t;
+
+typedef struct
+{
+    char *s;
+    int len, size;
+    int line; /* Length of the last line. */
+}
+text_t;
+
+static char *engine_command[2];
+static char *engine_name[2];
+
+static opening_t *openings;
+static int opening_count;
+static int opening_plies = MATCH_OPENING_PLIES;
+
+static int games = MATCH_GAMES;
+static int workers = 1;
+static double base_sec, inc_sec;
+static int resign_score, resign_moves;
+static int draw_move, draw_moves, draw_score;
+static int sprt;
+static double sprt_elo0, sprt_elo1, sprt_alpha = 0.05, sprt_beta = 0.05;
+static FILE *pgn;
+
+/* Guards the counters, the output and the PGN file. */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* The SAN parser isn't reentrant. */
+static pthread_mutex_t san_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Move generation looks up the best move in a transposition table. This
+** one stays empty, all threads use it.
+*/
+static transposition_t *table;
+
+/* Keeps engines from inheriting each other's pipes. */
+static pthread_mutex_t fork_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int next_game;
+static int stopping;
+
+/* Results of the first engine. */
+static int wins, losses, draws;
+
+static void text_add(text_t *text, const char *fmt, ...)
+{
+    va_list ap;
+    int n;
+
+    while (1)
+    {
+        va_start(ap, fmt);
+        n = vsnprintf(text->s + text->len, text->size - text->len, fmt, ap);
+        va_end(ap);
+
+        if (n >= 0 && n < text->size - text->len)
+            break;
+
+        text->size = (n >= 0 ? text->len + n + 1 : text->size) * 2;
+        text->s = realloc(text->s, text->size);
+    }
+
+    text->len += n;
+}
+
+/* Adds a word of PGN movetext, breaking lines at 80 characters. */
+static void text_word(text_t *text, const char *word)
+{
+    int len = strlen(word);
+
+    if (text->line > 0 && text->line + 1 + len > 79)
+    {
+        text_add(text, "\n");
+        text->line = 0;
+    }
+
+    text_add(text, "%s%s", text->line > 0 ? " " : "", word);
+    text->line += (text->line > 0) + len;
+}
+
+static void opening_add(opening_t *opening)
+{
+    openings = realloc(openings, (opening_count + 1) * sizeof(opening_t));
+    openings[opening_count++] = *opening;
+}
+
+static int load_epd(FILE *f)
+{
+    char line[4096];
+
+    while (fgets(line, sizeof(line), f))
+    {
+        opening_t opening;
+        board_t board;
+        char *s = line + strspn(line, " \t");
+        char *ops;
+
+        if (!*s || *s == '\n' || *s == '#')
+            continue;
+
+        if (epd_parse(s, &board, &ops))
+        {
+            fprintf(stderr, "Invalid position: %s", line);
+            return 1;
+        }
+
+        opening.fen = malloc(ops - s + 5);
+        memcpy(opening.fen, s, ops - s);
+        strcpy(opening.fen + (ops - s), " 0 1");
+        opening.fullmove = 1;
+        opening.moves = NULL;
+        opening.count = 0;
+        opening_add(&opening);
+    }
+
+    return 0;
+}
+
+/* Reads the first moves of the main line of every game in a PGN file. */
+static int load_pgn(FILE *f)
+{
+    opening_t opening;
+    board_t board;
+    char word[256];
+    int depth = 0;
+    int c;
+
+    memset(&opening, 0, sizeof(opening));
+    opening.fullmove = 1;
+    setup_board(&board);
+
+    while ((c = getc(f)) != EOF)
+    {
+        int len = 0;
+
+        if (isspace(c))
+            continue;
+
+        if (c == '{')
+        {
+            while ((c = getc(f)) != EOF && c != '}');
+            continue;
+        }
+
+        if (c == ';' || c == '%')
+        {
+            while ((c = getc(f)) != EOF && c != '\n');
+            continue;
+        }
+
+        if (c == '(' || c == ')')
+        {
+            depth += (c == '(' ? 1 : -1);
+            continue;
+        }
+
+        if (c == '[')
+        {
+            char name[32], value[256];
+
+            while ((c = getc(f)) != EOF && c != ']' && len < (int)sizeof(word) - 1)
+                word[len++] = c;
+
+            word[len] = '\0';
+
+            if (sscanf(word, "%31s \"%255[^\"]\"", name, value) == 2
+                && !strcmp(name, "FEN"))
+            {
+                if (setup_board_fen(&board, value))
+                {
+                    fprintf(stderr, "Invalid FEN tag: %s\n", value);
+                    return 1;
+                }
+
+                opening.fen = strdup(value);
+
+                if (sscanf(value, "%*s %*s %*s %*s %*d %d", &opening.fullmove) != 1)
+                    opening.fullmove = 1;
+            }
+
+            continue;
+        }
+
+        do
+            word[len++] = c;
+        while ((c = getc(f)) != EOF && !isspace(c) && !strchr("{}()[];", c)
+               && len < (int)sizeof(word) - 1);
+
+        word[len] = '\0';
+
+        if (c != EOF && !isspace(c))
+            ungetc(c, f);
+
+        if (!strcmp(word, "1-0") || !strcmp(word, "0-1")
+            || !strcmp(word, "1/2-1/2") || !strcmp(word, "*"))
+        {
+            if (opening.count > 0 || opening.fen)
+                opening_add(&opening);
+            else
+                free(opening.moves);
+
+            memset(&opening, 0, sizeof(opening));
+            opening.fullmove = 1;
+            setup_board(&board);
+            depth = 0;
+            continue;
+        }
+
+        if (depth > 0 || *word == '$' || opening.count >= opening_plies)
+            continue;
+
+        /* Move numbers, maybe with a move attached as in "1.e4". */
+        if (isdigit((unsigned char)*word))
+        {
+            char *s = word + strspn(word, "0123456789");
+
+            if (*s != '.')
+                continue;
+
+            s += strspn(s, ".");
+            memmove(word, s, strlen(s) + 1);
+
+            if (!*word)
+                continue;
+        }
+
+        {
+            move_t move;
+
+            if (parse_move(&board, 0, word, &move) || move == NO_MOVE)
+            {
+                fprintf(stderr, "Illegal move in PGN: %s\n", word);
+                return 1;
+            }
+
+            execute_move(&board, move);
+            opening.moves = realloc(opening.moves,
+                                    (opening.count + 1) * sizeof(move_t));
+            opening.moves[opening.count++] = move;
+        }
+    }
+
+    free(opening.moves);
+    return 0;
+}
+
+static int load_openings(char *filename)
+{
+    FILE *f = fopen(filename, "r");
+    int len = strlen(filename);
+    int retval;
+
+    if (!f)
+    {
+        fprintf(stderr, "Error opening %s\n", filename);
+        return 1;
+    }
+
+    if (len > 4 && !strcmp(filename + len - 4, ".pgn"))
+        retval = load_pgn(f);
+    else
+        retval = load_epd(f);
+
+    fclose(f);
+
+    if (!retval && opening_count == 0)
+    {
+        fprintf(stderr, "No openings in %s\n", filename);
+        retval = 1;
+    }
+
+    return retval;
+}
+
+/* Handles the arguments of a "feature" command. Returns 1 when the engine
+** is done sending features.
+*/
+static int engine_features(engine_t *e, char *s)
+{
+    int done = 0;
+
+    while (*s)
+    {
+        char *name, *value;
+
+        s += strspn(s, " ");
+        name = s;
+        s = strchr(s, '=');
+
+        if (!s)
+            break;
+
+        *s++ = '\0';
+
+        if (*s == '"')
+        {
+            value = ++s;
+            s = strchr(s, '"');
+
+            if (!s)
+                break;
+
+            *s++ = '\0';
+        }
+        else
+        {
+            value = s;
+            s += strcspn(s, " ");
+
+            if (*s)
+                *s++ = '\0';
+        }
+
+        if (!strcmp(name, "myname"))
+        {
+            free(e->name);
+            e->name = strdup(value);
+        }
+        else if (!strcmp(name, "usermove"))
+            e->usermove = atoi(value);
+        else if (!strcmp(name, "ping"))
+            e->ping = atoi(value);
+        else if (!strcmp(name, "setboard"))
+            e->setboard = atoi(value);
+        else if (!strcmp(name, "done"))
+            done = atoi(value);
+
+        /* Moves are sent in coordinate notation. */
+        if (!strcmp(name, "san"))
+            pipe_unix_send_to(e->pipe, "rejected san\n");
+        else
+        {
+            pipe_unix_send_to(e->pipe, "accepted ");
+            pipe_unix_send_to(e->pipe, name);
+            pipe_unix_send_to(e->pipe, "\n");
+        }
+    }
+
+    return done;
+}
+
+static void engine_stop(engine_t *e)
+{
+    int i;
+
+    if (!e->pipe)
+        return;
+
+    pipe_unix_send_to(e->pipe, "quit\n");
+    pipe_unix_close(e->pipe);
+    close(e->fd_in);
+    close(e->fd_out);
+    e->pipe = NULL;
+
+    /* Give it a second to quit. */
+    for (i = 0; i < 100; i++)
+    {
+        if (waitpid(e->pid, NULL, WNOHANG) != 0)
+            return;
+
+        usleep(10000);
+    }
+
+    kill(e->pid, SIGKILL);
+    waitpid(e->pid, NULL, 0);
+}
+
+static int engine_start(engine_t *e)
+{
+    int to_child[2], from_child[2];
+    int i;
+
+    pthread_mutex_lock(&fork_lock);
+
+    if (pipe(to_child))
+    {
+        pthread_mutex_unlock(&fork_lock);
+        return 1;
+    }
+
+    if (pipe(from_child))
+    {
+        close(to_child[0]);
+        close(to_child[1]);
+        pthread_mutex_unlock(&fork_lock);
+        return 1;
+    }
+
+    /* Engines started by other threads must not keep our pipes open. */
+    for (i = 0; i < 2; i++)
+    {
+        fcntl(to_child[i], F_SETFD, FD_CLOEXEC);
+        fcntl(from_child[i], F_SETFD, FD_CLOEXEC);
+    }
+
+    e->pid = fork();
+
+    if (e->pid == 0)
+    {
+        dup2(to_child[0], 0);
+        dup2(from_child[1], 1);
+        execl("/bin/sh", "sh", "-c", e->command, (char *)NULL);
+        _exit(1);
+    }
+
+    pthread_mutex_unlock(&fork_lock);
+
+    close(to_child[0]);
+    close(from_child[1]);
+
+    if (e->pid < 0)
+    {
+        close(to_child[1]);
+        close(from_child[0]);
+        return 1;
+    }
+
+    e->fd_in = from_child[0];
+    e->fd_out = to_child[1];
+    e->pipe = pipe_unix_open(e->fd_in, e->fd_out);
+    e->usermove = 0;
+    e->ping = 0;
+    e->setboard = 0;
+
+    pipe_unix_send_to(e->pipe, "xboard\nprotover 2\n");
+
+    while (1)
+    {
+        int error;
+        char *s = pipe_unix_wait_from(e->pipe, MATCH_INIT_MSEC, &error);
+
+        if (error)
+        {
+            engine_stop(e);
+            return 1;
+        }
+
+        /* Engines that don't send features get the defaults. */
+        if (!s)
+            break;
+
+        if (!strncmp(s, "feature ", 8) && engine_features(e, s + 8))
+            break;
+    }
+
+    if (!e->name)
+    {
+        char *s = e->command + strcspn(e->command, " ");
+        char *base = s;
+
+        while (base > e->command && base[-1] != '/')
+            base--;
+
+        e->name = malloc(s - base + 1);
+        memcpy(e->name, base, s - base);
+        e->name[s - base] = '\0';
+    }
+
+    return 0;
+}
+
+/* Waits until the engine has handled everything sent to it. */
+static int engine_sync(engine_t *e)
+{
+    char ping[32];
+    char pong[32];
+
+    if (!e->ping)
+        return 0;
+
+    sprintf(ping, "ping %i\n", e->pid);
+    sprintf(pong, "pong %i", e->pid);
+    pipe_unix_send_to(e->pipe, ping);
+
+    while (1)
+    {
+        int error;
+        char *s = pipe_unix_wait_from(e->pipe, MATCH_INIT_MSEC, &error);
+
+        if (!s)
+            return 1;
+
+        if (!strcmp(s, pong))
+            return 0;
+    }
+}
+
+static void engine_move(engine_t *e, move_t move)
+{
+    char *s = coord_move_str(move);
+
+    if (e->usermove)
+        pipe_unix_send_to(e->pipe, "usermove ");
+
+    pipe_unix_send_to(e->pipe, s);
+    pipe_unix_send_to(e->pipe, "\n");
+    free(s);
+}
+
+static int insufficient_material(board_t *board)
+{
+    /* Kings and at most one minor piece, which is 300 or 350. */
+    return board->num_pawns[SIDE_WHITE] == 0 && board->num_pawns[SIDE_BLACK] == 0
+           && board->material_value[SIDE_WHITE] + board->material_value[SIDE_BLACK]
+              <= 2 * 2000 + 350;
+}
+
+/* Adds a move to the movetext of a game. */
+static void add_move(text_t *text, board_t *board, int fullmove, int first,
+                     move_t move)
+{
+    char number[16];
+    char *san = san_move_str(board, 1, move);
+
+    if (board->current_player == SIDE_WHITE)
+    {
+        sprintf(number, "%i.", fullmove);
+        text_word(text, number);
+    }
+    else if (first)
+    {
+        sprintf(number, "%i...", fullmove);
+        text_word(text, number);
+    }
+
+    text_word(text, san);
+    free(san);
+}
+
+/* Plays a game and returns the result. The reason is stored in reason and
+** the PGN movetext in text. Returns -1 if an engine can't be started.
+*/
+static int play_game(engine_t *engine, opening_t *opening, int index,
+                     char *reason, text_t *text)
+{
+    static const char *color[2] = {"White", "Black"};
+    engine_t *eng[2];
+    board_t board;
+    int clock[2];
+    int resign_count[2] = {0, 0};
+    int draw_count = 0;
+    int fullmove = (opening ? opening->fullmove : 1);
+    int plies = 0;
+    int result = RESULT_DRAW;
+    int restart[2] = {0, 0};
+    int i;
+
+    eng[SIDE_WHITE] = &engine[index % 2];
+    eng[SIDE_BLACK] = &engine[1 - index % 2];
+
+    for (i = 0; i < 2; i++)
+    {
+        if (!engine[i].pipe && engine_start(&engine[i]))
+        {
+            fprintf(stderr, "Failed to start %s\n", engine[i].command);
+            return -1;
+        }
+    }
+
+    if (opening && opening->fen)
+        setup_board_fen(&board, opening->fen);
+    else
+        setup_board(&board);
+
+    repetition_init(&board);
+
+    for (i = 0; i < 2; i++)
+    {
+        char level[64];
+
+        sprintf(level, "level 0 %i:%02i %g\n", (int)base_sec / 60,
+                (int)base_sec % 60, inc_sec);
+        pipe_unix_send_to(eng[i]->pipe, "new\nforce\neasy\npost\n");
+        pipe_unix_send_to(eng[i]->pipe, level);
+
+        if (opening && opening->fen)
+        {
+            if (!eng[i]->setboard)
+            {
+                fprintf(stderr, "%s doesn't support setboard\n",
+                        eng[i]->name);
+                return -1;
+            }
+
+            pipe_unix_send_to(eng[i]->pipe, "setboard ");
+            pipe_unix_send_to(eng[i]->pipe, opening->fen);
+            pipe_unix_send_to(eng[i]->pipe, "\n");
+        }
+    }
+
+    for (i = 0; opening && i < opening->count; i++)
+    {
+        move_t move = opening->moves[i];
+
+        add_move(text, &board, fullmove, i == 0, move);
+        engine_move(eng[SIDE_WHITE], move);
+        engine_move(eng[SIDE_BLACK], move);
+
+        if (board.current_player == SIDE_BLACK)
+            fullmove++;
+
+        execute_move(&board, move);
+        repetition_add(&board, move);
+        plies++;
+    }
+
+    for (i = 0; i < 2; i++)
+    {
+        if (engine_sync(eng[i]))
+        {
+            fprintf(stderr, "%s doesn't answer ping\n", eng[i]->name);
+            return -1;
+        }
+    }
+
+    clock[SIDE_WHITE] = clock[SIDE_BLACK] = (int)(base_sec * 1000);
+
+    while (1)
+    {
+        int side = board.current_player;
+        engine_t *e = eng[side];
+        char time[64];
+        char move_s[16] = "";
+        long long start, elapsed;
+        move_t move;
+
+        switch (check_game_state(&board, 0))
+        {
+        case STATE_MATE:
+            sprintf(reason, "%s mates", color[OPPONENT(side)]);
+            result = OPPONENT(side);
+            goto done;
+        case STATE_STALEMATE:
+            strcpy(reason, "Stalemate");
+            goto done;
+        }
+
+        switch (is_draw(&board))
+        {
+        case 1:
+            strcpy(reason, "Draw by 3-fold repetition");
+            goto done;
+        case 2:
+            strcpy(reason, "Draw by 50 move rule");
+            goto done;
+        }
+
+        if (insufficient_material(&board))
+        {
+            strcpy(reason, "Insufficient material");
+            goto done;
+        }
+
+        if (plies >= MATCH_MAX_PLIES)
+        {
+            strcpy(reason, "Draw by adjudication: game too long");
+            goto done;
+        }
+
+        sprintf(time, "time %i\notim %i\ngo\n", clock[side] / 10,
+                clock[OPPONENT(side)] / 10);
+        pipe_unix_send_to(e->pipe, time);
+        e->scored = 0;
+        start = timer_now();
+
+        while (!*move_s)
+        {
+            int error, ply, score, msec, nodes;
+            int wait = clock[side] - (int)(timer_now() - start)
+                       + MATCH_HANG_MSEC;
+            char *s = pipe_unix_wait_from(e->pipe, wait > 0 ? wait : 0, &error);
+
+            if (!s)
+            {
+                sprintf(reason, error ? "%s disconnects" : "%s loses on time",
+                        color[side]);
+                restart[side] = 1;
+                result = OPPONENT(side);
+                goto done;
+            }
+
+            if (!strncmp(s, "move ", 5))
+            {
+                strncpy(move_s, s + 5, sizeof(move_s) - 1);
+                move_s[sizeof(move_s) - 1] = '\0';
+
+                if (!*move_s)
+                    strcpy(move_s, "?");
+            }
+            else if (!strcmp(s, "resign"))
+            {
+                sprintf(reason, "%s resigns", color[side]);
+                result = OPPONENT(side);
+                goto done;
+            }
+            else if (sscanf(s, "%i %i %i %i", &ply, &score, &msec, &nodes) == 4)
+            {
+                e->score = score;
+                e->scored = 1;
+            }
+        }
+
+        elapsed = timer_now() - start;
+        clock[side] -= (int)elapsed;
+        pipe_unix_send_to(e->pipe, "force\n");
+
+        if (clock[side] < 0)
+        {
+            sprintf(reason, "%s loses on time", color[side]);
+            result = OPPONENT(side);
+            goto done;
+        }
+
+        clock[side] += (int)(inc_sec * 1000);
+
+        if (parse_coord_move(&board, 0, move_s, &move))
+        {
+            pthread_mutex_lock(&san_lock);
+
+            if (parse_move(&board, 0, move_s, &move))
+                move = NO_MOVE;
+
+            pthread_mutex_unlock(&san_lock);
+        }
+
+        if (move == NO_MOVE)
+        {
+            sprintf(reason, "%s makes an illegal move: %s", color[side],
+                    move_s);
+            result = OPPONENT(side);
+            goto done;
+        }
+
+        add_move(text, &board, fullmove, plies == 0, move);
+        engine_move(eng[OPPONENT(side)], move);
+
+        if (side == SIDE_BLACK)
+            fullmove++;
+
+        execute_move(&board, move);
+        repetition_add(&board, move);
+        plies++;
+
+        if (!e->scored)
+        {
+            resign_count[side] = 0;
+            draw_count = 0;
+            continue;
+        }
+
+        if (resign_moves > 0 && e->score <= -resign_score)
+        {
+            if (++resign_count[side] >= resign_moves)
+            {
+                sprintf(reason, "%s loses by adjudication", color[side]);
+                result = OPPONENT(side);
+                goto done;
+            }
+        }
+        else
+            resign_count[side] = 0;
+
+        if (draw_moves > 0 && fullmove > draw_move && abs(e->score) <= draw_score)
+        {
+            if (++draw_count >= 2 * draw_moves)
+            {
+                strcpy(reason, "Draw by adjudication");
+                goto done;
+            }
+        }
+        else
+            draw_count = 0;
+    }
+
+done:
+    for (i = 0; i < 2; i++)
+    {
+        if (restart[i])
+            engine_stop(eng[i]);
+        else
+        {
+            char s[256];
+
+            snprintf(s, sizeof(s), "result %s {%s}\n",
+                     result == RESULT_DRAW ? "1/2-1/2" :
+                     result == RESULT_WHITE_WINS ? "1-0" : "0-1", reason);
+            pipe_unix_send_to(eng[i]->pipe, s);
+        }
+    }
+
+    return result;
+}
+
+static double elo(double score)
+{
+    return 400 * log10(score / (1 - score));
+}
+
+/* Win, loss and draw probabilities in the BayesElo model. */
+static void bayes_elo(double elo, double draw_elo, double p[3])
+{
+    p[0] = 1 / (1 + pow(10, (draw_elo - elo) / 400));
+    p[1] = 1 / (1 + pow(10, (draw_elo + elo) / 400));
+    p[2] = 1 - p[0] - p[1];
+}
+
+/* Log-likelihood ratio of elo1 against elo0, with the draw rate taken from
+** the results.
+*/
+static double sprt_llr(int w, int l, int d)
+{
+    double n = w + l + d;
+    double draw_elo, x, scale;
+    double p0[3], p1[3];
+
+    if (w == 0 || l == 0 || d == 0)
+        return 0;
+
+    draw_elo = 200 * log10((1 - l / n) / (l / n) * (1 - w / n) / (w / n));
+    x = pow(10, -draw_elo / 400);
+    scale = 4 * x / ((1 + x) * (1 + x));
+
+    bayes_elo(sprt_elo0 / scale, draw_elo, p0);
+    bayes_elo(sprt_elo1 / scale, draw_elo, p1);
+
+    return w * log(p1[0] / p0[0]) + l * log(p1[1] / p0[1])
+           + d * log(p1[2] / p0[2]);
+}
+
+static void print_score(void)
+{
+    int n = wins + losses + draws;
+    double score = (wins + draws / 2.0) / n;
+
+    printf("Score of %s vs %s: %i - %i - %i  [%.3f] %i\n", engine_name[0],
+           engine_name[1], wins, losses, draws, score, n);
+
+    if (sprt)
+    {
+        double llr = sprt_llr(wins, losses, draws);
+        double lower = log(sprt_beta / (1 - sprt_alpha));
+        double upper = log((1 - sprt_beta) / sprt_alpha);
+
+        printf("SPRT: llr %.2f (%.2f, %.2f)", llr, lower, upper);
+
+        if (llr >= upper || llr <= lower)
+        {
+            printf(", %s accepted", llr >= upper ? "H1" : "H0");
+            stopping = 1;
+        }
+
+        printf("\n");
+    }
+}
+
+static void print_elo(void)
+{
+    int n = wins + losses + draws;
+    double score, var, margin;
+
+    if (n == 0)
+        return;
+
+    score = (wins + draws / 2.0) / n;
+    var = (wins * (1 - score) * (1 - score) + losses * score * score
+           + draws * (0.5 - score) * (0.5 - score)) / n;
+    margin = 1.96 * sqrt(var / n);
+
+    if (score <= 0 || score >= 1)
+        printf("Elo difference: %s\n", score <= 0 ? "-inf" : "inf");
+    else
+    {
+        double low = (score - margin > 0 ? score - margin : 1e-9);
+        double high = (score + margin < 1 ? score + margin : 1 - 1e-9);
+
+        printf("Elo difference: %.1f +/- %.1f\n", elo(score),
+               (elo(high) - elo(low)) / 2);
+    }
+
+    if (wins + losses > 0)
+        printf("LOS: %.1f %%\n", 50 * (1 + erf((wins - losses)
+                                              / sqrt(2.0 * (wins + losses)))));
+}
+
+static void write_pgn(int index, engine_t *engine, int result, char *reason,
+                      text_t *text, opening_t *opening)
+{
+    static const char *results[3] = {"1-0", "0-1", "1/2-1/2"};
+    char date[16];
+    time_t now = time(NULL);
+    struct tm tm;
+
+    localtime_r(&now, &tm);
+    strftime(date, sizeof(date), "%Y.%m.%d", &tm);
+
+    fprintf(pgn, "[Event \"dreamer-match\"]\n[Site \"?\"]\n[Date \"%s\"]\n"
+            "[Round \"%i\"]\n[White \"%s\"]\n[Black \"%s\"]\n"
+            "[Result \"%s\"]\n", date, index + 1, engine[index % 2].name,
+            engine[1 - index % 2].name, results[result]);
+
+    if (opening && opening->fen)
+        fprintf(pgn, "[FEN \"%s\"]\n[SetUp \"1\"]\n", opening->fen);
+
+    fprintf(pgn, "[TimeControl \"%g+%g\"]\n\n", base_sec, inc_sec);
+
+    text_word(text, "{");
+    text_add(text, "%s}", reason);
+    text->line += strlen(reason) + 1;
+    text_word(text, results[result]);
+    fprintf(pgn, "%s\n\n", text->s);
+    fflush(pgn);
+}
+
+static void *match_worker(void *arg)
+{
+    engine_t engine[2];
+    int i;
+
+    memset(engine, 0, sizeof(engine));
+    engine[0].command = engine_command[0];
+    engine[1].command = engine_command[1];
+
+    move_stack_init(MAX_DEPTH + QUIESCE_PLIES);
+    transposition_bind(table);
+
+    while (1)
+    {
+        opening_t *opening = NULL;
+        text_t text;
+        char reason[128];
+        int index, result;
+
+        pthread_mutex_lock(&lock);
+
+        if (stopping || next_game >= games)
+        {
+            pthread_mutex_unlock(&lock);
+            break;
+        }
+
+        index = next_game++;
+        pthread_mutex_unlock(&lock);
+
+        if (opening_count > 0)
+            opening = &openings[index / 2 % opening_count];
+
+        memset(&text, 0, sizeof(text));
+        text_add(&text, "%s", "");
+        result = play_game(engine, opening, index, reason, &text);
+
+        pthread_mutex_lock(&lock);
+
+        if (result < 0)
+            stopping = 1;
+        else
+        {
+            /* The first engine plays white in even games. */
+            int first = (index % 2 == 0 ? SIDE_WHITE : SIDE_BLACK);
+
+            for (i = 0; i < 2; i++)
+                if (!engine_name[i])
+                    engine_name[i] = strdup(engine[i].name);
+
+            if (result == RESULT_DRAW)
+                draws++;
+            else if (result == first)
+                wins++;
+            else
+                losses++;
+
+            printf("Finished game %i (%s vs %s): %s {%s}\n", index + 1,
+                   engine[index % 2].name, engine[1 - index % 2].name,
+                   result == RESULT_DRAW ? "1/2-1/2" :
+                   result == RESULT_WHITE_WINS ? "1-0" : "0-1", reason);
+            print_score();
+            fflush(stdout);
+
+            if (pgn)
+                write_pgn(index, engine, result, reason, &text, opening);
+        }
+
+        pthread_mutex_unlock(&lock);
+        free(text.s);
+    }
+
+    for (i = 0; i < 2; i++)
+    {
+        engine_stop(&engine[i]);
+        free(engine[i].name);
+    }
+
+    transposition_bind(NULL);
+    move_stack_exit();
+    repetition_exit();
+    return NULL;
+}
+
+static void usage(void)
+{
+    printf("Usage: dreamer-match [options] <engine1> <engine2>\n\n"
+           "Plays games between two xboard engines, given as shell commands.\n\n"
+           "Options:\n"
+           "  -g<n>\t\tPlay n games (default %i).\n"
+           "  -j<n>\t\tPlay n games at once (default 1).\n"
+           "  -t<b+i>\tGive b seconds per game plus i per move (default %s).\n"
+           "  -o<f>\t\tStart from the openings in EPD or PGN file f.\n"
+           "  -p<n>\t\tUse the first n plies of PGN openings (default %i).\n"
+           "  -w<f>\t\tWrite the games to PGN file f.\n"
+           "  -s<e0,e1>\tStop when an SPRT of elo e0 against e1 decides.\n"
+           "  -a<a,b>\tUse alpha a and beta b for the SPRT (default 0.05,0.05).\n"
+           "  -r<s,n>\tAdjudicate a loss after n moves with a score of at\n"
+           "\t\tmost -s, 0 to disable (default %s).\n"
+           "  -d<m,n,s>\tAdjudicate a draw after move m and n moves with a\n"
+           "\t\tscore within s, 0 to disable (default %s).\n",
+           MATCH_GAMES, MATCH_TIME_CONTROL, MATCH_OPENING_PLIES, MATCH_RESIGN,
+           MATCH_DRAW);
+}
+
+int main(int argc, char **argv)
+{
+    pthread_t *thread;
+    char *opening_file = NULL;
+    char *pgn_file = NULL;
+    char *tc = MATCH_TIME_CONTROL;
+    char *resign = MATCH_RESIGN;
+    char *draw = MATCH_DRAW;
+    int c, i;
+
+    while ((c = getopt(argc, argv, "hg:j:t:o:p:w:s:a:r:d:")) > -1)
+    {
+        switch (c)
+        {
+        case 'g':
+            games = atoi(optarg);
+            break;
+        case 'j':
+            workers = atoi(optarg);
+            break;
+        case 't':
+            tc = optarg;
+            break;
+        case 'o':
+            opening_file = optarg;
+            break;
+        case 'p':
+            opening_plies = atoi(optarg);
+            break;
+        case 'w':
+            pgn_file = optarg;
+            break;
+        case 's':
+            if (sscanf(optarg, "%lf,%lf", &sprt_elo0, &sprt_elo1) != 2)
+            {
+                usage();
+                return 1;
+            }
+            sprt = 1;
+            break;
+        case 'a':
+            if (sscanf(optarg, "%lf,%lf", &sprt_alpha, &sprt_beta) != 2)
+            {
+                usage();
+                return 1;
+            }
+            break;
+        case 'r':
+            resign = optarg;
+            break;
+        case 'd':
+            draw = optarg;
+            break;
+        case 'h':
+            usage();
+            return 0;
+        default:
+            usage();
+            return 1;
+        }
+    }
+
+    if (argc - optind != 2 || workers < 1
+        || sscanf(tc, "%lf+%lf", &base_sec, &inc_sec) < 1)
+    {
+        usage();
+        return 1;
+    }
+
+    if (sscanf(resign, "%i,%i", &resign_score, &resign_moves) != 2)
+        resign_moves = 0;
+
+    if (sscanf(draw, "%i,%i,%i", &draw_move, &draw_moves, &draw_score) != 3)
+        draw_moves = 0;
+
+    engine_command[0] = argv[optind];
+    engine_command[1] = argv[optind + 1];
+
+    board_init();
+    init_hash();
+    move_init();
+    attack_init();
+    endgame_init();
+    move_stack_init(MAX_DEPTH + QUIESCE_PLIES);
+
+    if (!(table = transposition_new(1)))
+        return 1;
+
+    transposition_bind(table);
+
+    if (opening_file && load_openings(opening_file))
+        return 1;
+
+    if (pgn_file && !(pgn = fopen(pgn_file, "a")))
+    {
+        fprintf(stderr, "Error opening %s\n", pgn_file);
+        return 1;
+    }
+
+    /* Engines may go away at any time. */
+    signal(SIGPIPE, SIG_IGN);
+
+    thread = malloc(workers * sizeof(pthread_t));
+
+    for (i = 0; i < workers; i++)
+        pthread_create(&thread[i], NULL, match_worker, NULL);
+
+    for (i = 0; i < workers; i++)
+        pthread_join(thread[i], NULL);
+
+    if (pgn)
+        fclose(pgn);
+
+    if (wins + losses + draws == 0)
+        return 1;
+
+    print_elo();
+
+    return 0;
+}
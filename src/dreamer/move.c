@@ -39,10 +39,19 @@ int **king_moves;
 int **white_pawn_capture_moves;
 int **black_pawn_capture_moves;
 
-/* Global move list. Add 1 for in_check function */
-move_t moves[(MAX_DEPTH + 1) * 256];
-int moves_start[MAX_DEPTH + 2];
-int moves_cur[MAX_DEPTH + 1];
+/* Move lists, MOVES_MAX per ply. */
+THREAD_LOCAL move_t *moves;
+THREAD_LOCAL int *moves_start;
+THREAD_LOCAL int *moves_cur;
+static THREAD_LOCAL int move_plies;
+
+/* The command parser and the check for the end of the game can work up to
+** two plies beyond the search.
+*/
+#define MOVE_STACK_EXTRA 2
+
+/* Plies that are available outside of a search. */
+#define MOVE_STACK_MIN 8
 
 #define add_moves_ray(FUNCNAME, MOVES, PIECE, PLAYER, OPPONENT_FIND, LOOP) \
 static move_t * \
@@ -321,9 +330,9 @@ add_black_castle_moves(board_t *board, move_t *move)
 }
 
 int
-compute_legal_moves(board_t *board, int ply)
+move_generate(board_t *board, move_t *list)
 {
-	move_t *move = &moves[moves_start[ply]];
+	move_t *move = list;
 
 	if (board->current_player == SIDE_WHITE)
 	{
@@ -350,12 +359,23 @@ compute_legal_moves(board_t *board, int ply)
 			return -1;
 	}
 
-	moves_start[ply + 1] = moves_start[ply] + move - &moves[moves_start[ply]];
+	return move - list;
+}
+
+int
+compute_legal_moves(board_t *board, int ply)
+{
+	int count = move_generate(board, &moves[moves_start[ply]]);
+
+	if (count < 0)
+		return -1;
+
+	moves_start[ply + 1] = moves_start[ply] + count;
 	moves_cur[ply] = moves_start[ply];
 	return 0;
 }
 
-move_t move_next(board_t *board, int ply)
+move_t move_next(board_t *board, int ply, attack_map_t *map)
 {
 	if (moves_cur[ply] == moves_start[ply + 1])
 		return NO_MOVE;
@@ -366,7 +386,7 @@ move_t move_next(board_t *board, int ply)
 		if (move != NO_MOVE)
 			best_first(ply, move);
 	} else
-		sort_next(ply, board->current_player);
+		sort_next(ply, board->current_player, map);
 
 	return moves[moves_cur[ply]++];
 }
@@ -384,9 +404,36 @@ void list_moves(int ply)
 }
 #endif
 
+void
+move_stack_init(int plies)
+{
+	if (plies <= move_plies)
+		return;
+
+	moves = realloc(moves, (plies + MOVE_STACK_EXTRA) * MOVES_MAX * sizeof(move_t));
+	moves_start = realloc(moves_start, (plies + MOVE_STACK_EXTRA + 1) * sizeof(int));
+	moves_cur = realloc(moves_cur, (plies + MOVE_STACK_EXTRA) * sizeof(int));
+	moves_start[0] = 0;
+	move_plies = plies;
+}
+
+void
+move_stack_exit(void)
+{
+	free(moves);
+	free(moves_start);
+	free(moves_cur);
+	moves = NULL;
+	moves_start = NULL;
+	moves_cur = NULL;
+	move_plies = 0;
+}
+
 void
 move_init(void)
 {
+	move_stack_init(MOVE_STACK_MIN);
+
 	rook_moves = all_rook_moves();
 	knight_moves = all_knight_moves();
 	king_moves = all_king_moves();
@@ -21,6 +21,7 @@
 #ifndef MOVE_H
 #define MOVE_H
 
+#include "attack.h"
 #include "board.h"
 #include "dreamer.h"
 
@@ -62,20 +63,60 @@
 
 #define MOVE_IS_REGULAR(M) (((M) != NO_MOVE) && ((M) != RESIGN_MOVE) && ((M) != STALEMATE_MOVE))
 
-extern move_t moves[(MAX_DEPTH + 1) * 256];
-extern int moves_start[MAX_DEPTH + 2];
-extern int moves_cur[MAX_DEPTH + 1];
+/* Maximum number of moves generated for a single position. */
+#define MOVES_MAX 256
+
+/* Move lists of the plies of the current thread. */
+extern THREAD_LOCAL move_t *moves;
+extern THREAD_LOCAL int *moves_start;
+extern THREAD_LOCAL int *moves_cur;
 
 void
 move_init(void);
 
+void
+move_stack_init(int plies);
+/* Makes sure that the move lists of the current thread have room for a
+** number of plies. The lists only grow, so this is cheap when called at
+** the start of every search.
+** Parameters: (int) plies: Number of plies.
+** Returns   : (void)
+*/
+
+void
+move_stack_exit(void);
+/* Frees the move lists of the current thread.
+** Parameters: (void)
+** Returns   : (void)
+*/
+
 void
 move_exit(void);
 
+int
+move_generate(board_t *board, move_t *list);
+/* Generates the pseudo-legal moves of a position into a list. Unlike
+** compute_legal_moves this doesn't touch any global state, so it can be
+** used from several threads at once.
+** Parameters: (board_t *) board: The position.
+**             (move_t *) list: Array of at least MOVES_MAX entries.
+** Returns   : (int) The number of moves, or -1 if the side to move can
+**                 capture the king, i.e. the position is illegal.
+*/
+
 int
 compute_legal_moves(board_t *board, int ply);
 
 move_t
-move_next(board_t *board, int ply);
+move_next(board_t *board, int ply, attack_map_t *map);
+/* Returns the next move of the list made by compute_legal_moves, best
+** first.
+** Parameters: (board_t *) board: The position.
+**             (int) ply: The ply the list was made for.
+**             (attack_map_t *) map: Attacks of the position, or NULL. With
+**                 them, captures of defended pieces by more valuable ones
+**                 go after the other captures.
+** Returns   : (move_t) The move, or NO_MOVE if there are no more moves.
+*/
 
 #endif /* MOVE_H */
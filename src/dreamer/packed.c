@@ -0,0 +1,366 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+
+#ifdef HAVE_SYS_MMAN_H
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif /* HAVE_SYS_MMAN_H */
+
+#include "board.h"
+#include "hashing.h"
+#include "packed.h"
+
+/* Positions that are buffered before they're written. */
+#define PACKED_BUFFER 4096
+
+struct packed_writer
+{
+    FILE *f;
+    int len;
+    int error;
+    packed_t buf[PACKED_BUFFER];
+};
+
+void packed_encode(packed_t *p, board_t *board, int score, int result,
+                   int ply)
+{
+    bitboard_t pieces[NR_PIECES];
+    int nibble = 0;
+    int i;
+
+    memcpy(pieces, board->bitboard, sizeof(pieces));
+
+    /* Right after castling, phantom kings stand on the squares that the
+    ** king crossed. They're not part of the position.
+    */
+    pieces[WHITE_KING] = board_king(board, SIDE_WHITE);
+    pieces[BLACK_KING] = board_king(board, SIDE_BLACK);
+
+    memset(p, 0, sizeof(packed_t));
+
+    for (i = 0; i < 64; i++)
+    {
+        int piece;
+
+        for (piece = 0; piece < NR_PIECES; piece++)
+            if (pieces[piece] & square_bit[i])
+                break;
+
+        if (piece == NR_PIECES)
+            continue;
+
+        p->data[i / 8] |= 1 << (i % 8);
+
+        /* A legal position has at most 32 pieces. */
+        if (nibble < 32)
+        {
+            p->data[8 + nibble / 2] |= piece << (nibble % 2 * 4);
+            nibble++;
+        }
+    }
+
+    if (score > 32767)
+        score = 32767;
+    if (score < -32767)
+        score = -32767;
+
+    p->data[24] = score & 0xff;
+    p->data[25] = (score >> 8) & 0xff;
+    p->data[26] = result;
+    p->data[27] = board->current_player | (board->castle_flags & 63) << 1;
+    p->data[28] = 64;
+
+    for (i = 0; i < 64; i++)
+        if (board->en_passant & square_bit[i])
+            p->data[28] = i;
+
+    p->data[29] = (board->fifty_moves < 255 ? board->fifty_moves : 255);
+    p->data[30] = ply & 0xff;
+    p->data[31] = (ply >> 8) & 0xff;
+}
+
+int packed_decode(const packed_t *p, board_t *board, int *score,
+                  int *result)
+{
+    int nibble = 0;
+    int i;
+
+    clear_board(board);
+
+    for (i = 0; i < 64; i++)
+    {
+        int piece;
+
+        if (!(p->data[i / 8] & (1 << (i % 8))))
+            continue;
+
+        if (nibble == 32)
+            return 1;
+
+        piece = (p->data[8 + nibble / 2] >> (nibble % 2 * 4)) & 15;
+        nibble++;
+
+        if (piece >= NR_PIECES)
+            return 1;
+
+        board_add_piece(board, i, piece);
+    }
+
+    if (p->data[26] > PACKED_WHITE_WINS || p->data[27] > 127
+        || p->data[28] > 64)
+        return 1;
+
+    if (!board->bitboard[WHITE_KING] || !board->bitboard[BLACK_KING])
+        return 1;
+
+    board->current_player = p->data[27] & 1;
+    board->castle_flags = p->data[27] >> 1;
+    board->en_passant = (p->data[28] < 64 ? square_bit[p->data[28]] : 0);
+    board->fifty_moves = p->data[29];
+    board->hash_key = hash_key(board);
+
+    if (score)
+        *score = packed_score(p);
+
+    if (result)
+        *result = p->data[26];
+
+    return 0;
+}
+
+int packed_score(const packed_t *p)
+{
+    return (short)(p->data[24] | p->data[25] << 8);
+}
+
+int packed_result(const packed_t *p)
+{
+    return p->data[26];
+}
+
+int packed_side(const packed_t *p)
+{
+    return p->data[27] & 1;
+}
+
+void packed_set_result(packed_t *p, int result)
+{
+    p->data[26] = result;
+}
+
+packed_writer_t *packed_writer_open(char *filename)
+{
+    packed_writer_t *w = malloc(sizeof(packed_writer_t));
+
+    if (!w)
+        return NULL;
+
+    w->f = fopen(filename, "ab");
+
+    if (!w->f)
+    {
+        free(w);
+        return NULL;
+    }
+
+    w->len = 0;
+    w->error = 0;
+    return w;
+}
+
+static void packed_flush(packed_writer_t *w)
+{
+    if (w->len > 0 && fwrite(w->buf, sizeof(packed_t), w->len, w->f)
+                      != (size_t)w->len)
+        w->error = 1;
+
+    w->len = 0;
+}
+
+int packed_write(packed_writer_t *w, const packed_t *p, int count)
+{
+    while (count > 0)
+    {
+        int n = PACKED_BUFFER - w->len;
+
+        if (n > count)
+            n = count;
+
+        memcpy(w->buf + w->len, p, n * sizeof(packed_t));
+        w->len += n;
+        p += n;
+        count -= n;
+
+        if (w->len == PACKED_BUFFER)
+            packed_flush(w);
+    }
+
+    return w->error;
+}
+
+int packed_writer_close(packed_writer_t *w)
+{
+    int error;
+
+    packed_flush(w);
+
+    if (fclose(w->f))
+        w->error = 1;
+
+    error = w->error;
+    free(w);
+    return error;
+}
+
+int packed_map(packed_file_t *f, char *filename)
+{
+#ifdef HAVE_SYS_MMAN_H
+    struct stat st;
+    int fd = open(filename, O_RDONLY);
+
+    if (fd < 0)
+        return 1;
+
+    if (fstat(fd, &st) || st.st_size % PACKED_SIZE)
+    {
+        close(fd);
+        return 1;
+    }
+
+    f->size = st.st_size;
+    f->mapped = 1;
+    f->mem = NULL;
+
+    if (f->size > 0)
+    {
+        f->mem = mmap(NULL, f->size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (f->mem == MAP_FAILED)
+        {
+            close(fd);
+            return 1;
+        }
+    }
+
+    close(fd);
+#else
+    FILE *file = fopen(filename, "rb");
+
+    if (!file)
+        return 1;
+
+    if (fseek(file, 0, SEEK_END) || (f->size = ftell(file)) < 0
+        || f->size % PACKED_SIZE || fseek(file, 0, SEEK_SET))
+    {
+        fclose(file);
+        return 1;
+    }
+
+    f->mapped = 0;
+    f->mem = malloc(f->size > 0 ? f->size : 1);
+
+    if (!f->mem || fread(f->mem, 1, f->size, file) != (size_t)f->size)
+    {
+        free(f->mem);
+        fclose(file);
+        return 1;
+    }
+
+    fclose(file);
+#endif /* HAVE_SYS_MMAN_H */
+
+    f->pos = f->mem;
+    f->count = f->size / PACKED_SIZE;
+    return 0;
+}
+
+void packed_unmap(packed_file_t *f)
+{
+#ifdef HAVE_SYS_MMAN_H
+    if (f->mapped && f->size > 0)
+        munmap(f->mem, f->size);
+#endif /* HAVE_SYS_MMAN_H */
+
+    if (!f->mapped)
+        free(f->mem);
+
+    f->pos = NULL;
+    f->count = 0;
+}
+
+static unsigned long long splitmix(unsigned long long *x)
+{
+    unsigned long long z = (*x += 0x9e3779b97f4a7c15ULL);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+void packed_shuffle_init(packed_shuffle_t *s, unsigned long long count,
+                         unsigned long long seed)
+{
+    int bits = 1;
+    int i;
+
+    while (bits < 64 && (1ULL << bits) < count)
+        bits++;
+
+    s->count = count;
+    s->mask = (bits < 64 ? (1ULL << bits) - 1 : ~0ULL);
+    s->shift = bits / 2 + 1;
+
+    for (i = 0; i < 4; i++)
+    {
+        s->mul[i] = splitmix(&seed) | 1;
+        s->add[i] = splitmix(&seed);
+    }
+}
+
+unsigned long long packed_shuffle(const packed_shuffle_t *s,
+                                  unsigned long long i)
+{
+    /* Each round is a bijection on the smallest power of two that holds
+    ** count. Values past count are mapped again until they fall inside,
+    ** which keeps it a bijection on 0 to count - 1 and takes less than two
+    ** tries on average.
+    */
+    do
+    {
+        int r;
+
+        for (r = 0; r < 4; r++)
+        {
+            i = (i * s->mul[r] + s->add[r]) & s->mask;
+            i ^= i >> s->shift;
+        }
+    }
+    while (i >= s->count);
+
+    return i;
+}
@@ -0,0 +1,163 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PACKED_H
+#define PACKED_H
+
+#include "board.h"
+
+/* Training positions, packed into 32 bytes each so that files of billions
+** of positions can be memory-mapped and read in any order. All numbers are
+** little-endian:
+**
+**   0-7    Occupied squares, bit 0 is a1.
+**   8-23   Piece on each occupied square in 4 bits, as numbered in board.h,
+**          from a1 up. The first square is in the low bits of byte 8.
+**   24-25  Search score in centipawns for white, signed.
+**   26     Result of the game, PACKED_BLACK_WINS to PACKED_WHITE_WINS.
+**   27     Side to move in bit 0, castling flags 0-5 in bits 1-6.
+**   28     En-passant square, or 64 for none.
+**   29     50-move counter.
+**   30-31  Ply of the game.
+*/
+#define PACKED_SIZE 32
+
+#define PACKED_BLACK_WINS 0
+#define PACKED_DRAW 1
+#define PACKED_WHITE_WINS 2
+
+typedef struct
+{
+    unsigned char data[PACKED_SIZE];
+}
+packed_t;
+
+typedef struct packed_writer packed_writer_t;
+
+typedef struct
+{
+    const packed_t *pos;
+    long long count;
+    void *mem;  /* Mapping or buffer that pos points into. */
+    long long size;
+    int mapped;
+}
+packed_file_t;
+
+typedef struct
+{
+    unsigned long long count;
+    unsigned long long mask;
+    int shift;
+    unsigned long long mul[4];
+    unsigned long long add[4];
+}
+packed_shuffle_t;
+
+void packed_encode(packed_t *p, board_t *board, int score, int result,
+                   int ply);
+/* Packs a position.
+** Parameters: (packed_t *) p: Where to store the packed position.
+**             (board_t *) board: The position.
+**             (int) score: Search score in centipawns for white. It's
+**                 clamped to 16 bits.
+**             (int) result: Result of the game.
+**             (int) ply: Ply of the game.
+** Returns   : (void)
+*/
+
+int packed_decode(const packed_t *p, board_t *board, int *score,
+                  int *result);
+/* Unpacks a position.
+** Parameters: (const packed_t *) p: The packed position.
+**             (board_t *) board: Where to store the position.
+**             (int *) score: Where to store the score for white, or NULL.
+**             (int *) result: Where to store the result, or NULL.
+** Returns   : (int) 0 on success, 1 if the data is not a valid position.
+*/
+
+int packed_score(const packed_t *p);
+/* Returns the score for white of a packed position. */
+
+int packed_result(const packed_t *p);
+/* Returns the result of the game of a packed position. */
+
+int packed_side(const packed_t *p);
+/* Returns the side to move of a packed position. */
+
+void packed_set_result(packed_t *p, int result);
+/* Sets the result of the game of a packed position. */
+
+packed_writer_t *packed_writer_open(char *filename);
+/* Opens a file to append positions to.
+** Parameters: (char *) filename: The file.
+** Returns   : (packed_writer_t *) The writer, or NULL if the file can't be
+**                 opened.
+*/
+
+int packed_write(packed_writer_t *w, const packed_t *p, int count);
+/* Appends positions. They're buffered and written in large blocks.
+** Parameters: (packed_writer_t *) w: The writer.
+**             (const packed_t *) p: The positions.
+**             (int) count: The number of positions.
+** Returns   : (int) 0 on success, 1 on a write error.
+*/
+
+int packed_writer_close(packed_writer_t *w);
+/* Writes the buffered positions and closes the file.
+** Parameters: (packed_writer_t *) w: The writer.
+** Returns   : (int) 0 on success, 1 if a write failed.
+*/
+
+int packed_map(packed_file_t *f, char *filename);
+/* Maps a file of packed positions into memory. Where there is no mmap()
+** the file is read instead.
+** Parameters: (packed_file_t *) f: Where to store the mapping.
+**             (char *) filename: The file.
+** Returns   : (int) 0 on success, 1 if the file can't be read or isn't a
+**                 whole number of positions.
+*/
+
+void packed_unmap(packed_file_t *f);
+/* Unmaps a file mapped with packed_map().
+** Parameters: (packed_file_t *) f: The mapping.
+** Returns   : (void)
+*/
+
+void packed_shuffle_init(packed_shuffle_t *s, unsigned long long count,
+                         unsigned long long seed);
+/* Sets up a random permutation of 0 to count - 1. It takes no memory, so
+** any number of positions can be read in random order, and threads can
+** each take a range of the permutation.
+** Parameters: (packed_shuffle_t *) s: The permutation.
+**             (unsigned long long) count: Number of elements.
+**             (unsigned long long) seed: Picks the permutation.
+** Returns   : (void)
+*/
+
+unsigned long long packed_shuffle(const packed_shuffle_t *s,
+                                  unsigned long long i);
+/* Returns element i of a permutation.
+** Parameters: (const packed_shuffle_t *) s: The permutation.
+**             (unsigned long long) i: Index, less than the count.
+** Returns   : (unsigned long long) The element.
+*/
+
+#endif /* PACKED_H */
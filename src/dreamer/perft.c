@@ -0,0 +1,302 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "board.h"
+#include "move.h"
+#include "commands.h"
+#include "e_comm.h"
+#include "epd.h"
+#include "perft.h"
+#include "timer.h"
+
+/* Hash table entry. The check is the hash key xor'ed with the data, so an
+** entry that was torn by two threads writing it at once won't match.
+*/
+typedef struct perft_entry
+{
+    unsigned long long check;
+    unsigned long long data;
+}
+perft_entry_t;
+
+/* Shared between all workers of a perft run. */
+typedef struct perft_job
+{
+    board_t board;
+    int depth;
+    move_t root[MOVES_MAX];
+    long long nodes[MOVES_MAX];
+    int count;
+    int next;
+    perft_entry_t *table;
+    unsigned long long mask;
+}
+perft_job_t;
+
+static long long perft_node(perft_job_t *job, board_t *board, int depth,
+                            move_t *list)
+{
+    int count = move_generate(board, list);
+    unsigned long long data;
+    perft_entry_t *entry = NULL;
+    long long nodes = 0;
+    int i;
+
+    /* The previous move left the king in check. */
+    if (count < 0)
+        return -1;
+
+    if (depth == 0)
+        return 1;
+
+    if (job->table)
+    {
+        entry = &job->table[board->hash_key & job->mask];
+        data = entry->data;
+
+        if ((entry->check ^ data) == (unsigned long long)board->hash_key
+            && (int)(data & 0xff) == depth)
+            return data >> 8;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        board_undo_t undo;
+        long long n;
+
+        board_make(board, list[i], &undo);
+        n = perft_node(job, board, depth - 1, list + count);
+        board_unmake(board, &undo);
+
+        if (n > 0)
+            nodes += n;
+    }
+
+    if (entry)
+    {
+        data = ((unsigned long long)nodes << 8) | depth;
+        entry->check = board->hash_key ^ data;
+        entry->data = data;
+    }
+
+    return nodes;
+}
+
+static void *perft_worker(void *data)
+{
+    perft_job_t *job = data;
+    board_t board = job->board;
+    move_t *list = malloc((job->depth + 1) * MOVES_MAX * sizeof(move_t));
+
+    while (1)
+    {
+        int i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED);
+        board_undo_t undo;
+
+        if (i >= job->count)
+            break;
+
+        board_make(&board, job->root[i], &undo);
+        job->nodes[i] = perft_node(job, &board, job->depth - 1, list);
+        board_unmake(&board, &undo);
+    }
+
+    free(list);
+    return NULL;
+}
+
+long long perft(board_t *board, int depth, int threads, int hash,
+                long long *divide)
+{
+    perft_job_t *job = malloc(sizeof(perft_job_t));
+    pthread_t *thread;
+    long long nodes = 0;
+    int i;
+
+    job->board = *board;
+    job->depth = depth;
+    job->count = move_generate(board, job->root);
+    job->next = 0;
+    job->table = NULL;
+
+    if (job->count < 0 || depth < 1)
+    {
+        nodes = (job->count < 0 ? 0 : 1);
+        free(job);
+        return nodes;
+    }
+
+    if (hash > 0)
+    {
+        unsigned long long entries = 1;
+
+        while (entries * 2 * sizeof(perft_entry_t) <= hash * 1048576ULL)
+            entries *= 2;
+
+        job->table = calloc(entries, sizeof(perft_entry_t));
+        job->mask = entries - 1;
+    }
+
+    if (threads < 1)
+        threads = 1;
+    if (threads > job->count)
+        threads = job->count;
+
+    thread = malloc(threads * sizeof(pthread_t));
+
+    /* The calling thread is one of the workers. */
+    for (i = 1; i < threads; i++)
+        pthread_create(&thread[i], NULL, perft_worker, job);
+
+    perft_worker(job);
+
+    for (i = 1; i < threads; i++)
+        pthread_join(thread[i], NULL);
+
+    for (i = 0; i < job->count; i++)
+    {
+        if (job->nodes[i] > 0)
+            nodes += job->nodes[i];
+        if (divide)
+            divide[i] = job->nodes[i];
+    }
+
+    free(thread);
+    free(job->table);
+    free(job);
+
+    return nodes;
+}
+
+void perft_command(board_t *board, char *args, int divide)
+{
+    long long counts[MOVES_MAX];
+    move_t root[MOVES_MAX];
+    char *end;
+    int depth = strtol(args, &end, 10);
+    int threads = strtol(end, &end, 10);
+    int hash = strtol(end, &end, 10);
+    long long start = timer_now();
+    long long nodes, elapsed;
+
+    if (depth < 1)
+    {
+        e_comm_send("Error (invalid depth):%s\n", args);
+        return;
+    }
+
+    nodes = perft(board, depth, threads, hash, divide ? counts : NULL);
+    elapsed = timer_now() - start;
+
+    if (divide)
+    {
+        int count = move_generate(board, root);
+        int i;
+
+        for (i = 0; i < count; i++)
+        {
+            char *s;
+
+            if (counts[i] < 0)
+                continue;
+
+            s = coord_move_str(root[i]);
+            e_comm_send("%s: %lli\n", s, counts[i]);
+            free(s);
+        }
+    }
+
+    e_comm_send("Nodes: %lli Time: %lli ms Nodes/second: %lli\n", nodes,
+                elapsed, elapsed > 0 ? nodes * 1000 / elapsed : 0);
+}
+
+int perft_epd(char *filename, int max_depth, int threads, int hash)
+{
+    FILE *f = fopen(filename, "r");
+    char line[4096];
+    int positions = 0, failed = 0;
+    long long total = 0;
+    long long start = timer_now();
+    long long elapsed;
+
+    if (!f)
+    {
+        e_comm_send("Error opening %s\n", filename);
+        return 1;
+    }
+
+    while (fgets(line, sizeof(line), f))
+    {
+        board_t board;
+        char *ops;
+        int depth;
+        int ok = 1;
+
+        if (epd_parse(line, &board, &ops))
+            continue;
+
+        positions++;
+
+        for (depth = 1; depth <= max_depth; depth++)
+        {
+            char opcode[16];
+            char *target;
+            long long nodes;
+
+            sprintf(opcode, "D%i", depth);
+            target = epd_operand(ops, opcode);
+
+            if (!target)
+                continue;
+
+            nodes = perft(&board, depth, threads, hash, NULL);
+            total += nodes;
+
+            if (nodes != atoll(target))
+            {
+                e_comm_send("FAIL position %i depth %i: %lli, expected %s\n",
+                            positions, depth, nodes, target);
+                ok = 0;
+            }
+
+            free(target);
+        }
+
+        if (!ok)
+            failed++;
+
+        e_comm_send("Position %i: %s\n", positions, ok ? "ok" : "failed");
+    }
+
+    fclose(f);
+    elapsed = timer_now() - start;
+
+    e_comm_send("Positions: %i Failed: %i Nodes: %lli Time: %lli ms "
+                "Nodes/second: %lli\n",
+                positions, failed, total, elapsed,
+                elapsed > 0 ? total * 1000 / elapsed : 0);
+
+    return failed > 0;
+}
@@ -0,0 +1,60 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PERFT_H
+#define PERFT_H
+
+#include "board.h"
+
+long long perft(board_t *board, int depth, int threads, int hash,
+                long long *divide);
+/* Counts the leaf nodes of the legal move tree of a position. The root
+** moves are split across a pool of worker threads.
+** Parameters: (board_t *) board: The position.
+**             (int) depth: Depth of the tree.
+**             (int) threads: Number of worker threads.
+**             (int) hash: Size of the perft hash table in megabytes, or 0
+**                 to not use one.
+**             (long long *) divide: If not NULL, set to the node count of
+**                 each pseudo-legal root move in move_generate order, -1
+**                 for illegal moves. Must have room for MOVES_MAX entries.
+** Returns   : (long long) The number of leaf nodes.
+*/
+
+void perft_command(board_t *board, char *args, int divide);
+/* Runs perft with the arguments of a "perft depth [threads] [hash]" or
+** "divide depth [threads] [hash]" command and prints the result.
+** Parameters: (board_t *) board: The position.
+**             (char *) args: The arguments.
+**             (int) divide: 1 to print the node count of every root move.
+** Returns   : (void)
+*/
+
+int perft_epd(char *filename, int max_depth, int threads, int hash);
+/* Checks the perft results of all positions in an EPD file with ";D<n>
+** <nodes>" operations, as in the widely used perftsuite.epd.
+** Parameters: (char *) filename: The EPD file.
+**             (int) max_depth: Skip targets deeper than this.
+**             (int) threads: Number of worker threads.
+**             (int) hash: Size of the perft hash table in megabytes.
+** Returns   : (int) 0 if all results match, 1 otherwise.
+*/
+
+#endif /* PERFT_H */
@@ -24,21 +24,26 @@
 #include "board.h"
 #include "move.h"
 
+/* Positions since the last irreversible move: up to 100 plies of the game
+** plus the line that is being searched.
+*/
+#define REP_POSITIONS (101 + 100)
+
 typedef struct rep_list
 {
-    /* FIXME */
-    long long position[101 + 100];
+    long long position[REP_POSITIONS];
     int head;
 }
 rep_list_t;
 
-static rep_list_t *hist;
-static int hist_idx;
-static rep_list_t *cur_list;
+/* The game of the current thread, split up at irreversible moves. */
+static THREAD_LOCAL rep_list_t *hist;
+static THREAD_LOCAL int hist_idx;
+static THREAD_LOCAL rep_list_t *cur_list;
 
 void repetition_init(board_t *board)
 {
-    hist = malloc(sizeof(rep_list_t));
+    hist = realloc(hist, sizeof(rep_list_t));
     hist_idx = 0;
     cur_list = &hist[0];
     cur_list->position[0] = board->hash_key;
@@ -48,6 +53,8 @@ void repetition_init(board_t *board)
 void repetition_exit(void)
 {
     free(hist);
+    hist = NULL;
+    cur_list = NULL;
 }
 
 void repetition_add(board_t *board, move_t move)
@@ -80,7 +87,10 @@ int is_repetition(board_t *board, int ply)
     int i;
     int cur_head = cur_list->head + ply;
 
-    /* We won't go out of bounds here because of the 50-move rule. */
+    /* Lines this deep aren't checked for repetitions. */
+    if (cur_head >= REP_POSITIONS)
+        return 0;
+
     cur_list->position[cur_head] = board->hash_key;
 
     if (cur_head < 4)
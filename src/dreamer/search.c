@@ -22,6 +22,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "attack.h"
 #include "board.h"
 #include "move.h"
 #include "search.h"
@@ -34,18 +35,92 @@
 #include "e_comm.h"
 #include "commands.h"
 #include "timer.h"
+#include "stats.h"
+#include "syzygy.h"
 
 /* #define DEBUG */
 
-extern int moves_made;
-int abort_search;
+/* Everything below is the state of the search that runs on the current
+** thread, so that engine instances can search on several threads at once.
+*/
+static THREAD_LOCAL int abort_search;
+
+/* The state passed to find_best_move(). */
+static THREAD_LOCAL state_t *cur_state;
+static THREAD_LOCAL int quiesce;
+
+static THREAD_LOCAL int total_nodes;
+
+/* Root moves that keep the tablebase result, or none if the root position
+** isn't in the tables. Only these are searched.
+*/
+static THREAD_LOCAL move_t tb_moves[SYZYGY_MAX_MOVES];
+static THREAD_LOCAL int tb_move_count;
+static THREAD_LOCAL int start_time;
+static THREAD_LOCAL int max_nodes;
+
+/* Highest ply reached in the current search, including quiescence. */
+static THREAD_LOCAL int sel_depth;
+
+/* The clock is read every poll_interval nodes. The interval is adjusted
+** during the search so that this happens about once per millisecond.
+*/
+#define POLL_INTERVAL_MIN 64
+#define POLL_INTERVAL_MAX (1 << 16)
+
+static THREAD_LOCAL int poll_interval;
+static THREAD_LOCAL int poll_nodes;
+static THREAD_LOCAL long long poll_time;
+
+/* The most recent changes of the best move at the root, for measuring when
+** a test position was solved.
+*/
+#define BEST_CHANGES 64
+
+static THREAD_LOCAL struct
+{
+    move_t move;
+    int nodes;
+    int msec;
+} best_changes[BEST_CHANGES];
 
-static int total_nodes;
-static int start_time;
+static THREAD_LOCAL int best_change_count;
+static THREAD_LOCAL long long start_msec;
 
-/* Principal variation */
-move_t pv[MAX_DEPTH][MAX_DEPTH];
-int pv_len[MAX_DEPTH];
+/* Progress of the root search, for status updates. */
+static THREAD_LOCAL int root_depth;
+static THREAD_LOCAL int root_index;
+static THREAD_LOCAL int root_total;
+static THREAD_LOCAL move_t root_move;
+
+/* Thinking output is sent at most once per PV_PRINT_INTERVAL milliseconds,
+** plus once at the end of every iteration.
+*/
+#define PV_PRINT_INTERVAL 100
+
+static THREAD_LOCAL long long last_print;
+static THREAD_LOCAL int pv_printed;
+
+/* Size of the ply stack of the current search. The search stops extending
+** the tree at the last ply and returns the static evaluation.
+*/
+static THREAD_LOCAL int plies;
+static THREAD_LOCAL int plies_allocated;
+
+/* Principal variation, a row of plies moves for every ply. */
+static THREAD_LOCAL move_t **pv;
+static THREAD_LOCAL int *pv_len;
+
+/* The best lines at the root in MultiPV mode, ordered by score. */
+typedef struct
+{
+    int score;
+    int len;
+    move_t *pv;
+} pv_line_t;
+
+static THREAD_LOCAL pv_line_t lines[MULTIPV_MAX];
+static THREAD_LOCAL int line_count;
 
 #if 0
 void
@@ -83,6 +158,54 @@ print_board(board_t *board)
 }
 #endif
 
+/* Sizes the ply stack for a search of a given depth. Memory is only
+** allocated when the stack needs to grow.
+*/
+static void ply_stack_init(int depth)
+{
+    move_t *block = (plies_allocated > 0 ? pv[0] : NULL);
+    int i;
+
+    plies = depth + QUIESCE_PLIES;
+    move_stack_init(plies);
+
+    if (plies <= plies_allocated)
+        return;
+
+    block = realloc(block, plies * plies * sizeof(move_t));
+    pv = realloc(pv, plies * sizeof(move_t *));
+    for (i = 0; i < plies; i++)
+        pv[i] = block + i * plies;
+
+    pv_len = realloc(pv_len, plies * sizeof(int));
+    pv_len[0] = 0;
+
+    for (i = 0; i < MULTIPV_MAX; i++)
+        lines[i].pv = realloc(lines[i].pv, plies * sizeof(move_t));
+
+    plies_allocated = plies;
+}
+
+void search_exit(void)
+{
+    int i;
+
+    if (plies_allocated > 0)
+        free(pv[0]);
+    free(pv);
+    free(pv_len);
+
+    for (i = 0; i < MULTIPV_MAX; i++)
+    {
+        free(lines[i].pv);
+        lines[i].pv = NULL;
+    }
+
+    pv = NULL;
+    pv_len = NULL;
+    plies_allocated = 0;
+}
+
 static inline void pv_term(int ply)
 {
     pv_len[ply] = 0;
@@ -95,75 +218,290 @@ static inline void pv_copy(int ply, move_t move)
     pv_len[ply] = pv_len[ply + 1] + 1;
 }
 
-static void pv_print_move(state_t *state, int index)
+static void pv_print_move(state_t *state, pv_line_t *line, int index)
 {
-    long long en_passant = state->board.en_passant;
-    int castle_flags = state->board.castle_flags;
-    int fifty_moves = state->board.fifty_moves;
+    board_undo_t undo;
     char *s;
 
-    if (index == pv_len[0])
+    if (index == line->len)
         return;
 
     if ((state->moves + index) % 2 == 0)
         e_comm_send(" %2d.", (state->moves + index) / 2 + 1);
 
     /* Ply 0 is used by find_best_move(). */
-    s = san_move_str(&state->board, 1, pv[0][index]);
+    s = san_move_str(&state->board, 1, line->pv[index]);
     e_comm_send(" %s", s);
     free(s);
 
-    execute_move(&state->board, pv[0][index]);
-    pv_print_move(state, index + 1);
-    unmake_move(&state->board, pv[0][index], en_passant, castle_flags, fifty_moves);
+    board_make(&state->board, line->pv[index], &undo);
+    pv_print_move(state, line, index + 1);
+    board_unmake(&state->board, &undo);
+}
+
+static void pv_print_uci(state_t *state, int depth, pv_line_t *line, int rank)
+{
+    int time = get_time() - start_time;
+    int score = line->score;
+    int i;
+
+    e_comm_send("info depth %i seldepth %i", depth, sel_depth);
+
+    if (state->multipv > 1)
+        e_comm_send(" multipv %i", rank + 1);
+
+    if (score > ALPHABETA_MAX - 1000)
+        e_comm_send(" score mate %i", (ALPHABETA_MAX - score + 1) / 2);
+    else if (score < ALPHABETA_MIN + 1000)
+        e_comm_send(" score mate %i", -(score - ALPHABETA_MIN + 1) / 2);
+    else
+        e_comm_send(" score cp %i", score);
+
+    e_comm_send(" nodes %i nps %i time %i hashfull %i tbhits %i pv",
+                total_nodes, (int)(time > 0 ? total_nodes * 100LL / time : 0),
+                time * 10, transposition_hashfull(), stats.tb_hits);
+
+    for (i = 0; i < line->len; i++)
+    {
+        char *s = coord_move_str(line->pv[i]);
+        e_comm_send(" %s", s);
+        free(s);
+    }
+
+    e_comm_send("\n");
+}
+
+/* Returns whether thinking output is on. It can be switched while the
+** search runs.
+*/
+static inline int search_post(state_t *state)
+{
+    return state->options & (1 << OPTION_POST);
+}
+
+/* Passes a line to the callback of a library instance. */
+static void pv_print_info(state_t *state, int depth, pv_line_t *line,
+                          int rank)
+{
+    search_info_t info;
+
+    info.depth = depth;
+    info.sel_depth = sel_depth;
+    info.rank = rank;
+    info.score = line->score;
+    info.nodes = total_nodes;
+    info.tb_hits = stats.tb_hits;
+    info.msec = timer_now() - start_msec;
+    info.len = line->len;
+    info.pv = line->pv;
+
+    state->info(state->info_data, &info);
 }
 
-static void pv_print(state_t *state, int depth, int score)
+static void pv_print(state_t *state, int depth, int rank)
 {
+    pv_line_t *line = &lines[rank];
+    int score = line->score;
+
+    if (state->protocol == PROTOCOL_UCI)
+    {
+        pv_print_uci(state, depth, line, rank);
+        return;
+    }
+
+    if (state->protocol == PROTOCOL_LIBRARY)
+    {
+        if (state->info)
+            pv_print_info(state, depth, line, rank);
+        return;
+    }
+
     if (state->mode == MODE_BLACK)
         score = -score;
 
-    e_comm_send("%3i %7i %i %i", depth, score, total_nodes, get_time() - start_time, total_nodes);
+    e_comm_send("%3i %7i %i %i", depth, score, get_time() - start_time, total_nodes);
     if (state->board.current_player == SIDE_BLACK)
         e_comm_send(" %2d. ...", state->moves / 2 + 1);
 
-    pv_print_move(state, 0);
+    pv_print_move(state, line, 0);
 
     e_comm_send("\n");
 }
 
+/* Prints the best line, unless thinking output was sent very recently. */
+static void pv_print_limited(state_t *state, int depth)
+{
+    long long now = timer_now();
+
+    if (now - last_print < PV_PRINT_INTERVAL)
+    {
+        pv_printed = 0;
+        return;
+    }
+
+    pv_print(state, depth, 0);
+    last_print = now;
+    pv_printed = 1;
+}
+
+/* Adds a root move to the best lines, using the pv of ply 1. Returns the
+** rank of the new line.
+*/
+static int pv_line_add(move_t move, int score, int multipv)
+{
+    int rank;
+    move_t *buf;
+
+    for (rank = 0; rank < line_count; rank++)
+        if (score > lines[rank].score)
+            break;
+
+    if (line_count < multipv)
+        line_count++;
+
+    /* The line that drops off the end passes its buffer to the new one. */
+    buf = lines[line_count - 1].pv;
+    memmove(&lines[rank + 1], &lines[rank],
+            (line_count - rank - 1) * sizeof(pv_line_t));
+
+    lines[rank].pv = buf;
+    lines[rank].score = score;
+    lines[rank].pv[0] = move;
+    lines[rank].len = pv_len[1] + 1;
+    if (lines[rank].len > plies)
+        lines[rank].len = plies;
+    memcpy(&lines[rank].pv[1], &pv[1][0],
+           (lines[rank].len - 1) * sizeof(move_t));
+
+    return rank;
+}
+
 void pv_clear(void)
 {
-    pv_term(0);
+    if (pv_len)
+        pv_term(0);
 }
 
 static void pv_store_ht(board_t *board, int index)
 {
-    long long en_passant = board->en_passant;
-    int castle_flags = board->castle_flags;
-    int fifty_moves = board->fifty_moves;
+    board_undo_t undo;
 
     if (index == pv_len[0])
         return;
 
     set_best_move(board, pv[0][index]);
-    execute_move(board, pv[0][index]);
+    board_make(board, pv[0][index], &undo);
     pv_store_ht(board, index + 1);
-    unmake_move(board, pv[0][index], en_passant, castle_flags, fifty_moves);
+    board_unmake(board, &undo);
 }
 
-int
-alpha_beta(board_t *board, int depth, int ply, int alpha, int beta, int side);
+/* Returns the next move to search at the root. In MultiPV mode the best
+** lines of the previous iteration go first, so that alpha rises quickly.
+*/
+static move_t root_move_next(board_t *board, attack_map_t *map,
+                             move_t *prev, int prev_count, int *index)
+{
+    move_t move;
+
+    if (*index < prev_count)
+        return prev[(*index)++];
+
+    while ((move = move_next(board, 0, map)) != NO_MOVE)
+    {
+        int i;
+
+        for (i = 0; i < prev_count; i++)
+            if (prev[i] == move)
+                break;
+
+        if (i < prev_count)
+            continue;
+
+        if (tb_move_count == 0)
+            return move;
+
+        for (i = 0; i < tb_move_count; i++)
+            if (tb_moves[i] == (move & (MOVE_SOURCE_MASK | MOVE_DEST_MASK
+                                        | MOVE_PROMOTION_MASK)))
+                return move;
+    }
+
+    return NO_MOVE;
+}
+
+static void best_change_add(move_t move)
+{
+    int i = best_change_count++ % BEST_CHANGES;
+
+    best_changes[i].move = move;
+    best_changes[i].nodes = total_nodes;
+    best_changes[i].msec = timer_now() - start_msec;
+}
 
 int
-is_check(board_t *board, int ply);
+alpha_beta(board_t *board, int depth, int ply, int alpha, int beta, int side);
 
 static void poll_abort(int ply)
 {
+    /* We need at least one move before we can stop. */
     if (pv_len[0] == 0)
         return;
 
-    if (check_abort(ply))
+    if (poll_nodes <= 0)
+    {
+        long long now = timer_now();
+
+        if (now - poll_time < 1)
+        {
+            if (poll_interval < POLL_INTERVAL_MAX)
+                poll_interval <<= 1;
+        }
+        else if (now - poll_time > 2)
+        {
+            if (poll_interval > POLL_INTERVAL_MIN)
+                poll_interval >>= 1;
+        }
+
+        poll_time = now;
+        poll_nodes = poll_interval;
+
+        if (max_nodes)
+        {
+            if (total_nodes >= max_nodes)
+            {
+                abort_search = 1;
+                return;
+            }
+
+            /* Poll again exactly when the node limit is reached, so that
+            ** the search doesn't depend on the speed of the machine.
+            */
+            if (poll_nodes > max_nodes - total_nodes)
+                poll_nodes = max_nodes - total_nodes;
+        }
+
+        if (check_time(cur_state))
+        {
+            abort_search = 1;
+            return;
+        }
+
+        /* Library instances are stopped through their state, they don't
+        ** read commands.
+        */
+        if (cur_state->protocol == PROTOCOL_LIBRARY)
+        {
+            if (__atomic_load_n(&cur_state->stop, __ATOMIC_ACQUIRE))
+                abort_search = 1;
+            return;
+        }
+
+        /* Send out any pv lines that were printed since the last poll. */
+        e_comm_flush();
+    }
+
+    if (cur_state->protocol != PROTOCOL_LIBRARY && e_comm_pending()
+        && check_input(ply))
         abort_search = 1;
 }
 
@@ -171,17 +509,22 @@ static int
 quiescence(board_t *board, int ply, int alpha, int beta, int side)
 {
     int eval;
-    bitboard_t en_passant;
-    int castle_flags;
-    int fifty_moves;
+    board_undo_t undo;
     move_t move;
+    attack_map_t map;
 
-    if ((total_nodes++) % 10000 == 0)
+    total_nodes++;
+    STATS_INC(qnodes[ply]);
+
+    if ((--poll_nodes <= 0) || e_comm_pending())
         poll_abort(ply);
 
     if (abort_search)
         return 0;
 
+    if (ply > sel_depth)
+        sel_depth = ply;
+
     if (is_repetition(board, ply - 1))
         return 0;
 
@@ -189,28 +532,34 @@ quiescence(board_t *board, int ply, int alpha, int beta, int side)
     if (compute_legal_moves(board, ply) < 0)
         return ALPHABETA_ILLEGAL;
 
-    eval = board_eval_complete(board, side, alpha, beta);
+    attack_map_build(board, &map);
+    eval = board_eval_complete(board, side, &map, alpha, beta);
 
-    if (ply == MAX_DEPTH - 1)
+    if (ply == plies - 1)
         return eval;
 
-    if (!get_option(OPTION_QUIESCE) || eval >= beta)
+    if (!quiesce || eval >= beta)
         return eval;
 
     if (eval > alpha)
         alpha = eval;
 
-    en_passant = board->en_passant;
-    castle_flags = board->castle_flags;
-    fifty_moves = board->fifty_moves;
-
-    while ((move = move_next(board, ply)) != NO_MOVE)
+    while ((move = move_next(board, ply, &map)) != NO_MOVE)
     {
         if (move & (CAPTURE_MOVE | CAPTURE_MOVE_EN_PASSANT | MOVE_PROMOTION_MASK))
         {
-            execute_move(board, move);
+            /* Captures that lose material can't raise the score above
+            ** what standing pat gives.
+            */
+            if (!(move & MOVE_PROMOTION_MASK)
+                && attack_see(board, &map, move) < 0)
+                continue;
+
+            board_make(board, move, &undo);
             eval = -quiescence(board, ply + 1, -beta, -alpha, side);
-            unmake_move(board, move, en_passant, castle_flags, fifty_moves);
+            board_unmake(board, &undo);
+            if (abort_search)
+                return 0;
             if (eval == -ALPHABETA_ILLEGAL)
                 continue;
             if (eval >= beta)
@@ -259,18 +608,24 @@ alpha_beta(board_t *board, int depth, int ply, int alpha, int beta, int side)
     int eval;
     int best_move_score;
     int eval_type = EVAL_UPPERBOUND;
-    long long en_passant;
-    int castle_flags;
-    int fifty_moves;
+    board_undo_t undo;
+    attack_map_t map;
     move_t best_move;
     move_t move;
+    int legal = 0;
+
+    total_nodes++;
+    STATS_INC(nodes[ply]);
 
-    if ((total_nodes++) % 10000 == 0)
+    if ((--poll_nodes <= 0) || e_comm_pending())
         poll_abort(ply);
 
     if (abort_search)
         return 0;
 
+    if (ply > sel_depth)
+        sel_depth = ply;
+
     if (is_repetition(board, ply - 1)) {
         pv_term(ply);
         return 0;
@@ -290,18 +645,51 @@ alpha_beta(board_t *board, int depth, int ply, int alpha, int beta, int side)
     switch (lookup_board(board, depth, ply, &eval))
     {
     case EVAL_ACCURATE:
+        STATS_INC(tt_cutoffs);
         pv_term(ply);
         return eval;
     case EVAL_LOWERBOUND:
         if (eval >= beta)
+        {
+            STATS_INC(tt_cutoffs);
             return beta;
+        }
         break;
     case EVAL_UPPERBOUND:
         if (eval <= alpha)
+        {
+            STATS_INC(tt_cutoffs);
             return alpha;
+        }
+    }
+
+    /* Probing right after captures and pawn moves finds every position
+    ** that comes within reach of the tables.
+    */
+    if (board->fifty_moves == 0 && syzygy_probe_wdl(board, &eval))
+    {
+        /* The probe doesn't check whether the move that led here was
+        ** legal.
+        */
+        if (compute_legal_moves(board, ply) < 0)
+            return ALPHABETA_ILLEGAL;
+
+        STATS_INC(tb_hits);
+
+        if (eval == SYZYGY_WIN)
+            eval = ALPHABETA_TB_WIN - ply;
+        else if (eval == SYZYGY_LOSS)
+            eval = -ALPHABETA_TB_WIN + ply;
+        else
+            eval = 0;
+
+        store_board(board, eval, EVAL_ACCURATE, depth, ply,
+                    0 /* FIXME moves_made */, NO_MOVE);
+        pv_term(ply);
+        return eval;
     }
 
-    if (depth == 0 || ply == MAX_DEPTH - 1) {
+    if (depth == 0 || ply == plies - 1) {
         pv_term(ply);
         return quiescence(board, ply, alpha, beta, side);
     }
@@ -309,24 +697,27 @@ alpha_beta(board_t *board, int depth, int ply, int alpha, int beta, int side)
     if (compute_legal_moves(board, ply) < 0)
         return ALPHABETA_ILLEGAL;
 
+    /* Built once, for the move ordering and the check test. */
+    attack_map_build(board, &map);
+
     best_move = NO_MOVE;
     best_move_score = ALPHABETA_ILLEGAL;
 
-    en_passant = board->en_passant;
-    castle_flags = board->castle_flags;
-    fifty_moves = board->fifty_moves;
-
-    while ((move = move_next(board, ply)) != NO_MOVE)
+    while ((move = move_next(board, ply, &map)) != NO_MOVE)
     {
         int score;
-        execute_move(board, move);
+        board_make(board, move, &undo);
         score = -alpha_beta(board, depth - 1, ply + 1, -beta, -alpha, side);
-        unmake_move(board, move, en_passant, castle_flags, fifty_moves);
+        board_unmake(board, &undo);
         if (abort_search)
             return 0;
         if (score == -ALPHABETA_ILLEGAL)
             continue;
+        legal++;
         if (score >= beta) {
+                STATS_INC(cutoffs);
+                if (legal == 1)
+                    STATS_INC(first_cutoffs);
                 store_board(board, beta, EVAL_LOWERBOUND, depth, ply,
                             0 /* FIXME moves_made */, move);
                 add_count(move, board->current_player);
@@ -348,7 +739,7 @@ alpha_beta(board_t *board, int depth, int ply, int alpha, int beta, int side)
         /* There are no legal moves. We're either checkmated or
         ** stalemated.
         */
-        if (is_check(board, ply))
+        if (attack_in_check(board, &map, board->current_player))
         {
             /* depth is added to make checkmates that are
             ** further away more preferable over the ones
@@ -377,34 +768,85 @@ find_best_move(state_t *state)
     board_t *board = &state->board;
     move_t best_move = NO_MOVE;
     int cur_depth;
-    long long en_passant = board->en_passant;
-    int castle_flags = board->castle_flags;
-    int fifty_moves = board->fifty_moves;
+    board_undo_t undo;
+    attack_map_t map;
+    int multipv = state->multipv;
+
+    ply_stack_init(depth);
+
+    cur_state = state;
+    quiesce = state->options & (1 << OPTION_QUIESCE);
 
     total_nodes = 0;
+    max_nodes = state->nodes;
+    sel_depth = 0;
     start_time = get_time();
     abort_search = 0;
+    poll_interval = POLL_INTERVAL_MIN;
+    poll_nodes = poll_interval;
+    if (max_nodes && poll_nodes > max_nodes)
+        poll_nodes = max_nodes;
+    poll_time = timer_now();
+    start_msec = poll_time;
+    best_change_count = 0;
     pv_len[0] = 0;
+    stats_clear(plies);
+    last_print = 0;
+    root_move = NO_MOVE;
+    root_total = 0;
 
     timer_start(&state->move_time);
 
+    if (multipv < 1)
+        multipv = 1;
+    else if (multipv > MULTIPV_MAX)
+        multipv = MULTIPV_MAX;
+
+    line_count = 0;
+    attack_map_build(board, &map);
+
+    {
+        int wdl;
+
+        tb_move_count = syzygy_probe_root(board, tb_moves, &wdl);
+
+        if (tb_move_count > 0)
+            STATS_INC(tb_hits);
+    }
+
     for (cur_depth = 0; cur_depth < depth; cur_depth++)
     {
         int alpha = ALPHABETA_MIN;
 	move_t move;
+        move_t prev[MULTIPV_MAX];
+        int prev_count = 0;
+        int index = 0;
 
+        if (multipv > 1)
+            for (prev_count = 0; prev_count < line_count; prev_count++)
+                prev[prev_count] = lines[prev_count].pv[0];
+
+        line_count = 0;
+        pv_printed = 1;
         compute_legal_moves(board, 0);
 
+        root_depth = cur_depth + 1;
+        root_index = 0;
+        root_total = (tb_move_count > 0 ? tb_move_count
+                      : moves_start[1] - moves_start[0]);
+
         /* e_comm_send("------------------\n"); */
-        while ((move = move_next(board, 0)) != NO_MOVE)
+        while ((move = root_move_next(board, &map, prev, prev_count, &index)) != NO_MOVE)
         {
             int score;
             /* char *s = coord_move_str(move);
             e_comm_send("Examining move %s..\n", s);
             free(s); */
-            execute_move(board, move);
+            root_move = move;
+            root_index++;
+            board_make(board, move, &undo);
             score = -alpha_beta(board, cur_depth, 1, ALPHABETA_MIN, -alpha, OPPONENT(board->current_player));
-            unmake_move(board, move, en_passant, castle_flags, fifty_moves);
+            board_unmake(board, &undo);
             /* e_comm_send("Move scored %i\n", score); */
             if (abort_search)
             {
@@ -414,16 +856,48 @@ find_best_move(state_t *state)
             }
             if (score == -ALPHABETA_ILLEGAL)
                 continue;
+            /* Once there are enough lines, alpha is the score of the worst
+            ** one, so that every move that makes it into the list gets an
+            ** exact score.
+            */
             if (score > alpha)
             {
-                alpha = score;
-                best_move = move;
-                pv_copy(0, move);
-                if (get_option(OPTION_POST))
-                    pv_print(state, cur_depth + 1, alpha);
+                if (pv_line_add(move, score, multipv) == 0)
+                {
+                    if (move != best_move)
+                        best_change_add(move);
+                    best_move = move;
+                    pv_copy(0, move);
+                    if (multipv == 1 && search_post(state))
+                        pv_print_limited(state, cur_depth + 1);
+                }
+
+                if (line_count == multipv)
+                    alpha = lines[multipv - 1].score;
             }
         }
 
+        /* Send out the final line of the iteration if it was held back. */
+        if (!pv_printed && search_post(state))
+        {
+            pv_print(state, cur_depth + 1, 0);
+            last_print = timer_now();
+        }
+
+        if (!abort_search)
+        {
+            int i;
+
+            stats_iteration(total_nodes);
+
+            if (multipv > 1 && search_post(state))
+                for (i = 0; i < line_count; i++)
+                    pv_print(state, cur_depth + 1, i);
+        }
+
+        if (line_count > 0)
+            alpha = lines[0].score;
+
         /* If we found a mate in 'ply' we stop the search */
         if (alpha == ALPHABETA_MAX - cur_depth) {
             break;
@@ -478,14 +952,64 @@ find_best_move(state_t *state)
     else
     {
         /* Try to get hint move from hash table. */
-        execute_move(board, best_move);
+        board_make(board, best_move, &undo);
         state->hint = lookup_best_move(board);
-        unmake_move(board, best_move, en_passant, castle_flags, fifty_moves);
+        board_unmake(board, &undo);
     }
 
     return best_move;
 }
 
+int
+search_nodes(void)
+{
+    return total_nodes;
+}
+
+void
+search_status(void)
+{
+    char *s = (root_move != NO_MOVE ? coord_move_str(root_move) : NULL);
+
+    e_comm_send("stat01: %i %i %i %i %i", get_time() - start_time,
+                total_nodes, root_depth, root_total - root_index, root_total);
+
+    if (s)
+    {
+        e_comm_send(" %s", s);
+        free(s);
+    }
+
+    e_comm_send("\n");
+}
+
+int
+search_best_change(int i, move_t *move, int *nodes, int *msec)
+{
+    if (i >= best_change_count || i >= BEST_CHANGES)
+        return 1;
+
+    i = (best_change_count - 1 - i) % BEST_CHANGES;
+    *move = best_changes[i].move;
+    *nodes = best_changes[i].nodes;
+    *msec = best_changes[i].msec;
+    return 0;
+}
+
+void
+search_ponder_hit(state_t *state, int budget)
+{
+    /* The time spent pondering counts towards the budget, as the search
+    ** already got that far.
+    */
+    int left = budget - (get_time() - start_time);
+
+    state->flags &= ~FLAG_PONDER;
+    timer_init(&state->move_time, 1);
+    timer_set(&state->move_time, left > 0 ? left : 0);
+    timer_start(&state->move_time);
+}
+
 move_t
 ponder(state_t *state)
 {
@@ -29,6 +29,19 @@
 
 #define ALPHABETA_CHECKMATE -29000
 
+/* Score of a position that the tablebases show to be won, less the ply
+** it's reached at. It stays clear of the range of mate scores.
+*/
+#define ALPHABETA_TB_WIN 20000
+
+/* Plies that the search may go beyond its nominal depth, for quiescence
+** search.
+*/
+#define QUIESCE_PLIES 64
+
+/* Maximum number of lines in MultiPV mode. */
+#define MULTIPV_MAX 64
+
 #define MAX_NODE 0
 #define MIN_NODE 1
 
@@ -38,7 +51,47 @@ find_best_move(state_t *state);
 void
 pv_clear(void);
 
+void
+search_exit(void);
+/* Frees the search buffers of the current thread. They are allocated again
+** by the next search on the thread.
+** Parameters: (void)
+** Returns   : (void)
+*/
+
 move_t
 ponder(state_t *state);
 
+void
+search_ponder_hit(state_t *state, int budget);
+/* Turns a running ponder search into the real search when the opponent
+** played the expected move. The search continues with its tree intact.
+** Parameters: (state_t *) state: The engine state.
+**             (int) budget: Time for the move in centiseconds, counted from
+**                 the start of the ponder search.
+** Returns   : (void)
+*/
+
+int
+search_nodes(void);
+
+void
+search_status(void);
+/* Sends an xboard "stat01" status line about the current or last search.
+** Parameters: (void)
+** Returns   : (void)
+*/
+
+int
+search_best_change(int i, move_t *move, int *nodes, int *msec);
+/* Looks up a change of the best move at the root during the last search.
+** Parameters: (int) i: 0 for the most recent change, 1 for the one before
+**                 that, and so on.
+**             (move_t *) move: Set to the new best move.
+**             (int *) nodes: Set to the node count at the time of the change.
+**             (int *) msec: Set to the search time in milliseconds at the
+**                 time of the change.
+** Returns   : (int) 0 on success, 1 if no such change was recorded.
+*/
+
 #endif /* SEARCH_H */
@@ -0,0 +1,316 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "dreamer.h"
+#include "commands.h"
+#include "instance.h"
+#include "move.h"
+#include "packed.h"
+#include "repetition.h"
+#include "search.h"
+#include "selfplay.h"
+
+/* Random moves at the start of each game. */
+#define SELFPLAY_RANDOM_PLIES 8
+
+/* Games this long are drawn. */
+#define SELFPLAY_MAX_PLIES 400
+
+/* A game is won when the score is at least this for this many plies. */
+#define SELFPLAY_WIN_SCORE 1500
+#define SELFPLAY_WIN_PLIES 4
+
+/* Guards the writer and the counters. */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+static packed_writer_t *writer;
+static int games_total;
+static int next_game;
+static int results[3];
+static long long positions;
+static int error;
+
+static unsigned long long seed;
+static dreamer_limits_t limits;
+static int hash_size;
+
+static void selfplay_info(void *data, search_info_t *info)
+{
+    if (info->rank == 0)
+        *(int *)data = info->score;
+}
+
+static unsigned long long next_random(unsigned long long *x)
+{
+    *x ^= *x << 13;
+    *x ^= *x >> 7;
+    *x ^= *x << 17;
+    return *x;
+}
+
+static int in_check(board_t *board)
+{
+    board_t b = *board;
+    move_t list[MOVES_MAX];
+
+    b.current_player = OPPONENT(b.current_player);
+    return move_generate(&b, list) < 0;
+}
+
+/* Stores the legal moves of a position in list and returns their number. */
+static int legal_moves(board_t *board, move_t *list)
+{
+    move_t moves[MOVES_MAX];
+    move_t replies[MOVES_MAX];
+    int count = move_generate(board, moves);
+    int legal = 0;
+    int i;
+
+    for (i = 0; i < count; i++)
+    {
+        board_t b = *board;
+
+        execute_move(&b, moves[i]);
+
+        if (move_generate(&b, replies) >= 0)
+            list[legal++] = moves[i];
+    }
+
+    return legal;
+}
+
+static int play(dreamer_t *d, move_t move)
+{
+    char *s = coord_move_str(move);
+    int retval = dreamer_move(d, s);
+
+    free(s);
+    return retval;
+}
+
+static int insufficient_material(board_t *board)
+{
+    /* Kings and at most one minor piece. */
+    return board->num_pawns[SIDE_WHITE] == 0 && board->num_pawns[SIDE_BLACK] == 0
+           && board->material_value[SIDE_WHITE] + board->material_value[SIDE_BLACK]
+              <= 2 * 2000 + 350;
+}
+
+/* Plays a game, stores its quiet positions in pos and returns their
+** number. The result is stored in result.
+*/
+static int selfplay_game(dreamer_t *d, int index, packed_t *pos, int *result)
+{
+    unsigned long long random = seed + index * 0x9e3779b97f4a7c15ULL;
+    int winning = 0;
+    int count = 0;
+    int ply = 0;
+    int i;
+
+    if (!random)
+        random = 1;
+
+    /* Random moves, starting over if they lead to the end of the game. */
+    while (ply < SELFPLAY_RANDOM_PLIES)
+    {
+        move_t list[MOVES_MAX];
+        int n;
+
+        if (ply == 0)
+            dreamer_set_position(d, NULL, NULL);
+
+        n = legal_moves(dreamer_board(d), list);
+
+        if (n == 0)
+        {
+            ply = 0;
+            continue;
+        }
+
+        play(d, list[next_random(&random) % n]);
+        ply++;
+    }
+
+    *result = PACKED_DRAW;
+
+    while (ply < SELFPLAY_MAX_PLIES)
+    {
+        board_t *board = dreamer_board(d);
+        int side = board->current_player;
+        int score = 0;
+        move_t move;
+
+        if (is_draw(board) || insufficient_material(board))
+            break;
+
+        move = dreamer_search(d, &limits, selfplay_info, &score);
+
+        if (move == RESIGN_MOVE)
+        {
+            *result = (side == SIDE_WHITE ? PACKED_BLACK_WINS
+                                          : PACKED_WHITE_WINS);
+            break;
+        }
+
+        if (!MOVE_IS_REGULAR(move))
+            break;
+
+        if (side == SIDE_BLACK)
+            score = -score;
+
+        if (abs(score) >= SELFPLAY_WIN_SCORE)
+        {
+            if (++winning >= SELFPLAY_WIN_PLIES)
+            {
+                *result = (score > 0 ? PACKED_WHITE_WINS : PACKED_BLACK_WINS);
+                break;
+            }
+        }
+        else
+            winning = 0;
+
+        /* Positions where the best move wins material, or that are decided,
+        ** teach an evaluation little.
+        */
+        if (!(MOVE_GET(move, TYPE) & (CAPTURE_MOVE | CAPTURE_MOVE_EN_PASSANT
+                                      | MOVE_PROMOTION_MASK))
+            && abs(score) < SELFPLAY_WIN_SCORE && !in_check(board))
+            packed_encode(&pos[count++], board, score, PACKED_DRAW, ply);
+
+        play(d, move);
+        ply++;
+    }
+
+    for (i = 0; i < count; i++)
+        packed_set_result(&pos[i], *result);
+
+    return count;
+}
+
+static void *selfplay_worker(void *arg)
+{
+    dreamer_t *d = dreamer_new(hash_size, NULL);
+    packed_t *pos = malloc(SELFPLAY_MAX_PLIES * sizeof(packed_t));
+
+    while (d && pos)
+    {
+        int index, count, result;
+
+        pthread_mutex_lock(&lock);
+
+        if (next_game >= games_total || error)
+        {
+            pthread_mutex_unlock(&lock);
+            break;
+        }
+
+        index = next_game++;
+        pthread_mutex_unlock(&lock);
+
+        count = selfplay_game(d, index, pos, &result);
+
+        pthread_mutex_lock(&lock);
+
+        if (packed_write(writer, pos, count))
+            error = 1;
+
+        positions += count;
+        results[result]++;
+
+        if ((results[0] + results[1] + results[2]) % 10 == 0)
+        {
+            fprintf(stderr, "Games: %i/%i, positions: %lli\n",
+                    results[0] + results[1] + results[2], games_total,
+                    positions);
+        }
+
+        pthread_mutex_unlock(&lock);
+    }
+
+    if (!d || !pos)
+    {
+        pthread_mutex_lock(&lock);
+        error = 1;
+        pthread_mutex_unlock(&lock);
+    }
+
+    free(pos);
+
+    if (d)
+        dreamer_free(d);
+
+    dreamer_thread_exit();
+    return NULL;
+}
+
+int selfplay(char *filename, int games, int nodes, int threads, int hash)
+{
+    pthread_t *thread;
+    int i;
+
+    writer = packed_writer_open(filename);
+
+    if (!writer)
+    {
+        fprintf(stderr, "Error opening %s\n", filename);
+        return 1;
+    }
+
+    if (threads < 1)
+        threads = 1;
+
+    games_total = games;
+    hash_size = hash;
+    seed = (unsigned long long)time(NULL);
+
+    limits.depth = 0;
+    limits.nodes = nodes;
+    limits.msec = 0;
+    limits.multipv = 1;
+
+    thread = malloc(threads * sizeof(pthread_t));
+
+    for (i = 0; i < threads; i++)
+        pthread_create(&thread[i], NULL, selfplay_worker, NULL);
+
+    for (i = 0; i < threads; i++)
+        pthread_join(thread[i], NULL);
+
+    free(thread);
+
+    if (packed_writer_close(writer))
+        error = 1;
+
+    if (error)
+        fprintf(stderr, "Error writing %s\n", filename);
+
+    printf("Games: %i (+%i =%i -%i), positions: %lli\n",
+           results[0] + results[1] + results[2],
+           results[PACKED_WHITE_WINS], results[PACKED_DRAW],
+           results[PACKED_BLACK_WINS], positions);
+
+    return error;
+}
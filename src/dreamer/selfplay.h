@@ -0,0 +1,42 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SELFPLAY_H
+#define SELFPLAY_H
+
+#define SELFPLAY_DEFAULT_GAMES 100
+#define SELFPLAY_DEFAULT_NODES 5000
+#define SELFPLAY_DEFAULT_HASH 16
+
+int selfplay(char *filename, int games, int nodes, int threads, int hash);
+/* Plays games against itself and appends the quiet positions of the games
+** to a file of packed positions (see packed.h), with the search score and
+** the result of the game. Games start with a few random moves, after
+** which every move is searched for a fixed number of nodes.
+** Parameters: (char *) filename: The output file.
+**             (int) games: Number of games to play.
+**             (int) nodes: Nodes to search each move for.
+**             (int) threads: Number of games to play at once.
+**             (int) hash: Size of the transposition table of each thread,
+**                 in megabytes.
+** Returns   : (int) 0 on success, 1 if the file can't be written.
+*/
+
+#endif /* SELFPLAY_H */
@@ -0,0 +1,977 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <errno.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "config.h"
+
+#ifdef HAVE_SYS_UN_H
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif /* HAVE_SYS_UN_H */
+
+#include "instance.h"
+#include "commands.h"
+#include "search.h"
+#include "server.h"
+#include "timer.h"
+#include "uci.h"
+
+/* Maximum length of a line sent to a client. */
+#define SERVER_LINE 2048
+
+/* Plies after which the load test stops a game. */
+#define SERVER_BENCH_PLIES 160
+
+typedef struct game game_t;
+
+typedef struct
+{
+    int in, out;
+    char *buf;     /* Input that doesn't make a full line yet. */
+    int len, size;
+    game_t *games;
+    int refs;      /* The reader of the client, and every search for it. */
+}
+client_t;
+
+struct game
+{
+    char *id;
+    client_t *client;
+    dreamer_t *d;
+    dreamer_limits_t limits;
+    long long queued;     /* Arrival of the "go" command in milliseconds. */
+    int busy;             /* From "go" until the best move is sent. */
+    int running;          /* A thread is searching. */
+    volatile int stopped;
+    volatile int post;
+    int freed;            /* The game ended while it was busy. */
+    game_t *next;         /* Next game of the same client. */
+    game_t *next_job;
+};
+
+/* Guards the job queue, the games and the client reference counts. */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t job_cond = PTHREAD_COND_INITIALIZER;
+static game_t *job_head, *job_tail;
+static int quitting;
+static int searches; /* Queued or running searches. */
+
+static pthread_t *pool;
+static int pool_size;
+
+/* Holds the transposition table that the games share. */
+static dreamer_t *table;
+
+static void client_send(client_t *client, const char *fmt, ...)
+{
+    char line[SERVER_LINE];
+    va_list ap;
+    int len, done = 0;
+
+    va_start(ap, fmt);
+    len = vsnprintf(line, sizeof(line), fmt, ap);
+    va_end(ap);
+
+    if (len < 0)
+        return;
+
+    if (len >= (int)sizeof(line))
+    {
+        len = sizeof(line) - 1;
+        line[len - 1] = '\n';
+    }
+
+    /* A line is written at once, so lines from different games can't
+    ** interleave.
+    */
+    while (done < len)
+    {
+        int n = write(client->out, line + done, len - done);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+
+        if (n <= 0)
+            return;
+
+        done += n;
+    }
+}
+
+static char *client_read(client_t *client)
+{
+    for (;;)
+    {
+        char *end = memchr(client->buf, '\n', client->len);
+        int n;
+
+        if (end)
+        {
+            int len = end - client->buf;
+            char *line = malloc(len + 1);
+
+            memcpy(line, client->buf, len);
+            line[len] = '\0';
+
+            if (len > 0 && line[len - 1] == '\r')
+                line[len - 1] = '\0';
+
+            client->len -= len + 1;
+            memmove(client->buf, end + 1, client->len);
+            return line;
+        }
+
+        if (client->len == client->size)
+        {
+            client->size *= 2;
+            client->buf = realloc(client->buf, client->size);
+        }
+
+        n = read(client->in, client->buf + client->len,
+                 client->size - client->len);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+
+        if (n <= 0)
+            return NULL;
+
+        client->len += n;
+    }
+}
+
+static client_t *client_new(int in, int out)
+{
+    client_t *client = calloc(1, sizeof(client_t));
+
+    client->in = in;
+    client->out = out;
+    client->size = 256;
+    client->buf = malloc(client->size);
+    client->refs = 1;
+
+    return client;
+}
+
+/* Must be called with the lock held. */
+static void client_release(client_t *client)
+{
+    if (--client->refs > 0)
+        return;
+
+    close(client->in);
+
+    if (client->out != client->in)
+        close(client->out);
+
+    free(client->buf);
+    free(client);
+}
+
+static game_t *game_find(client_t *client, char *id)
+{
+    game_t *game;
+
+    for (game = client->games; game; game = game->next)
+        if (!strcmp(game->id, id))
+            return game;
+
+    return NULL;
+}
+
+static game_t *game_new(client_t *client, char *id)
+{
+    game_t *game = calloc(1, sizeof(game_t));
+
+    if (!game)
+        return NULL;
+
+    game->d = dreamer_new(0, table);
+
+    if (!game->d)
+    {
+        free(game);
+        return NULL;
+    }
+
+    game->id = strdup(id);
+    game->client = client;
+
+    pthread_mutex_lock(&lock);
+    game->next = client->games;
+    client->games = game;
+    pthread_mutex_unlock(&lock);
+
+    return game;
+}
+
+static void game_destroy(game_t *game)
+{
+    dreamer_free(game->d);
+    free(game->id);
+    free(game);
+}
+
+/* Must be called with the lock held. */
+static void game_stop(game_t *game)
+{
+    game->stopped = 1;
+
+    if (game->running)
+        dreamer_stop(game->d);
+}
+
+/* Removes a game from its client. A busy game is destroyed by the thread
+** that serves its search. Must be called with the lock held.
+*/
+static void game_end(game_t *game)
+{
+    game_t **p = &game->client->games;
+
+    while (*p != game)
+        p = &(*p)->next;
+
+    *p = game->next;
+
+    if (game->busy)
+    {
+        game->freed = 1;
+        game_stop(game);
+    }
+    else
+        game_destroy(game);
+}
+
+/* Called by the search with every new best line. */
+static void search_info(void *data, search_info_t *info)
+{
+    game_t *game = data;
+    char line[SERVER_LINE];
+    int len, i;
+
+    if (!game->post)
+        return;
+
+    len = snprintf(line, sizeof(line), "info depth %i seldepth %i",
+                   info->depth, info->sel_depth);
+
+    if (info->score > ALPHABETA_MAX - 1000)
+        len += snprintf(line + len, sizeof(line) - len, " score mate %i",
+                        (ALPHABETA_MAX - info->score + 1) / 2);
+    else if (info->score < ALPHABETA_MIN + 1000)
+        len += snprintf(line + len, sizeof(line) - len, " score mate %i",
+                        -(info->score - ALPHABETA_MIN + 1) / 2);
+    else
+        len += snprintf(line + len, sizeof(line) - len, " score cp %i",
+                        info->score);
+
+    len += snprintf(line + len, sizeof(line) - len,
+                    " nodes %i time %i tbhits %i pv", info->nodes, info->msec,
+                    info->tb_hits);
+
+    for (i = 0; i < info->len && len < (int)sizeof(line) - 8; i++)
+    {
+        char *s = coord_move_str(info->pv[i]);
+        len += snprintf(line + len, sizeof(line) - len, " %s", s);
+        free(s);
+    }
+
+    client_send(game->client, "%s %s\n", game->id, line);
+}
+
+static void *worker(void *arg)
+{
+    for (;;)
+    {
+        game_t *game;
+        client_t *client;
+        dreamer_limits_t limits;
+        char line[SERVER_LINE];
+        move_t move;
+
+        pthread_mutex_lock(&lock);
+
+        while (!job_head && !quitting)
+            pthread_cond_wait(&job_cond, &lock);
+
+        game = job_head;
+
+        if (!game)
+        {
+            pthread_mutex_unlock(&lock);
+            break;
+        }
+
+        job_head = game->next_job;
+
+        if (!job_head)
+            job_tail = NULL;
+
+        client = game->client;
+
+        if (game->freed)
+        {
+            searches--;
+            game_destroy(game);
+            client_release(client);
+            pthread_mutex_unlock(&lock);
+            continue;
+        }
+
+        limits = game->limits;
+
+        if (game->stopped)
+            limits.depth = 1;
+        else if (limits.msec > 0)
+        {
+            /* The clock kept running while the game waited for us. */
+            limits.msec -= (int)(timer_now() - game->queued);
+
+            if (limits.msec < 1)
+                limits.msec = 1;
+        }
+
+        game->running = 1;
+        pthread_mutex_unlock(&lock);
+
+        move = dreamer_search(game->d, &limits, search_info, game);
+
+        if (move == NO_MOVE || move == RESIGN_MOVE || move == STALEMATE_MOVE)
+            snprintf(line, sizeof(line), "%s bestmove 0000\n", game->id);
+        else
+        {
+            char *s = coord_move_str(move);
+            move_t ponder = dreamer_ponder_move(game->d);
+
+            if (ponder != NO_MOVE)
+            {
+                char *p = coord_move_str(ponder);
+                snprintf(line, sizeof(line), "%s bestmove %s ponder %s\n",
+                         game->id, s, p);
+                free(p);
+            }
+            else
+                snprintf(line, sizeof(line), "%s bestmove %s\n", game->id, s);
+
+            free(s);
+        }
+
+        /* The game is ready for the next "go" before the client can see
+        ** the best move.
+        */
+        pthread_mutex_lock(&lock);
+        searches--;
+        game->running = 0;
+        game->busy = 0;
+        game->stopped = 0;
+
+        if (game->freed)
+        {
+            game_destroy(game);
+            client_release(client);
+            pthread_mutex_unlock(&lock);
+            continue;
+        }
+
+        pthread_mutex_unlock(&lock);
+
+        client_send(client, "%s", line);
+
+        pthread_mutex_lock(&lock);
+        client_release(client);
+        pthread_mutex_unlock(&lock);
+    }
+
+    dreamer_thread_exit();
+    return NULL;
+}
+
+static int pool_start(int workers, int hash)
+{
+    int i;
+
+    table = dreamer_new(hash, NULL);
+
+    if (!table)
+    {
+        fprintf(stderr, "Not enough memory for %i MB of hash\n", hash);
+        return 1;
+    }
+
+    if (workers < 1)
+        workers = 1;
+
+    pool = malloc(workers * sizeof(pthread_t));
+    pool_size = workers;
+    quitting = 0;
+
+    for (i = 0; i < workers; i++)
+        pthread_create(&pool[i], NULL, worker, NULL);
+
+    return 0;
+}
+
+static void pool_stop(void)
+{
+    int i;
+
+    pthread_mutex_lock(&lock);
+    quitting = 1;
+    pthread_cond_broadcast(&job_cond);
+    pthread_mutex_unlock(&lock);
+
+    for (i = 0; i < pool_size; i++)
+        pthread_join(pool[i], NULL);
+
+    free(pool);
+    dreamer_free(table);
+}
+
+/* Returns the next space separated word of *s, and moves *s past it. */
+static char *next_word(char **s)
+{
+    char *word = *s + strspn(*s, " \t");
+
+    if (!*word)
+        return NULL;
+
+    *s = word + strcspn(word, " \t");
+
+    if (**s)
+        *(*s)++ = '\0';
+
+    return word;
+}
+
+static void server_position(game_t *game, char *args)
+{
+    char *moves = strstr(args, " moves");
+    char *fen = NULL;
+
+    if (moves)
+    {
+        *moves = '\0';
+        moves += 6;
+    }
+
+    args += strspn(args, " \t");
+
+    if (!strncmp(args, "fen ", 4))
+        fen = args + 4;
+    else if (strcmp(args, "startpos"))
+    {
+        client_send(game->client, "%s error Invalid position %s\n",
+                    game->id, args);
+        return;
+    }
+
+    if (dreamer_set_position(game->d, fen, moves))
+        client_send(game->client, "%s error Illegal position or move\n",
+                    game->id);
+}
+
+static void server_go(game_t *game, char *args)
+{
+    int time[2] = {-1, -1};
+    int inc[2] = {0, 0};
+    int moves_to_go = 0;
+    int move_time = -1;
+    int me = dreamer_side_to_move(game->d);
+    dreamer_limits_t *limits = &game->limits;
+    char *token;
+
+    memset(limits, 0, sizeof(dreamer_limits_t));
+
+    while ((token = next_word(&args)))
+    {
+        char *word = next_word(&args);
+        int arg;
+
+        if (!word)
+            break;
+
+        arg = atoi(word);
+
+        if (!strcmp(token, "wtime"))
+            time[SIDE_WHITE] = arg;
+        else if (!strcmp(token, "btime"))
+            time[SIDE_BLACK] = arg;
+        else if (!strcmp(token, "winc"))
+            inc[SIDE_WHITE] = arg;
+        else if (!strcmp(token, "binc"))
+            inc[SIDE_BLACK] = arg;
+        else if (!strcmp(token, "movestogo"))
+            moves_to_go = arg;
+        else if (!strcmp(token, "movetime"))
+            move_time = arg;
+        else if (!strcmp(token, "depth"))
+        {
+            /* Too deep is clamped, as uci_go() does, rather than taken for
+            ** no limit.
+            */
+            if (arg > MAX_DEPTH)
+                arg = MAX_DEPTH;
+
+            limits->depth = (arg >= 1 ? arg : 0);
+        }
+        else if (!strcmp(token, "nodes"))
+            limits->nodes = arg;
+    }
+
+    if (move_time >= 0)
+        limits->msec = move_time;
+    else if (time[me] >= 0)
+        /* The clocks are in milliseconds, uci_move_time() uses
+        ** centiseconds.
+        */
+        limits->msec = uci_move_time(time[me] / 10, inc[me] / 10,
+                                     moves_to_go) * 10;
+
+    /* Zero means no limit. */
+    if ((move_time >= 0 || time[me] >= 0) && limits->msec < 1)
+        limits->msec = 1;
+
+    pthread_mutex_lock(&lock);
+
+    /* With more searches than threads, a search gets its share of a
+    ** thread.
+    */
+    if (limits->msec > 1 && searches >= pool_size)
+        limits->msec = limits->msec * pool_size / (searches + 1) + 1;
+
+    searches++;
+    game->busy = 1;
+    game->stopped = 0;
+    game->queued = timer_now();
+    game->next_job = NULL;
+    game->client->refs++;
+
+    if (job_tail)
+        job_tail->next_job = game;
+    else
+        job_head = game;
+
+    job_tail = game;
+    pthread_cond_signal(&job_cond);
+    pthread_mutex_unlock(&lock);
+}
+
+/* Handles a line from a client. Returns 1 if the client quits. */
+static int server_handle(client_t *client, char *line)
+{
+    char *id = next_word(&line);
+    char *command;
+    game_t *game;
+    int busy;
+
+    if (!id)
+        return 0;
+
+    command = next_word(&line);
+
+    if (!command)
+    {
+        if (!strcmp(id, "quit"))
+            return 1;
+
+        client_send(client, "error Unknown command %s\n", id);
+        return 0;
+    }
+
+    game = game_find(client, id);
+
+    if (!game)
+    {
+        if (strcmp(command, "position"))
+        {
+            client_send(client, "%s error Unknown game\n", id);
+            return 0;
+        }
+
+        game = game_new(client, id);
+
+        if (!game)
+        {
+            client_send(client, "%s error Out of memory\n", id);
+            return 0;
+        }
+    }
+
+    if (!strcmp(command, "stop"))
+    {
+        pthread_mutex_lock(&lock);
+        if (game->busy)
+            game_stop(game);
+        pthread_mutex_unlock(&lock);
+        return 0;
+    }
+
+    if (!strcmp(command, "free"))
+    {
+        pthread_mutex_lock(&lock);
+        game_end(game);
+        pthread_mutex_unlock(&lock);
+        return 0;
+    }
+
+    if (!strcmp(command, "post") || !strcmp(command, "nopost"))
+    {
+        game->post = !strcmp(command, "post");
+        return 0;
+    }
+
+    pthread_mutex_lock(&lock);
+    busy = game->busy;
+    pthread_mutex_unlock(&lock);
+
+    /* The other commands must wait for the best move. */
+    if (busy)
+    {
+        client_send(client, "%s error Busy\n", id);
+        return 0;
+    }
+
+    if (!strcmp(command, "position"))
+        server_position(game, line);
+    else if (!strcmp(command, "go"))
+        server_go(game, line);
+    else
+        client_send(client, "%s error Unknown command %s\n", id, command);
+
+    return 0;
+}
+
+static void *server_client(void *arg)
+{
+    client_t *client = arg;
+    char *line;
+
+    while ((line = client_read(client)))
+    {
+        int quit = server_handle(client, line);
+
+        free(line);
+
+        if (quit)
+            break;
+    }
+
+    pthread_mutex_lock(&lock);
+
+    while (client->games)
+        game_end(client->games);
+
+    client_release(client);
+    pthread_mutex_unlock(&lock);
+
+    dreamer_thread_exit();
+    return NULL;
+}
+
+#ifdef HAVE_SYS_UN_H
+static int server_socket(char *path)
+{
+    struct sockaddr_un addr;
+    int fd;
+
+    if (strlen(path) >= sizeof(addr.sun_path))
+    {
+        fprintf(stderr, "Socket path too long: %s\n", path);
+        return -1;
+    }
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd < 0)
+    {
+        perror("socket");
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    /* Replace the socket of an earlier server. */
+    unlink(path);
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) || listen(fd, 16))
+    {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+#endif /* HAVE_SYS_UN_H */
+
+int server(char *socket_path, int workers, int hash)
+{
+    int fd = -1;
+
+#ifdef SIGPIPE
+    /* Clients may go away at any time. */
+    signal(SIGPIPE, SIG_IGN);
+#endif /* SIGPIPE */
+
+    if (socket_path)
+    {
+#ifdef HAVE_SYS_UN_H
+        fd = server_socket(socket_path);
+#else
+        fprintf(stderr, "Unix sockets are not supported\n");
+#endif /* HAVE_SYS_UN_H */
+
+        if (fd < 0)
+            return 1;
+    }
+
+    if (pool_start(workers, hash))
+        return 1;
+
+    if (fd < 0)
+        server_client(client_new(0, 1));
+#ifdef HAVE_SYS_UN_H
+    else
+    {
+        for (;;)
+        {
+            pthread_t thread;
+            int conn = accept(fd, NULL, NULL);
+
+            if (conn < 0)
+            {
+                if (errno == EINTR || errno == ECONNABORTED)
+                    continue;
+
+                perror("accept");
+                break;
+            }
+
+            if (pthread_create(&thread, NULL, server_client,
+                               client_new(conn, conn)))
+            {
+                close(conn);
+                continue;
+            }
+
+            pthread_detach(thread);
+        }
+
+        close(fd);
+    }
+#endif /* HAVE_SYS_UN_H */
+
+    pool_stop();
+    return 0;
+}
+
+/* Openings for the load test, so that the games differ. */
+static char *bench_openings[] =
+{
+    "e2e4 e7e5", "e2e4 c7c5", "d2d4 d7d5", "d2d4 g8f6",
+    "c2c4 e7e5", "g1f3 d7d5", "e2e4 e7e6", "e2e4 c7c6"
+};
+
+typedef struct
+{
+    char *moves;     /* Moves played, in coordinate notation. */
+    int len, size;
+    int plies;
+    int clock[2];    /* Milliseconds left for each side. */
+    long long start; /* When the side to move started thinking. */
+}
+bench_game_t;
+
+static void bench_write(int fd, const char *s)
+{
+    int len = strlen(s), done = 0;
+
+    while (done < len)
+    {
+        int n = write(fd, s + done, len - done);
+
+        if (n <= 0)
+            return;
+
+        done += n;
+    }
+}
+
+static void bench_go(int fd, int index, bench_game_t *game, int inc)
+{
+    char line[128];
+
+    bench_write(fd, "g");
+    sprintf(line, "%i position startpos moves ", index);
+    bench_write(fd, line);
+    bench_write(fd, game->moves);
+    sprintf(line, "\ng%i go wtime %i btime %i winc %i binc %i\n", index,
+            game->clock[SIDE_WHITE], game->clock[SIDE_BLACK], inc, inc);
+    bench_write(fd, line);
+    game->start = timer_now();
+}
+
+static void bench_play(bench_game_t *game, char *move)
+{
+    int len = strlen(move) + 1;
+
+    if (game->len + len + 1 > game->size)
+    {
+        game->size = (game->len + len + 1) * 2;
+        game->moves = realloc(game->moves, game->size);
+    }
+
+    sprintf(game->moves + game->len, " %s", move);
+    game->len += len;
+    game->plies++;
+}
+
+int server_bench(int games, int clock, int workers, int hash)
+{
+    int to_server[2], from_server[2];
+    int inc = clock * 10;
+    int active = games;
+    int moves = 0, ended = 0, stopped = 0, lost = 0, errors = 0;
+    long long total_msec = 0, max_msec = 0, start;
+    bench_game_t *game;
+    pthread_t thread;
+    char line[SERVER_LINE];
+    FILE *in;
+    int i;
+
+    if (games < 1)
+        games = active = 1;
+
+    if (pipe(to_server) || pipe(from_server))
+    {
+        perror("pipe");
+        return 1;
+    }
+
+    if (pool_start(workers, hash))
+        return 1;
+
+    pthread_create(&thread, NULL, server_client,
+                   client_new(to_server[0], from_server[1]));
+    in = fdopen(from_server[0], "r");
+
+    printf("Playing %i games of %i+%g seconds on %i threads with %i MB of "
+           "hash\n", games, clock, inc / 1000.0, pool_size, hash);
+
+    game = calloc(games, sizeof(bench_game_t));
+    start = timer_now();
+
+    for (i = 0; i < games; i++)
+    {
+        game[i].size = 64;
+        game[i].moves = malloc(game[i].size);
+        strcpy(game[i].moves, bench_openings[i % (sizeof(bench_openings)
+                                               / sizeof(char *))]);
+        game[i].len = strlen(game[i].moves);
+        game[i].plies = 2;
+        game[i].clock[SIDE_WHITE] = game[i].clock[SIDE_BLACK] = clock * 1000;
+        bench_go(to_server[1], i, &game[i], inc);
+    }
+
+    while (active > 0 && fgets(line, sizeof(line), in))
+    {
+        char command[16], move[16];
+        long long msec;
+        int side, index;
+
+        if (sscanf(line, "g%i %15s %15s", &index, command, move) != 3
+            || index < 0 || index >= games || strcmp(command, "bestmove"))
+        {
+            printf("Unexpected reply: %s", line);
+            errors++;
+            continue;
+        }
+
+        msec = timer_now() - game[index].start;
+        total_msec += msec;
+        moves++;
+
+        if (msec > max_msec)
+            max_msec = msec;
+
+        side = game[index].plies & 1;
+        game[index].clock[side] -= msec;
+
+        if (game[index].clock[side] < 0)
+        {
+            printf("Game %i lost on time at ply %i\n", index,
+                   game[index].plies);
+            lost++;
+            active--;
+            continue;
+        }
+
+        game[index].clock[side] += inc;
+
+        if (!strcmp(move, "0000"))
+        {
+            ended++;
+            active--;
+            continue;
+        }
+
+        bench_play(&game[index], move);
+
+        if (game[index].plies >= SERVER_BENCH_PLIES)
+        {
+            stopped++;
+            active--;
+            continue;
+        }
+
+        bench_go(to_server[1], index, &game[index], inc);
+    }
+
+    /* Closing the connection ends all games. */
+    close(to_server[1]);
+    pthread_join(thread, NULL);
+    fclose(in);
+    pool_stop();
+
+    printf("Games       : %i finished, %i stopped after %i plies, %i lost on "
+           "time\n", ended, stopped, SERVER_BENCH_PLIES, lost);
+    printf("Moves       : %i, %lli ms average, %lli ms at most\n", moves,
+           moves ? total_msec / moves : 0, max_msec);
+    printf("Time        : %lli ms\n", timer_now() - start);
+    printf("Moves/second: %lli\n", moves * 1000LL / (timer_now() - start + 1));
+
+    for (i = 0; i < games; i++)
+        free(game[i].moves);
+
+    free(game);
+
+    return lost > 0 || errors > 0 || active > 0;
+}
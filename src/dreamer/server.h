@@ -0,0 +1,66 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#define SERVER_DEFAULT_HASH 64
+#define SERVER_BENCH_GAMES 16
+#define SERVER_BENCH_CLOCK 10
+
+int server(char *socket_path, int workers, int hash);
+/* Plays many games at once. Every command starts with the id of the game
+** it's for; games are created by their first "position" command:
+**
+**   <id> position startpos|fen <fen> [moves <move> ...]
+**   <id> go [wtime|btime|winc|binc|movestogo|movetime|depth|nodes <n>] ...
+**   <id> stop
+**   <id> post|nopost
+**   <id> free
+**   quit
+**
+** Arguments are those of the UCI commands of the same name. The engine
+** answers "<id> bestmove <move> [ponder <move>]" to every "go", with 0000
+** for no move, and "<id> error <message>" to commands it can't carry out.
+** Searches run on a fixed pool of threads and all games share one
+** transposition table. Time spent waiting for a free thread is taken from
+** the game's clock.
+** Parameters: (char *) socket_path: Unix socket to listen on, or NULL to
+**                 serve a single client on stdin/stdout. Every connection
+**                 has games of its own; "quit" closes the connection.
+**             (int) workers: Number of search threads.
+**             (int) hash: Transposition table size in megabytes, for all
+**                 games together.
+** Returns   : (int) 0 on success, 1 if the server couldn't start.
+*/
+
+int server_bench(int games, int clock, int workers, int hash);
+/* Load test for the server. A driver plays games against itself through
+** the server protocol, all at the same time, and reports the time used per
+** move and any games lost on time.
+** Parameters: (int) games: Number of simultaneous games.
+**             (int) clock: Seconds per side for each game, with an
+**                 increment of a hundredth of that per move.
+**             (int) workers: Number of search threads.
+**             (int) hash: Transposition table size in megabytes.
+** Returns   : (int) 0 if no game was lost on time, 1 otherwise.
+*/
+
+#endif /* SERVER_H */
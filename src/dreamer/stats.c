@@ -0,0 +1,113 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "e_comm.h"
+#include "stats.h"
+
+THREAD_LOCAL stats_t stats;
+
+void stats_clear(int plies)
+{
+    int *nodes = stats.nodes;
+    int *qnodes = stats.qnodes;
+
+    if (plies > stats.plies)
+    {
+        nodes = realloc(nodes, plies * sizeof(int));
+        qnodes = realloc(qnodes, plies * sizeof(int));
+    }
+    else
+        plies = stats.plies;
+
+    memset(&stats, 0, sizeof(stats));
+    memset(nodes, 0, plies * sizeof(int));
+    memset(qnodes, 0, plies * sizeof(int));
+
+    stats.plies = plies;
+    stats.nodes = nodes;
+    stats.qnodes = qnodes;
+}
+
+void stats_exit(void)
+{
+    free(stats.nodes);
+    free(stats.qnodes);
+    memset(&stats, 0, sizeof(stats));
+}
+
+void stats_iteration(int nodes)
+{
+    int i;
+
+    if (stats.iterations == MAX_DEPTH)
+        return;
+
+    for (i = 0; i < stats.iterations; i++)
+        nodes -= stats.iter_nodes[i];
+
+    stats.iter_nodes[stats.iterations++] = nodes;
+}
+
+static double percentage(int part, int total)
+{
+    return total > 0 ? part * 100.0 / total : 0.0;
+}
+
+void stats_print(void)
+{
+    long long nodes = 0, qnodes = 0;
+    int i;
+
+    for (i = 0; i < stats.plies; i++)
+    {
+        nodes += stats.nodes[i];
+        qnodes += stats.qnodes[i];
+    }
+
+    e_comm_send("Nodes: %lli (main %lli, quiescence %lli)\n",
+                nodes + qnodes, nodes, qnodes);
+
+    e_comm_send("Ply      Main   Quiesce\n");
+    for (i = 0; i < stats.plies; i++)
+        if (stats.nodes[i] || stats.qnodes[i])
+            e_comm_send("%3i %9i %9i\n", i, stats.nodes[i], stats.qnodes[i]);
+
+    e_comm_send("Depth    Nodes     EBF\n");
+    for (i = 0; i < stats.iterations; i++)
+    {
+        e_comm_send("%3i %9i", i + 1, stats.iter_nodes[i]);
+
+        if (i > 0 && stats.iter_nodes[i - 1] > 0)
+            e_comm_send(" %7.2f", (double)stats.iter_nodes[i]
+                        / stats.iter_nodes[i - 1]);
+
+        e_comm_send("\n");
+    }
+
+    e_comm_send("Beta cutoffs: %i (first move %.1f%%)\n", stats.cutoffs,
+                percentage(stats.first_cutoffs, stats.cutoffs));
+    e_comm_send("TT probes: %i (hits %.1f%%, cutoffs %.1f%%)\n",
+                stats.tt_probes, percentage(stats.tt_hits, stats.tt_probes),
+                percentage(stats.tt_cutoffs, stats.tt_probes));
+    e_comm_send("Eval calls: %i\n", stats.evals);
+    e_comm_send("Tablebase hits: %i\n", stats.tb_hits);
+}
@@ -0,0 +1,72 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef STATS_H
+#define STATS_H
+
+#include "dreamer.h"
+
+typedef struct
+{
+    int plies;
+    int *nodes;                 /* Main search nodes per ply. */
+    int *qnodes;                /* Quiescence nodes per ply. */
+    int iter_nodes[MAX_DEPTH];  /* Nodes searched per iteration. */
+    int iterations;
+    int cutoffs;                /* Beta cutoffs in the main search. */
+    int first_cutoffs;          /* Beta cutoffs by the first legal move. */
+    int tt_probes;
+    int tt_hits;                /* Probes that found the position. */
+    int tt_cutoffs;             /* Probes that ended the search of a node. */
+    int evals;
+    int tb_hits;                /* Positions found in the tablebases. */
+} stats_t;
+
+/* Counters are kept per thread, so that searches running in parallel
+** don't contend on them.
+*/
+extern THREAD_LOCAL stats_t stats;
+
+#define STATS_INC(X) (stats.X++)
+
+void stats_clear(int plies);
+/* Resets the statistics of the current thread.
+** Parameters: (int) plies: Size of the ply stack of the search.
+** Returns   : (void)
+*/
+
+void stats_exit(void);
+/* Frees the per-ply counters of the current thread.
+** Parameters: (void)
+** Returns   : (void)
+*/
+
+void stats_iteration(int nodes);
+/* Records the end of an iteration of the search.
+** Parameters: (int) nodes: Total nodes searched so far.
+** Returns   : (void)
+*/
+
+void stats_print(void);
+/* Prints the statistics of the last search of the current thread.
+** Parameters: (void)
+** Returns   : (void)
+*/
+
+#endif /* STATS_H */
@@ -0,0 +1,456 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "config.h"
+
+#ifdef HAVE_FORK
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif /* HAVE_FORK */
+
+#include "dreamer.h"
+#include "commands.h"
+#include "e_comm.h"
+#include "epd.h"
+#include "history.h"
+#include "move.h"
+#include "repetition.h"
+#include "search.h"
+#include "suite.h"
+#include "timer.h"
+#include "transposition.h"
+
+/* Maximum number of moves in a "bm" or "am" operation. */
+#define SUITE_MOVES 8
+
+typedef struct
+{
+    move_t move;     /* Move played, NO_MOVE if the search failed. */
+    int solved;
+    int nodes;       /* Node count at which the solution was found. */
+    int msec;        /* Time at which the solution was found. */
+    int total_nodes;
+    int total_msec;
+} result_t;
+
+typedef struct
+{
+    board_t board;
+    char *id;
+    char *expected;
+    move_t best[SUITE_MOVES];
+    int best_count;
+    move_t avoid[SUITE_MOVES];
+    int avoid_count;
+    result_t result;
+    int done;
+} position_t;
+
+/* Parses the moves of a "bm" or "am" operand into list. Returns the number
+** of moves, or -1 if the operand has no moves or a move that isn't legal.
+*/
+static int parse_moves(board_t *board, char *operand, move_t *list)
+{
+    int count = 0;
+    char *s = strtok(operand, " \t");
+
+    while (s && count < SUITE_MOVES)
+    {
+        move_t move;
+
+        if (parse_move(board, 0, s, &move) || move == NO_MOVE)
+        {
+            e_comm_send("Illegal move in test suite: %s\n", s);
+            return -1;
+        }
+
+        list[count++] = move;
+        s = strtok(NULL, " \t");
+    }
+
+    return (count > 0 ? count : -1);
+}
+
+static int load_position(position_t *pos, char *line)
+{
+    char *ops;
+    char *bm, *am;
+    int error = 0;
+
+    if (epd_parse(line, &pos->board, &ops))
+        return 1;
+
+    bm = epd_operand(ops, "bm");
+    am = epd_operand(ops, "am");
+
+    if (!bm && !am)
+        return 1;
+
+    pos->id = epd_operand(ops, "id");
+    pos->done = 0;
+    pos->best_count = 0;
+    pos->avoid_count = 0;
+
+    if (bm)
+        pos->expected = strdup(bm);
+    else
+    {
+        pos->expected = malloc(strlen(am) + 4);
+        sprintf(pos->expected, "am %s", am);
+    }
+
+    /* A position whose solution can't be read would count as solved by
+    ** any move, so it's skipped instead.
+    */
+    if (bm)
+    {
+        pos->best_count = parse_moves(&pos->board, bm, pos->best);
+        error |= pos->best_count < 0;
+        free(bm);
+    }
+
+    if (am)
+    {
+        pos->avoid_count = parse_moves(&pos->board, am, pos->avoid);
+        error |= pos->avoid_count < 0;
+        free(am);
+    }
+
+    if (error)
+    {
+        free(pos->id);
+        free(pos->expected);
+        return 1;
+    }
+
+    return 0;
+}
+
+static int is_solution(position_t *pos, move_t move)
+{
+    int i;
+
+    for (i = 0; i < pos->avoid_count; i++)
+        if (pos->avoid[i] == move)
+            return 0;
+
+    if (pos->best_count == 0)
+        return 1;
+
+    for (i = 0; i < pos->best_count; i++)
+        if (pos->best[i] == move)
+            return 1;
+
+    return 0;
+}
+
+static void search_position(state_t *state, position_t *pos, int msec,
+                            result_t *result)
+{
+    long long start = timer_now();
+    move_t move;
+    int nodes, time;
+    int i;
+
+    state->board = pos->board;
+
+    clear_table();
+    forget_history();
+    pv_clear();
+    repetition_init(&state->board);
+
+    state->depth = MAX_DEPTH;
+    state->nodes = 0;
+    state->flags = 0;
+    timer_init(&state->move_time, 1);
+    timer_set(&state->move_time, msec / 10);
+
+    result->move = find_best_move(state);
+    result->total_nodes = search_nodes();
+    result->total_msec = timer_now() - start;
+    result->solved = MOVE_IS_REGULAR(result->move)
+                     && is_solution(pos, result->move);
+    result->nodes = result->total_nodes;
+    result->msec = result->total_msec;
+
+    if (!MOVE_IS_REGULAR(result->move))
+        result->move = NO_MOVE;
+
+    if (!result->solved)
+        return;
+
+    /* Walk back to the first of the final run of correct best moves. */
+    for (i = 0; !search_best_change(i, &move, &nodes, &time); i++)
+    {
+        if (!is_solution(pos, move))
+            break;
+
+        result->nodes = nodes;
+        result->msec = time;
+    }
+}
+
+static void print_result(position_t *pos, int index)
+{
+    result_t *result = &pos->result;
+    char *found;
+
+    if (result->move != NO_MOVE)
+        found = san_move_str(&pos->board, 0, result->move);
+    else
+        found = strdup("-");
+
+    e_comm_send("%4i %-16s %-4s %-14s %-8s", index + 1,
+                pos->id ? pos->id : "-", result->solved ? "ok" : "FAIL",
+                pos->expected, found);
+
+    if (result->solved)
+        e_comm_send(" %8i %10i\n", result->msec, result->nodes);
+    else
+        e_comm_send(" %8s %10s\n", "-", "-");
+
+    free(found);
+}
+
+#ifdef HAVE_FORK
+
+/* Searches a position in a child process. Returns the pid of the child and
+** sets fd to the read end of the pipe that it sends its result through.
+*/
+static int start_worker(state_t *state, position_t *pos, int msec, int *fd)
+{
+    int fds[2];
+    int pid;
+
+    if (pipe(fds))
+        return -1;
+
+    /* Don't let the child send out our pending output a second time. */
+    e_comm_flush();
+
+    pid = fork();
+
+    if (pid == 0)
+    {
+        result_t result;
+
+        close(fds[0]);
+        search_position(state, pos, msec, &result);
+
+        if (write(fds[1], &result, sizeof(result)) != sizeof(result))
+            _exit(1);
+
+        _exit(0);
+    }
+
+    close(fds[1]);
+
+    if (pid < 0)
+    {
+        close(fds[0]);
+        return -1;
+    }
+
+    *fd = fds[0];
+    return pid;
+}
+
+static void run_workers(state_t *state, position_t *pos, int count,
+                        int msec, int workers)
+{
+    int *pids = malloc(sizeof(int) * workers);
+    int *fds = malloc(sizeof(int) * workers);
+    int *index = malloc(sizeof(int) * workers);
+    int running = 0;
+    int next = 0;
+    int printed = 0;
+
+    while (next < count || running > 0)
+    {
+        int pid;
+        int i;
+
+        while (running < workers && next < count)
+        {
+            pids[running] = start_worker(state, &pos[next], msec,
+                                         &fds[running]);
+
+            if (pids[running] < 0)
+            {
+                /* Fall back to searching in this process. */
+                search_position(state, &pos[next], msec, &pos[next].result);
+                pos[next++].done = 1;
+                continue;
+            }
+
+            index[running++] = next++;
+        }
+
+        if (running > 0)
+        {
+            pid = wait(NULL);
+
+            for (i = 0; i < running; i++)
+                if (pids[i] == pid)
+                    break;
+
+            if (i < running)
+            {
+                position_t *p = &pos[index[i]];
+
+                if (read(fds[i], &p->result, sizeof(p->result))
+                    != sizeof(p->result))
+                {
+                    memset(&p->result, 0, sizeof(p->result));
+                    p->result.move = NO_MOVE;
+                }
+
+                p->done = 1;
+                close(fds[i]);
+
+                running--;
+                pids[i] = pids[running];
+                fds[i] = fds[running];
+                index[i] = index[running];
+            }
+        }
+
+        /* Print the results in the order of the file. */
+        while (printed < count && pos[printed].done)
+        {
+            print_result(&pos[printed], printed);
+            printed++;
+        }
+
+        e_comm_flush();
+    }
+
+    free(pids);
+    free(fds);
+    free(index);
+}
+
+#else
+
+static void run_workers(state_t *state, position_t *pos, int count,
+                        int msec, int workers)
+{
+    int i;
+
+    for (i = 0; i < count; i++)
+    {
+        search_position(state, &pos[i], msec, &pos[i].result);
+        pos[i].done = 1;
+        print_result(&pos[i], i);
+        e_comm_flush();
+    }
+}
+
+#endif /* HAVE_FORK */
+
+int epd_suite(state_t *state, char *filename, int msec, int workers)
+{
+    FILE *f = fopen(filename, "r");
+    char line[4096];
+    position_t *pos = NULL;
+    int count = 0;
+    int solved = 0;
+    long long total_nodes = 0;
+    long long solve_msec = 0;
+    long long start = timer_now();
+    long long elapsed;
+    int i;
+
+    if (!f)
+    {
+        e_comm_send("Error opening %s\n", filename);
+        return 1;
+    }
+
+    while (fgets(line, sizeof(line), f))
+    {
+        char *s = line;
+
+        while (isspace((unsigned char)*s))
+            s++;
+
+        if (!*s || *s == '#')
+            continue;
+
+        pos = realloc(pos, sizeof(position_t) * (count + 1));
+
+        if (load_position(&pos[count], s))
+        {
+            e_comm_send("Skipping invalid test position: %s", s);
+            continue;
+        }
+
+        count++;
+    }
+
+    fclose(f);
+
+    if (workers < 1)
+        workers = 1;
+
+    set_option(OPTION_POST, 0);
+
+    e_comm_send("   # %-16s %-4s %-14s %-8s %8s %10s\n", "Id", "", "Expected",
+                "Found", "Time(ms)", "Nodes");
+
+    run_workers(state, pos, count, msec, workers);
+
+    elapsed = timer_now() - start;
+
+    for (i = 0; i < count; i++)
+    {
+        total_nodes += pos[i].result.total_nodes;
+
+        if (pos[i].result.solved)
+        {
+            solved++;
+            solve_msec += pos[i].result.msec;
+        }
+
+        free(pos[i].id);
+        free(pos[i].expected);
+    }
+
+    free(pos);
+
+    e_comm_send("===========================\n");
+    e_comm_send("Positions       : %i\n", count);
+    e_comm_send("Solved          : %i (%i%%)\n", solved,
+                count > 0 ? solved * 100 / count : 0);
+    e_comm_send("Time per move   : %i ms\n", msec);
+    e_comm_send("Workers         : %i\n", workers);
+    e_comm_send("Solve time (ms) : %lli\n", solve_msec);
+    e_comm_send("Total time (ms) : %lli\n", elapsed);
+    e_comm_send("Nodes searched  : %lli\n", total_nodes);
+    e_comm_send("Nodes/second    : %lli\n",
+                elapsed > 0 ? total_nodes * 1000 / elapsed : 0);
+
+    return solved < count;
+}
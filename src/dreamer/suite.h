@@ -0,0 +1,40 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef SUITE_H
+#define SUITE_H
+
+#include "dreamer.h"
+
+#define SUITE_DEFAULT_TIME 5
+#define SUITE_DEFAULT_HASH 16
+
+int epd_suite(state_t *state, char *filename, int msec, int workers);
+/* Searches all positions of an EPD test suite, such as WAC or STS, and
+** checks the result against the "bm" (best move) and "am" (avoid move)
+** operations. Positions are searched in parallel by separate worker
+** processes where fork() is available.
+** Parameters: (state_t *) state: The engine state, used for searching.
+**             (char *) filename: The EPD file.
+**             (int) msec: Search time per position in milliseconds.
+**             (int) workers: Number of positions to search at once.
+** Returns   : (int) 0 if all positions were solved, 1 otherwise.
+*/
+
+#endif /* SUITE_H */
@@ -0,0 +1,229 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+
+#include "config.h"
+
+#include "syzygy.h"
+#include "move.h"
+
+#ifdef HAVE_SYZYGY
+#include <pthread.h>
+#include <tbprobe.h>
+
+/* Fathom's root probe keeps state of its own, so it's not reentrant. */
+static pthread_mutex_t root_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif /* HAVE_SYZYGY */
+
+/* Number of pieces of the largest table loaded. */
+static int largest;
+
+/* Number of pieces up to which the search probes, 0 for no limit. */
+static int limit = SYZYGY_DEFAULT_LIMIT;
+
+int syzygy_init(char *path)
+{
+#ifdef HAVE_SYZYGY
+    tb_free();
+    largest = 0;
+
+    if (path && *path && tb_init(path))
+        largest = TB_LARGEST;
+#endif /* HAVE_SYZYGY */
+
+    return largest;
+}
+
+void syzygy_set_limit(int pieces)
+{
+    limit = pieces;
+}
+
+int syzygy_pieces(void)
+{
+    if (limit > 0 && limit < largest)
+        return limit;
+
+    return largest;
+}
+
+#ifdef HAVE_SYZYGY
+
+/* Fathom's arguments for a position. */
+typedef struct
+{
+    bitboard_t white, black, kings, queens, rooks, bishops, knights, pawns;
+    unsigned int ep;
+}
+tb_position_t;
+
+static void tb_position(tb_position_t *p, board_t *board)
+{
+    bitboard_t *b = board->bitboard;
+    bitboard_t white_king = board_king(board, SIDE_WHITE);
+    bitboard_t black_king = board_king(board, SIDE_BLACK);
+    int i;
+
+    p->kings = white_king | black_king;
+    p->queens = b[WHITE_QUEEN] | b[BLACK_QUEEN];
+    p->rooks = b[WHITE_ROOK] | b[BLACK_ROOK];
+    p->bishops = b[WHITE_BISHOP] | b[BLACK_BISHOP];
+    p->knights = b[WHITE_KNIGHT] | b[BLACK_KNIGHT];
+    p->pawns = b[WHITE_PAWN] | b[BLACK_PAWN];
+    p->white = white_king | b[WHITE_QUEEN] | b[WHITE_ROOK]
+               | b[WHITE_BISHOP] | b[WHITE_KNIGHT] | b[WHITE_PAWN];
+    p->black = black_king | b[BLACK_QUEEN] | b[BLACK_ROOK]
+               | b[BLACK_BISHOP] | b[BLACK_KNIGHT] | b[BLACK_PAWN];
+
+    p->ep = 0;
+    for (i = 0; i < 64; i++)
+        if (board->en_passant & square_bit[i])
+            p->ep = i;
+}
+
+/* Returns whether a position has few enough pieces and no castling
+** rights, so that it might be in the tables.
+*/
+static int tb_probeable(board_t *board, int max_pieces)
+{
+    bitboard_t all = board->bitboard[WHITE_ALL] | board->bitboard[BLACK_ALL];
+    int pieces = 0;
+
+    if (board->castle_flags & (WHITE_CAN_CASTLE_KINGSIDE
+        | BLACK_CAN_CASTLE_KINGSIDE | WHITE_CAN_CASTLE_QUEENSIDE
+        | BLACK_CAN_CASTLE_QUEENSIDE))
+        return 0;
+
+    /* Right after castling, phantom kings add to the count. That only
+    ** means that the position isn't probed.
+    */
+    while (all)
+    {
+        all &= all - 1;
+        if (++pieces > max_pieces)
+            return 0;
+    }
+
+    return 1;
+}
+
+#endif /* HAVE_SYZYGY */
+
+int syzygy_probe_wdl(board_t *board, int *wdl)
+{
+#ifdef HAVE_SYZYGY
+    tb_position_t p;
+    unsigned int result;
+
+    if (board->fifty_moves != 0 || !tb_probeable(board, syzygy_pieces()))
+        return 0;
+
+    tb_position(&p, board);
+
+    result = tb_probe_wdl(p.white, p.black, p.kings, p.queens, p.rooks,
+                          p.bishops, p.knights, p.pawns, 0, 0, p.ep,
+                          board->current_player == SIDE_WHITE);
+
+    if (result == TB_RESULT_FAILED)
+        return 0;
+
+    *wdl = (int)result - TB_DRAW;
+    return 1;
+#else
+    return 0;
+#endif /* HAVE_SYZYGY */
+}
+
+int syzygy_probe_root(board_t *board, move_t *moves, int *wdl)
+{
+#ifdef HAVE_SYZYGY
+    static const int promotion[] =
+    {
+        0, PROMOTION_MOVE_QUEEN, PROMOTION_MOVE_ROOK, PROMOTION_MOVE_BISHOP,
+        PROMOTION_MOVE_KNIGHT
+    };
+    unsigned int results[TB_MAX_MOVES];
+    tb_position_t p;
+    unsigned int result;
+    int best_wdl = TB_LOSS;
+    int best_dtz = 0;
+    int count = 0;
+    int i;
+
+    if (!tb_probeable(board, largest))
+        return 0;
+
+    tb_position(&p, board);
+
+    pthread_mutex_lock(&root_mutex);
+    result = tb_probe_root(p.white, p.black, p.kings, p.queens, p.rooks,
+                           p.bishops, p.knights, p.pawns, board->fifty_moves,
+                           0, p.ep, board->current_player == SIDE_WHITE,
+                           results);
+    pthread_mutex_unlock(&root_mutex);
+
+    if (result == TB_RESULT_FAILED || result == TB_RESULT_CHECKMATE
+        || result == TB_RESULT_STALEMATE)
+        return 0;
+
+    /* The result of the position is that of its best move. Among the moves
+    ** that keep it, the winning side wants the shortest distance to the
+    ** next zeroing move and the losing side the longest.
+    */
+    for (i = 0; results[i] != TB_RESULT_FAILED; i++)
+    {
+        int move_wdl = (int)TB_GET_WDL(results[i]);
+        int dtz = (int)TB_GET_DTZ(results[i]);
+
+        if (move_wdl > best_wdl)
+        {
+            best_wdl = move_wdl;
+            best_dtz = dtz;
+        }
+        else if (move_wdl == best_wdl)
+        {
+            if (move_wdl > TB_DRAW ? dtz < best_dtz : dtz > best_dtz)
+                best_dtz = dtz;
+        }
+    }
+
+    for (i = 0; results[i] != TB_RESULT_FAILED; i++)
+    {
+        move_t move = 0;
+
+        if ((int)TB_GET_WDL(results[i]) != best_wdl)
+            continue;
+
+        if (best_wdl != TB_DRAW && (int)TB_GET_DTZ(results[i]) != best_dtz)
+            continue;
+
+        MOVE_SET(move, SOURCE, TB_GET_FROM(results[i]));
+        MOVE_SET(move, DEST, TB_GET_TO(results[i]));
+        move |= promotion[TB_GET_PROMOTES(results[i])];
+        moves[count++] = move;
+    }
+
+    *wdl = best_wdl - TB_DRAW;
+    return count;
+#else
+    return 0;
+#endif /* HAVE_SYZYGY */
+}
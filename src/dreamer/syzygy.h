@@ -0,0 +1,96 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SYZYGY_H
+#define SYZYGY_H
+
+#include "board.h"
+
+/* Syzygy endgame tablebases, probed with the Fathom library when dreamer
+** is configured --with-syzygy. Without it, no tables are ever found. The
+** tables are memory-mapped by Fathom, so probing them is cheap once the
+** operating system has the pages cached.
+*/
+
+/* Results of a probe, for the side to move. A cursed win is a win that
+** the 50-move rule turns into a draw, a blessed loss is the reverse.
+*/
+#define SYZYGY_LOSS -2
+#define SYZYGY_BLESSED_LOSS -1
+#define SYZYGY_DRAW 0
+#define SYZYGY_CURSED_WIN 1
+#define SYZYGY_WIN 2
+
+/* Most moves a position can have. */
+#define SYZYGY_MAX_MOVES 256
+
+/* Default number of pieces up to which the search probes, 0 for as many
+** as the tables have.
+*/
+#define SYZYGY_DEFAULT_LIMIT 0
+
+int syzygy_init(char *path);
+/* Loads the tablebases. Tables loaded before are unloaded first.
+** Parameters: (char *) path: Directory with the tables, or several of them
+**                 separated by ':' (';' on Windows). An empty string or
+**                 NULL unloads all tables.
+** Returns   : (int) Number of pieces of the largest table found, or 0 if
+**                 there are none.
+*/
+
+void syzygy_set_limit(int pieces);
+/* Sets the number of pieces up to which the search probes.
+** Parameters: (int) pieces: Number of pieces, kings included, or 0 for as
+**                 many as the tables have.
+** Returns   : (void)
+*/
+
+int syzygy_pieces(void);
+/* Returns the number of pieces up to which positions are probed.
+** Parameters: (void)
+** Returns   : (int) Number of pieces, 0 if there are no tables.
+*/
+
+int syzygy_probe_wdl(board_t *board, int *wdl);
+/* Looks up whether a position is won, drawn or lost. Only positions
+** right after a capture or pawn move, without castling rights and with no
+** more pieces than syzygy_pieces(), are looked up. The position must be
+** legal for the result to mean anything. Can be called from several
+** threads at once.
+** Parameters: (board_t *) board: The position.
+**             (int *) wdl: Receives the result, SYZYGY_LOSS to SYZYGY_WIN.
+** Returns   : (int) 1 if the position was found, 0 if not.
+*/
+
+int syzygy_probe_root(board_t *board, move_t *moves, int *wdl);
+/* Picks the moves of a position that keep its tablebase result, using the
+** distance to zeroing. When winning, only the moves that reach the next
+** capture or pawn move soonest are kept, so that the win isn't lost to the
+** 50-move rule. When losing, the moves that delay it longest are kept.
+** Parameters: (board_t *) board: The position, without castling rights.
+**             (move_t *) moves: Receives the moves, with only the source,
+**                 destination and promotion set. Must have room for
+**                 SYZYGY_MAX_MOVES moves.
+**             (int *) wdl: Receives the result, SYZYGY_LOSS to SYZYGY_WIN.
+** Returns   : (int) Number of moves, 0 if the position wasn't found or if
+**                 there are no legal moves.
+*/
+
+#endif /* SYZYGY_H */
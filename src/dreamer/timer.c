@@ -18,11 +18,39 @@
 **  along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 #include <assert.h>
 #include <sys/time.h>
 #include <stdlib.h>
+#include <time.h>
 #include "timer.h"
 
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC)
+
+/* Reads the monotonic clock, this is not affected by changes to the system
+** time and is cheaper to read than the wall clock on most systems.
+*/
+static void read_clock(struct timeval *tv)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	tv->tv_sec = ts.tv_sec;
+	tv->tv_usec = ts.tv_nsec / 1000;
+}
+
+#else
+
+static void read_clock(struct timeval *tv)
+{
+	gettimeofday(tv, NULL);
+}
+
+#endif
+
 /* Borrowed from libc.info */
 static int timeval_subtract(struct timeval *result, struct timeval *x, struct timeval *y)
 {
@@ -54,7 +82,7 @@ static int get_time(timer *c)
 	if (!(c->flags & TIMER_RUNNING))
 		return 0;
 
-	gettimeofday(&tv, NULL);
+	read_clock(&tv);
 	timeval_subtract(&tv, &tv, &c->start_time);
 
 	return tv.tv_sec * 100 + tv.tv_usec / 10000;
@@ -73,7 +101,7 @@ void timer_set(timer *c, int val)
 
 void timer_start(timer *c)
 {
-        gettimeofday(&c->start_time, NULL);
+	read_clock(&c->start_time);
 	c->flags |= TIMER_RUNNING;
 }
 
@@ -88,3 +116,11 @@ void timer_init(timer *c, int down)
 	c->flags = (down? TIMER_DOWN : 0);
 }
 
+long long timer_now(void)
+{
+	struct timeval tv;
+
+	read_clock(&tv);
+
+	return tv.tv_sec * 1000LL + tv.tv_usec / 1000;
+}
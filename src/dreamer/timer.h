@@ -39,4 +39,7 @@ void timer_start(timer *c);
 void timer_stop(timer *c);
 void timer_init(timer *c, int down);
 
+long long timer_now(void);
+/* Returns a timestamp in milliseconds, for measuring short intervals. */
+
 #endif /* TIMER_H */
@@ -20,25 +20,17 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <pthread.h>
 
 #include "board.h"
 #include "hashing.h"
 #include "transposition.h"
 #include "search.h"
 #include "move.h"
+#include "stats.h"
 
 /* #define DEBUG */
 
-#define ENTRIES (1 << power_of_two)
-int power_of_two;
-
-#ifdef DEBUG
-int queries;
-int hits;
-#endif
-
-int collisions;
-
 typedef struct entry
 {
     int eval_type;
@@ -50,16 +42,61 @@ typedef struct entry
 }
 entry_t;
 
-entry_t *table;
+struct transposition
+{
+    entry_t *entries;
+    int power_of_two;
+    int megabytes; /* Requested size of the table. */
+    int refs;
+};
+
+/* Protects the reference counts of tables shared between instances. */
+static pthread_mutex_t refs_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* The table of the current thread. The entries and size are copied out of
+** it, as they are needed for every probe.
+*/
+static THREAD_LOCAL transposition_t *bound;
+static THREAD_LOCAL entry_t *table;
+static THREAD_LOCAL int power_of_two;
+
+#define ENTRIES (1 << power_of_two)
+
+/* A table can be shared by searches on several threads without locking.
+** The key is stored xored with the rest of the entry, so an entry that two
+** threads wrote at the same time doesn't match the key of either position.
+*/
+static inline unsigned long long entry_check(entry_t *entry)
+{
+    return ((unsigned long long)(unsigned)entry->eval << 32
+            | (unsigned)entry->move)
+           ^ ((unsigned long long)entry->depth << 40)
+           ^ ((unsigned long long)entry->eval_type << 56)
+           ^ ((unsigned long long)(unsigned)entry->time_stamp << 8);
+}
+
+/* Reads the entry of a board into entry. Returns 1 if it's there. */
+static inline int entry_read(board_t *board, entry_t *entry)
+{
+    *entry = table[board->hash_key & (ENTRIES - 1)];
+
+    return entry->eval_type != EVAL_NONE
+           && (entry->hash_key ^ entry_check(entry)) == board->hash_key;
+}
+
+static inline void entry_write(board_t *board, entry_t *entry)
+{
+    entry->hash_key = board->hash_key ^ entry_check(entry);
+    table[board->hash_key & (ENTRIES - 1)] = *entry;
+}
 
 void
 store_board(board_t *board, int eval, int eval_type, int depth, int ply,
             int time_stamp, move_t move)
 {
-    int index = board->hash_key & (ENTRIES - 1);
+    entry_t entry;
 
-    if ((table[index].eval_type != EVAL_NONE) && (table[index].hash_key == board->hash_key)
-            && (table[index].depth > depth))
+    if (entry_read(board, &entry) && (entry.depth > depth))
         /* Do not overwrite entries for this board at greater depth. */
         return;
 
@@ -69,47 +106,44 @@ store_board(board_t *board, int eval, int eval_type, int depth, int ply,
     else if (eval > ALPHABETA_MAX - 1000)
         eval += ply;
 
-    table[index].hash_key = board->hash_key;
-    table[index].eval = eval;
-    table[index].eval_type = eval_type;
-    table[index].depth = depth;
-    table[index].time_stamp = time_stamp;
-    table[index].move = move;
+    entry.eval = eval;
+    entry.eval_type = eval_type;
+    entry.depth = depth;
+    entry.time_stamp = time_stamp;
+    entry.move = move;
+    entry_write(board, &entry);
 }
 
 void
 set_best_move(board_t *board, move_t move)
 {
-    int index = board->hash_key & (ENTRIES - 1);
+    entry_t entry;
 
-    if ((table[index].eval_type == EVAL_NONE) || (table[index].hash_key != board->hash_key))
+    if (!entry_read(board, &entry))
         store_board(board, 0, EVAL_PV, 0, 0, 0, move);
     else
-        table[index].move = move;
+    {
+        entry.move = move;
+        entry_write(board, &entry);
+    }
 }
 
 int
 lookup_board(board_t *board, int depth, int ply, int *eval)
 {
-    int index = board->hash_key & (ENTRIES - 1);
+    entry_t entry;
 
-#ifdef DEBUG
-    if (queries == 100000) {e_comm_send("TT hit rate:: %.2f%%\n", hits / (float) queries * 100); queries = 0; hits = 0;}
-    queries++;
-#endif
-    if (table[index].eval_type == EVAL_NONE)
-        return EVAL_NONE;
+    STATS_INC(tt_probes);
 
-    if (table[index].hash_key != board->hash_key)
+    if (!entry_read(board, &entry))
         return EVAL_NONE;
-#ifdef DEBUG
-    hits++;
-#endif
 
-    if (table[index].depth < depth || table[index].eval_type == EVAL_PV)
+    STATS_INC(tt_hits);
+
+    if (entry.depth < depth || entry.eval_type == EVAL_PV)
         return EVAL_NONE;
 
-    *eval = table[index].eval;
+    *eval = entry.eval;
 
     /* Make mate-in-n values relative to current game position */
     if (*eval < ALPHABETA_MIN + 1000)
@@ -117,18 +151,18 @@ lookup_board(board_t *board, int depth, int ply, int *eval)
     else if (*eval > ALPHABETA_MAX - 1000)
         *eval -= ply;
 
-    return table[index].eval_type;
+    return entry.eval_type;
 }
 
 move_t
 lookup_best_move(board_t *board)
 {
-    int index = board->hash_key & (ENTRIES - 1);
+    entry_t entry;
 
-    if ((table[index].eval_type == EVAL_NONE) || (table[index].hash_key != board->hash_key))
+    if (!entry_read(board, &entry))
         return NO_MOVE;
 
-    return table[index].move;
+    return entry.move;
 }
 
 void
@@ -141,12 +175,38 @@ clear_table(void)
     }
 }
 
-void transposition_init(int megabytes)
+int
+transposition_hashfull(void)
+{
+    int i;
+    int used = 0;
+
+    /* Estimate the table usage in permill from the first 1000 entries. */
+    for (i = 0; i < 1000 && i < ENTRIES; i++)
+        if (table[i].eval_type != EVAL_NONE)
+            used++;
+
+    return used * 1000 / i;
+}
+
+int transposition_size(void)
+{
+    return bound->megabytes;
+}
+
+transposition_t *transposition_new(int megabytes)
 {
+    transposition_t *tt;
     int i = 0;
-    int x = 2;
+    size_t x = 2;
+    size_t max_entries;
 
-    int max_entries = megabytes * 1024768 / sizeof(entry_t);
+    if (megabytes < 1)
+        megabytes = 1;
+    else if (megabytes > TRANSPOSITION_MAX_SIZE)
+        megabytes = TRANSPOSITION_MAX_SIZE;
+
+    max_entries = (size_t)megabytes * 1024768 / sizeof(entry_t);
 
     while (x <= max_entries) {
         x *= 2;
@@ -154,19 +214,75 @@ void transposition_init(int megabytes)
     }
 
     x /= 2;
-    power_of_two = i;
 
-    printf("Hash table size: %i MB\n", x * (int)sizeof(entry_t) / 1024768);
-    table = malloc(x * sizeof(entry_t));
+    tt = malloc(sizeof(transposition_t));
+    if (!tt)
+        return NULL;
+
+    /* Empty entries are all zero. */
+    tt->entries = calloc(x, sizeof(entry_t));
+    if (!tt->entries)
+    {
+        free(tt);
+        return NULL;
+    }
+
+    tt->power_of_two = i;
+    tt->megabytes = megabytes;
+    tt->refs = 1;
+    return tt;
+}
+
+transposition_t *transposition_ref(transposition_t *tt)
+{
+    pthread_mutex_lock(&refs_mutex);
+    tt->refs++;
+    pthread_mutex_unlock(&refs_mutex);
+    return tt;
+}
+
+void transposition_free(transposition_t *tt)
+{
+    int refs;
+
+    if (tt == bound)
+        transposition_bind(NULL);
+
+    pthread_mutex_lock(&refs_mutex);
+    refs = --tt->refs;
+    pthread_mutex_unlock(&refs_mutex);
+
+    if (refs > 0)
+        return;
+
+    free(tt->entries);
+    free(tt);
+}
 
-    if (!table)
+void transposition_bind(transposition_t *tt)
+{
+    bound = tt;
+    table = (tt ? tt->entries : NULL);
+    power_of_two = (tt ? tt->power_of_two : 0);
+}
+
+void transposition_init(int megabytes)
+{
+    transposition_t *tt = transposition_new(megabytes);
+
+    if (!tt)
     {
          fprintf(stderr, "Failed to allocate memory for hash table\n");
          exit(1);
     }
+
+    fprintf(stderr, "Hash table size: %i MB\n",
+            (int)((sizeof(entry_t) << tt->power_of_two) / 1024768));
+    transposition_bind(tt);
 }
 
 void transposition_exit(void)
 {
-    free(table);
+    if (bound)
+        transposition_free(bound);
 }
@@ -29,6 +29,12 @@
 #define EVAL_UPPERBOUND 3
 #define EVAL_PV 4
 
+/* Default size of the transposition table in megabytes. */
+#define TRANSPOSITION_DEFAULT_SIZE 128
+
+/* Largest table size in megabytes. */
+#define TRANSPOSITION_MAX_SIZE 1024
+
 void
 store_board(board_t *board, int eval, int eval_type, int depth, int ply,
             int time_stamp, move_t best_move);
@@ -42,8 +48,41 @@ set_best_move(board_t *board, move_t move);
 void
 clear_table(void);
 
+/* A transposition table. Every thread searches with the table that was
+** last bound to it, several threads can share the same table.
+*/
+typedef struct transposition transposition_t;
+
+transposition_t *transposition_new(int megabytes);
+/* Creates an empty transposition table.
+** Parameters: (int) megabytes: Size of the table, clamped to between 1 and
+**                 TRANSPOSITION_MAX_SIZE.
+** Returns   : (transposition_t *) The new table, or NULL if there's not
+**                 enough memory.
+*/
+
+transposition_t *transposition_ref(transposition_t *tt);
+/* Adds a reference to a table, for sharing it.
+** Parameters: (transposition_t *) tt: The table.
+** Returns   : (transposition_t *) tt.
+*/
+
+void transposition_free(transposition_t *tt);
+/* Drops a reference to a table, and frees it when it was the last one.
+** Parameters: (transposition_t *) tt: The table.
+** Returns   : (void)
+*/
+
+void transposition_bind(transposition_t *tt);
+/* Makes a table the one that the current thread searches with.
+** Parameters: (transposition_t *) tt: The table, or NULL for none.
+** Returns   : (void)
+*/
+
 void transposition_init(int megabytes);
 void transposition_exit(void);
+int transposition_size(void);
 move_t lookup_best_move(board_t *board);
+int transposition_hashfull(void);
 
 #endif /* TRANSPOSITION_H */
@@ -0,0 +1,362 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "dreamer.h"
+#include "eval.h"
+#include "packed.h"
+#include "timer.h"
+#include "tune.h"
+
+/* Positions that a thread handles at a time. */
+#define TUNE_BLOCK 1024
+
+/* Sums are kept in this many lanes, so that compilers can vectorise them
+** without reordering floating point additions themselves.
+*/
+#define TUNE_LANES 8
+
+/* Adam step size in centipawns and decay rates. */
+#define TUNE_RATE 1.0
+#define TUNE_BETA1 0.9
+#define TUNE_BETA2 0.999
+
+/* The positions, as struct of arrays: the evaluation of position n is
+** base[n] plus the sum of coef[i][n] * eval_param[i].
+*/
+static long long count;
+static float *base;
+static float *result;
+static signed char *coef[EVAL_PARAMS];
+
+static const packed_t *pos;
+
+typedef struct
+{
+    pthread_t thread;
+    long long start, end;
+    long long kept;   /* Positions kept, moved to start. */
+    const float *param;
+    float k;
+    int gradient;     /* Compute the gradient as well as the error. */
+    double error;
+    double grad[EVAL_PARAMS];
+}
+job_t;
+
+static void *tune_trace(void *arg)
+{
+    job_t *job = arg;
+    long long n, kept = job->start;
+
+    for (n = job->start; n < job->end; n++)
+    {
+        board_t board;
+        int c[EVAL_PARAMS];
+        int material, res, i;
+
+        if (packed_decode(&pos[n], &board, NULL, &res))
+            continue;
+
+        material = eval_trace(&board, c);
+
+        for (i = 0; i < EVAL_PARAMS; i++)
+            if (c[i] < -128 || c[i] > 127)
+                break;
+
+        if (i < EVAL_PARAMS)
+            continue;
+
+        for (i = 0; i < EVAL_PARAMS; i++)
+            coef[i][kept] = c[i];
+
+        base[kept] = material;
+        result[kept] = res / 2.0f;
+        kept++;
+    }
+
+    job->kept = kept - job->start;
+    return NULL;
+}
+
+static void *tune_pass(void *arg)
+{
+    job_t *job = arg;
+    float q[TUNE_BLOCK];
+    long long start;
+    int i;
+
+    job->error = 0;
+
+    for (i = 0; i < EVAL_PARAMS; i++)
+        job->grad[i] = 0;
+
+    for (start = job->start; start < job->end; start += TUNE_BLOCK)
+    {
+        int len = (job->end - start < TUNE_BLOCK ? job->end - start
+                                                 : TUNE_BLOCK);
+        float error[TUNE_LANES] = {0};
+        int n, j;
+
+        memcpy(q, base + start, len * sizeof(float));
+
+        for (i = 0; i < EVAL_PARAMS; i++)
+        {
+            const signed char *c = coef[i] + start;
+            float w = job->param[i];
+
+            for (n = 0; n < len; n++)
+                q[n] += c[n] * w;
+        }
+
+        /* Error, and its derivative by the evaluation. */
+        for (n = 0; n < len; n++)
+        {
+            float s = 1 / (1 + expf(-job->k * q[n]));
+            float e = s - result[start + n];
+
+            error[n % TUNE_LANES] += e * e;
+            q[n] = e * s * (1 - s);
+        }
+
+        for (j = 0; j < TUNE_LANES; j++)
+            job->error += error[j];
+
+        if (!job->gradient)
+            continue;
+
+        for (i = 0; i < EVAL_PARAMS; i++)
+        {
+            const signed char *c = coef[i] + start;
+            float sum[TUNE_LANES] = {0};
+
+            for (n = 0; n + TUNE_LANES <= len; n += TUNE_LANES)
+                for (j = 0; j < TUNE_LANES; j++)
+                    sum[j] += c[n + j] * q[n + j];
+
+            for (; n < len; n++)
+                sum[0] += c[n] * q[n];
+
+            for (j = 0; j < TUNE_LANES; j++)
+                job->grad[i] += sum[j];
+        }
+    }
+
+    return NULL;
+}
+
+/* Runs fn on all positions, split over the threads. */
+static void tune_run(job_t *job, int threads, long long total,
+                     void *(*fn)(void *))
+{
+    int t;
+
+    for (t = 0; t < threads; t++)
+    {
+        job[t].start = total * t / threads;
+        job[t].end = total * (t + 1) / threads;
+
+        if (threads > 1)
+            pthread_create(&job[t].thread, NULL, fn, &job[t]);
+        else
+            fn(&job[t]);
+    }
+
+    if (threads > 1)
+        for (t = 0; t < threads; t++)
+            pthread_join(job[t].thread, NULL);
+}
+
+/* Returns the mean squared error, and stores its gradient in grad if not
+** NULL.
+*/
+static double tune_error(job_t *job, int threads, const float *param, float k,
+                         double *grad)
+{
+    double error = 0;
+    int t, i;
+
+    for (t = 0; t < threads; t++)
+    {
+        job[t].param = param;
+        job[t].k = k;
+        job[t].gradient = (grad != NULL);
+    }
+
+    tune_run(job, threads, count, tune_pass);
+
+    if (grad)
+        for (i = 0; i < EVAL_PARAMS; i++)
+            grad[i] = 0;
+
+    for (t = 0; t < threads; t++)
+    {
+        error += job[t].error;
+
+        if (grad)
+            for (i = 0; i < EVAL_PARAMS; i++)
+                grad[i] += job[t].grad[i] * 2 * k / count;
+    }
+
+    return error / count;
+}
+
+/* Finds the scale of the evaluation that fits the results best. */
+static float tune_scale(job_t *job, int threads, const float *param)
+{
+    const double r = 0.618034;
+    double a = 0.0001, b = 0.05;
+    double c = b - (b - a) * r, d = a + (b - a) * r;
+    double fc = tune_error(job, threads, param, c, NULL);
+    double fd = tune_error(job, threads, param, d, NULL);
+    int i;
+
+    /* Golden section search, one pass over the positions per step. */
+    for (i = 0; i < 30; i++)
+    {
+        if (fc < fd)
+        {
+            b = d;
+            d = c;
+            fd = fc;
+            c = b - (b - a) * r;
+            fc = tune_error(job, threads, param, c, NULL);
+        }
+        else
+        {
+            a = c;
+            c = d;
+            fc = fd;
+            d = a + (b - a) * r;
+            fd = tune_error(job, threads, param, d, NULL);
+        }
+    }
+
+    return (a + b) / 2;
+}
+
+int tune(char *filename, int epochs, int threads)
+{
+    packed_file_t f;
+    job_t *job;
+    float param[EVAL_PARAMS];
+    double m[EVAL_PARAMS], v[EVAL_PARAMS], grad[EVAL_PARAMS];
+    double error;
+    long long kept, start;
+    float k;
+    int i, t, epoch;
+
+    if (packed_map(&f, filename))
+    {
+        fprintf(stderr, "Error reading %s\n", filename);
+        return 1;
+    }
+
+    if (threads < 1)
+        threads = 1;
+
+    job = calloc(threads, sizeof(job_t));
+    base = malloc((f.count + 1) * sizeof(float));
+    result = malloc((f.count + 1) * sizeof(float));
+
+    for (i = 0; i < EVAL_PARAMS; i++)
+        coef[i] = malloc(f.count + 1);
+
+    start = timer_now();
+    pos = f.pos;
+    tune_run(job, threads, f.count, tune_trace);
+
+    /* Close the gaps left by positions that were dropped. */
+    for (t = 0, kept = 0; t < threads; t++)
+    {
+        memmove(base + kept, base + job[t].start, job[t].kept * sizeof(float));
+        memmove(result + kept, result + job[t].start,
+                job[t].kept * sizeof(float));
+
+        for (i = 0; i < EVAL_PARAMS; i++)
+            memmove(coef[i] + kept, coef[i] + job[t].start, job[t].kept);
+
+        kept += job[t].kept;
+    }
+
+    count = kept;
+    fprintf(stderr, "Traced %lli of %lli positions in %lli ms\n", count,
+            f.count, timer_now() - start);
+    packed_unmap(&f);
+
+    if (count == 0)
+        return 1;
+
+    for (i = 0; i < EVAL_PARAMS; i++)
+    {
+        param[i] = eval_param[i];
+        m[i] = v[i] = 0;
+    }
+
+    k = tune_scale(job, threads, param);
+    error = tune_error(job, threads, param, k, NULL);
+    fprintf(stderr, "Scale %g, error %.6f\n", k, error);
+
+    start = timer_now();
+
+    for (epoch = 1; epoch <= epochs; epoch++)
+    {
+        error = tune_error(job, threads, param, k, grad);
+
+        /* Adam. */
+        for (i = 0; i < EVAL_PARAMS; i++)
+        {
+            double mh, vh;
+
+            m[i] = TUNE_BETA1 * m[i] + (1 - TUNE_BETA1) * grad[i];
+            v[i] = TUNE_BETA2 * v[i] + (1 - TUNE_BETA2) * grad[i] * grad[i];
+            mh = m[i] / (1 - pow(TUNE_BETA1, epoch));
+            vh = v[i] / (1 - pow(TUNE_BETA2, epoch));
+            param[i] -= TUNE_RATE * mh / (sqrt(vh) + 1e-12);
+        }
+
+        if (epoch % 10 == 0 || epoch == epochs)
+            fprintf(stderr, "Epoch %i: error %.6f, %lli ms per epoch\n",
+                    epoch, error, (timer_now() - start) / epoch);
+    }
+
+    for (i = 0; i < EVAL_PARAMS; i++)
+    {
+        eval_param[i] = (int)floor(param[i] + 0.5);
+        param[i] = eval_param[i];
+    }
+
+    fprintf(stderr, "Error %.6f\n", tune_error(job, threads, param, k, NULL));
+    eval_params_write(stdout);
+
+    for (i = 0; i < EVAL_PARAMS; i++)
+        free(coef[i]);
+
+    free(base);
+    free(result);
+    free(job);
+
+    return 0;
+}
@@ -0,0 +1,38 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TUNE_H
+#define TUNE_H
+
+#define TUNE_DEFAULT_EPOCHS 500
+
+int tune(char *filename, int epochs, int threads);
+/* Fits the evaluation weights to the results of the games of a file of
+** packed positions (see packed.h) by minimising the squared error of the
+** predicted results, and prints the new weights in the format of
+** eval_params_read(). The positions are traced once, after which every
+** epoch is a pass over a compact table of coefficients.
+** Parameters: (char *) filename: The positions.
+**             (int) epochs: Number of gradient descent steps.
+**             (int) threads: Number of threads.
+** Returns   : (int) 0 on success, 1 if the file can't be read.
+*/
+
+#endif /* TUNE_H */
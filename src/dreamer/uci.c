@@ -0,0 +1,455 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "dreamer.h"
+#include "commands.h"
+#include "e_comm.h"
+#include "move.h"
+#include "repetition.h"
+#include "transposition.h"
+#include "config.h"
+#include "git_rev.h"
+#include "search.h"
+#include "timer.h"
+#include "uci.h"
+#include "bench.h"
+#include "perft.h"
+#include "stats.h"
+#include "syzygy.h"
+
+/* Number of moves assumed to be left when the ui doesn't send movestogo. */
+#define UCI_MOVES_TO_GO 30
+
+/* Set when the ui has sent "stop" for the current search. */
+static int stopped;
+
+/* Time budget of the current search in centiseconds, for "ponderhit". */
+static int budget;
+
+static void uci_id(void)
+{
+    e_comm_send("id name Dreamer v" PACKAGE_VERSION " (" GIT_REV ")\n");
+    e_comm_send("id author The DreamChess team\n");
+    e_comm_send("option name Hash type spin default %i min 1 max %i\n",
+                TRANSPOSITION_DEFAULT_SIZE, TRANSPOSITION_MAX_SIZE);
+    e_comm_send("option name Threads type spin default 1 min 1 max 1\n");
+    e_comm_send("option name Ponder type check default false\n");
+    e_comm_send("option name MultiPV type spin default 1 min 1 max %i\n",
+                MULTIPV_MAX);
+#ifdef HAVE_SYZYGY
+    e_comm_send("option name SyzygyPath type string default <empty>\n");
+    e_comm_send("option name SyzygyProbeLimit type spin default %i min 0 "
+                "max 7\n", SYZYGY_DEFAULT_LIMIT);
+#endif /* HAVE_SYZYGY */
+    e_comm_send("uciok\n");
+}
+
+static void uci_setoption(state_t *state, char *args)
+{
+    char *name = strstr(args, "name ");
+    char *value = strstr(args, " value ");
+
+    if (!name)
+        return;
+
+    name += 5;
+
+    if (value)
+    {
+        *value = '\0';
+        value += 7;
+    }
+
+    if (!strcasecmp(name, "Hash"))
+    {
+        int megabytes = value ? atoi(value) : 0;
+
+        if (megabytes < 1)
+        {
+            e_comm_send("info string Invalid hash size\n");
+            return;
+        }
+
+        if (megabytes > TRANSPOSITION_MAX_SIZE)
+            megabytes = TRANSPOSITION_MAX_SIZE;
+
+        transposition_exit();
+        transposition_init(megabytes);
+        clear_table();
+    }
+    else if (!strcasecmp(name, "Ponder"))
+        set_option(OPTION_PONDER, value && !strcasecmp(value, "true"));
+    else if (!strcasecmp(name, "MultiPV"))
+    {
+        int lines = value ? atoi(value) : 0;
+
+        if (lines < 1 || lines > MULTIPV_MAX)
+        {
+            e_comm_send("info string Invalid number of lines\n");
+            return;
+        }
+
+        state->multipv = lines;
+    }
+    else if (!strcasecmp(name, "SyzygyPath"))
+    {
+        int pieces;
+
+        if (value && !strcmp(value, "<empty>"))
+            value = NULL;
+
+        pieces = syzygy_init(value);
+
+        if (pieces > 0)
+            e_comm_send("info string Found tablebases with up to %i pieces\n",
+                        pieces);
+        else if (value)
+            e_comm_send("info string No tablebases found in %s\n", value);
+    }
+    else if (!strcasecmp(name, "SyzygyProbeLimit"))
+    {
+        int pieces = value ? atoi(value) : -1;
+
+        if (pieces < 0 || pieces > 7)
+        {
+            e_comm_send("info string Invalid probe limit\n");
+            return;
+        }
+
+        syzygy_set_limit(pieces);
+    }
+    else if (!strcasecmp(name, "Threads"))
+    {
+        /* The search is single-threaded. */
+    }
+    else
+        e_comm_send("info string Unknown option %s\n", name);
+}
+
+static void uci_position(state_t *state, char *args)
+{
+    board_t board;
+    char *moves = strstr(args, " moves");
+    char *move_s;
+
+    if (moves)
+    {
+        *moves = '\0';
+        moves += 6;
+    }
+
+    if (!strcmp(args, "startpos"))
+        setup_board(&board);
+    else if (!strncmp(args, "fen ", 4))
+    {
+        if (setup_board_fen(&board, args + 4))
+        {
+            e_comm_send("info string Invalid FEN %s\n", args + 4);
+            return;
+        }
+    }
+    else
+    {
+        e_comm_send("info string Invalid position %s\n", args);
+        return;
+    }
+
+    state->board = board;
+    if (state->undo_data != NULL)
+        free(state->undo_data);
+    state->undo_data = NULL;
+    state->moves = 0;
+    state->done = 0;
+    repetition_init(&state->board);
+
+    if (!moves)
+        return;
+
+    move_s = strtok(moves, " ");
+
+    while (move_s)
+    {
+        move_t move;
+
+        if (parse_move(&state->board, 0, move_s, &move) || move == NO_MOVE)
+        {
+            e_comm_send("info string Illegal move %s\n", move_s);
+            return;
+        }
+
+        do_move(state, move);
+        move_s = strtok(NULL, " ");
+    }
+}
+
+int uci_move_time(int time, int inc, int moves_to_go)
+{
+    /* Keep a reserve of a tenth of the clock, but at most ten seconds. */
+    int reserve = time / 10;
+
+    if (reserve > 1000)
+        reserve = 1000;
+
+    time -= reserve;
+
+    if (moves_to_go <= 0)
+        moves_to_go = UCI_MOVES_TO_GO;
+
+    return time / moves_to_go + inc;
+}
+
+static void uci_set_move_time(state_t *state, int time, int inc,
+                              int moves_to_go)
+{
+    timer_init(&state->move_time, 1);
+    timer_set(&state->move_time, uci_move_time(time, inc, moves_to_go));
+}
+
+static void uci_go(state_t *state, char *args)
+{
+    int time[2] = {-1, -1};
+    int inc[2] = {0, 0};
+    int moves_to_go = 0;
+    int move_time = -1;
+    int infinite = 0;
+    int me = state->board.current_player;
+    char *token;
+    move_t move;
+
+    state->depth = MAX_DEPTH;
+    state->nodes = 0;
+    state->flags = 0;
+
+    token = strtok(args, " ");
+
+    while (token)
+    {
+        char *arg;
+
+        if (!strcmp(token, "infinite"))
+        {
+            state->flags |= FLAG_INFINITE;
+            infinite = 1;
+            token = strtok(NULL, " ");
+            continue;
+        }
+
+        if (!strcmp(token, "ponder"))
+        {
+            state->flags |= FLAG_PONDER;
+            token = strtok(NULL, " ");
+            continue;
+        }
+
+        arg = strtok(NULL, " ");
+
+        if (!arg)
+            break;
+
+        /* The ui sends times in milliseconds, our clocks use centiseconds. */
+        if (!strcmp(token, "wtime"))
+            time[SIDE_WHITE] = atoi(arg) / 10;
+        else if (!strcmp(token, "btime"))
+            time[SIDE_BLACK] = atoi(arg) / 10;
+        else if (!strcmp(token, "winc"))
+            inc[SIDE_WHITE] = atoi(arg) / 10;
+        else if (!strcmp(token, "binc"))
+            inc[SIDE_BLACK] = atoi(arg) / 10;
+        else if (!strcmp(token, "movestogo"))
+            moves_to_go = atoi(arg);
+        else if (!strcmp(token, "movetime"))
+            move_time = atoi(arg) / 10;
+        else if (!strcmp(token, "depth"))
+        {
+            state->depth = atoi(arg);
+            if (state->depth < 1 || state->depth > MAX_DEPTH)
+                state->depth = MAX_DEPTH;
+        }
+        else if (!strcmp(token, "nodes"))
+            state->nodes = atoi(arg);
+
+        token = strtok(NULL, " ");
+    }
+
+    if (move_time >= 0)
+    {
+        timer_init(&state->move_time, 1);
+        timer_set(&state->move_time, move_time);
+    }
+    else if (time[me] >= 0)
+        uci_set_move_time(state, time[me], inc[me], moves_to_go);
+    else
+        /* Without a clock we search until depth, node limit or "stop". */
+        state->flags |= FLAG_INFINITE;
+
+    budget = timer_get(&state->move_time);
+    stopped = 0;
+    move = find_best_move(state);
+
+    if (state->mode == MODE_QUIT)
+        return;
+
+    /* The protocol doesn't allow a bestmove before "stop" or "ponderhit"
+    ** when pondering or searching infinitely, so wait for it.
+    */
+    while (!stopped && (infinite || (state->flags & FLAG_PONDER)))
+    {
+        char *s = e_comm_wait();
+        int abort = uci_check_abort(state, s);
+
+        free(s);
+
+        if (abort)
+            break;
+    }
+
+    if (state->mode == MODE_QUIT)
+        return;
+
+    state->flags = 0;
+
+    if (MOVE_IS_REGULAR(move))
+    {
+        char *str = coord_move_str(move);
+
+        if (state->hint != NO_MOVE)
+        {
+            char *hint = coord_move_str(state->hint);
+            e_comm_send("bestmove %s ponder %s\n", str, hint);
+            free(hint);
+        }
+        else
+            e_comm_send("bestmove %s\n", str);
+
+        free(str);
+    }
+    else
+        e_comm_send("bestmove 0000\n");
+}
+
+void uci_handle(state_t *state, char *command)
+{
+    if (!strcmp(command, "uci"))
+    {
+        state->mode = MODE_FORCE;
+        set_option(OPTION_POST, 1);
+        uci_id();
+        return;
+    }
+
+    if (!strcmp(command, "isready"))
+    {
+        e_comm_send("readyok\n");
+        return;
+    }
+
+    if (!strcmp(command, "ucinewgame"))
+    {
+        command_new(state);
+        state->mode = MODE_FORCE;
+        return;
+    }
+
+    if (!strncmp(command, "setoption ", 10))
+    {
+        uci_setoption(state, command + 10);
+        return;
+    }
+
+    if (!strncmp(command, "position ", 9))
+    {
+        uci_position(state, command + 9);
+        return;
+    }
+
+    if (!strcmp(command, "go") || !strncmp(command, "go ", 3))
+    {
+        uci_go(state, command + 2);
+        return;
+    }
+
+    if (!strcmp(command, "bench") || !strncmp(command, "bench ", 6))
+    {
+        bench_command(state, command + 5);
+        return;
+    }
+
+    if (!strcmp(command, "stats"))
+    {
+        stats_print();
+        return;
+    }
+
+    if (!strncmp(command, "perft ", 6))
+    {
+        perft_command(&state->board, command + 5, 0);
+        return;
+    }
+
+    if (!strncmp(command, "divide ", 7))
+    {
+        perft_command(&state->board, command + 6, 1);
+        return;
+    }
+
+    if (!strcmp(command, "quit"))
+    {
+        state->mode = MODE_QUIT;
+        return;
+    }
+
+    /* "stop" and "ponderhit" outside of a search, and "debug" and
+    ** "register" are ignored.
+    */
+}
+
+int uci_check_abort(state_t *state, char *command)
+{
+    if (!strcmp(command, "stop"))
+    {
+        stopped = 1;
+        return 1;
+    }
+
+    if (!strcmp(command, "ponderhit"))
+    {
+        search_ponder_hit(state, budget);
+        return 0;
+    }
+
+    if (!strcmp(command, "isready"))
+    {
+        e_comm_send("readyok\n");
+        return 0;
+    }
+
+    if (!strcmp(command, "quit"))
+    {
+        state->mode = MODE_QUIT;
+        state->flags |= FLAG_IGNORE_MOVE;
+        return 1;
+    }
+
+    return 0;
+}
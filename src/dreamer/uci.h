@@ -0,0 +1,49 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef UCI_H
+#define UCI_H
+
+#include "dreamer.h"
+
+void uci_handle(state_t *state, char *command);
+/* Handles a command from a UCI ui.
+** Parameters: (state_t *) state: The engine state.
+**             (char *) command: The command to handle.
+** Returns   : (void)
+*/
+
+int uci_check_abort(state_t *state, char *command);
+/* Handles a command from a UCI ui that arrives during a search.
+** Parameters: (state_t *) state: The engine state.
+**             (char *) command: The command to handle.
+** Returns   : (int) 1 if the search should be aborted, 0 otherwise.
+*/
+
+int uci_move_time(int time, int inc, int moves_to_go);
+/* Divides the clock over the moves still to play.
+** Parameters: (int) time: Time left on the clock in centiseconds.
+**             (int) inc: Increment per move in centiseconds.
+**             (int) moves_to_go: Moves until the next time control, or 0
+**                 if the rest of the game must be played in time.
+** Returns   : (int) Time for the next move in centiseconds.
+*/
+
+#endif /* UCI_H */
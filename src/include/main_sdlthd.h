@@ -21,16 +21,12 @@
 #ifndef _MAIN_SDLTHD_H
 #define _MAIN_SDLTHD_H
 
-#include "SDL_thread.h"
-
 #include "pipe_mem.h"
 
-/* Message list from engine to ui. */
-extern char *to_ui;
-extern SDL_mutex *to_ui_mutex;
+/* Message pipe from engine to ui. */
+extern pipe_mem_t *to_ui;
 
-/* Message list from ui to engine. */
-extern char *to_engine;
-extern SDL_mutex *to_engine_mutex;
+/* Message pipe from ui to engine. */
+extern pipe_mem_t *to_engine;
 
 #endif /* _MAIN_SDLTHD_H */
@@ -38,7 +38,7 @@ void msglist_init(msglist_t *list);
 void msglist_add(msglist_t *list, char *msg);
 char *msglist_remove(msglist_t *list);
 void msglist_free(msglist_t *list);
-int mgslist_poll(msglist_t *list);
+int msglist_poll(msglist_t *list);
 
 #if 0
 void pipe_init(int in, int out);
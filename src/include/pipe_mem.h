@@ -21,44 +21,59 @@
 #ifndef _PIPE_MEM_H
 #define _PIPE_MEM_H
 
-void pipe_mem_init(char **pipe);
-void pipe_mem_send(char **pipe, const char *msg);
-char *pipe_mem_poll(char **pipe);
-void pipe_mem_exit(char **pipe);
+/* In-process message pipe between two threads. It is a bounded lock-free
+** queue of pre-allocated message slots for a single sender and a single
+** receiver. The receiver can block until a message arrives; a mutex and
+** condition variable are only touched while one of the threads is asleep.
+*/
+typedef struct pipe_mem pipe_mem_t;
+
+pipe_mem_t *pipe_mem_new(int slots);
+/* Creates a pipe.
+** Parameters: (int) slots: Number of message slots, rounded up to a power
+**                 of two. The sender blocks when they are all in use.
+** Returns   : (pipe_mem_t *) The new pipe.
+*/
 
-#if 0
-void pipe_init(int in, int out);
-/* Initializes the I/O library with file descriptors for input and output.
-** Parameters: (int) in: File descriptor to use for input.
-**             (int) out: File descriptor to use for output.
+void pipe_mem_free(pipe_mem_t *pipe);
+/* Destroys a pipe.
+** Parameters: (pipe_mem_t *) pipe: The pipe to destroy.
 ** Returns   : (void)
 */
 
-void pipe_exit(void);
-/* Exits the I/O library cleanly.
-** Parameters: (void)
+void pipe_mem_send(pipe_mem_t *pipe, const char *m);
+/* Sends text through a pipe, one message per line. May only be called from
+** the sending thread.
+** Parameters: (pipe_mem_t *) pipe: The pipe.
+**             (char *) m: Text to be sent.
 ** Returns   : (void)
 */
 
-void pipe_send(char *m);
-/* Sends a message through the I/O library.
-** Parameters: (char *) m: Message to be sent.
+void pipe_mem_write(pipe_mem_t *pipe, const char *m, int len);
+/* Sends a block of text through a pipe, one message per line. May only be
+** called from the sending thread.
+** Parameters: (pipe_mem_t *) pipe: The pipe.
+**             (char *) m: Text to be sent.
+**             (int) len: Length of the text in bytes.
 ** Returns   : (void)
 */
 
-int pipe_poll(void);
-/* Polls the I/O library for input.
-** Parameters: (void)
-** Returns   : 1, if a message is ready to be received with pipe_receive().
-**             0, otherwise.
+char *pipe_mem_poll(pipe_mem_t *pipe);
+/* Polls a pipe for a message. May only be called from the receiving
+** thread.
+** Parameters: (pipe_mem_t *) pipe: The pipe.
+** Returns   : (char *), Message that was received (if any), without the
+**                 newline. It stays valid until the next call to
+**                 pipe_mem_poll or pipe_mem_receive.
+**             NULL, otherwise.
 */
 
-char *pipe_receive(void);
-/* Receives a message through the I/O library. May only be called after
-** io_pipe_poll() returns 1.
-** Parameters: (void)
-** Returns   : (char *), Message that was read from the input file descriptor.
+char *pipe_mem_receive(pipe_mem_t *pipe);
+/* Waits for a message. May only be called from the receiving thread.
+** Parameters: (pipe_mem_t *) pipe: The pipe.
+** Returns   : (char *) Message that was received, without the newline. It
+**                 stays valid until the next call to pipe_mem_poll or
+**                 pipe_mem_receive.
 */
 
-#endif
 #endif /* _PIPE_MEM_H */
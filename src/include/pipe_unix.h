@@ -40,12 +40,69 @@ void pipe_unix_send(const char *m);
 ** Returns   : (void)
 */
 
+void pipe_unix_write(const char *m, int len);
+/* Sends a block of data, which may contain several messages, with as few
+** system calls as possible.
+** Parameters: (char *) m: Data to be sent.
+**             (int) len: Length of the data in bytes.
+** Returns   : (void)
+*/
+
 char *pipe_unix_poll(int *error);
 /* Polls the I/O library for input.
-** Parameters: (void)
+** Parameters: (int *) error: Set to 1 if an error occurred, 0 otherwise.
 ** Returns   : (char *), Message that was read from the input file
-**                 descriptor (if any).
+**                 descriptor (if any). It points into the input buffer and
+**                 stays valid until the next call to the I/O library.
 **             NULL, otherwise.
 */
 
+char *pipe_unix_receive(int *error);
+/* Waits for input from the I/O library.
+** Parameters: (int *) error: Set to 1 if an error occurred, 0 otherwise.
+** Returns   : (char *), Message that was read from the input file
+**                 descriptor. It points into the input buffer and stays
+**                 valid until the next call to the I/O library.
+**             NULL, if an error occurred.
+*/
+
+/* Programs that talk to several processes at once use a pipe for each,
+** with the functions below.
+*/
+typedef struct pipe_unix pipe_unix_t;
+
+pipe_unix_t *pipe_unix_open(int in, int out);
+/* Creates a pipe on a pair of file descriptors.
+** Parameters: (int) in: File descriptor to use for input.
+**             (int) out: File descriptor to use for output.
+** Returns   : (pipe_unix_t *) The pipe.
+*/
+
+void pipe_unix_close(pipe_unix_t *pipe);
+/* Frees a pipe. The file descriptors are left open.
+** Parameters: (pipe_unix_t *) pipe: The pipe.
+** Returns   : (void)
+*/
+
+void pipe_unix_send_to(pipe_unix_t *pipe, const char *m);
+/* Like pipe_unix_send, on a given pipe. */
+
+void pipe_unix_write_to(pipe_unix_t *pipe, const char *m, int len);
+/* Like pipe_unix_write, on a given pipe. */
+
+char *pipe_unix_poll_from(pipe_unix_t *pipe, int *error);
+/* Like pipe_unix_poll, on a given pipe. */
+
+char *pipe_unix_wait_from(pipe_unix_t *pipe, int msec, int *error);
+/* Waits for input on a pipe for a limited time.
+** Parameters: (pipe_unix_t *) pipe: The pipe.
+**             (int) msec: Time to wait in milliseconds, or -1 to wait
+**                 until a message arrives.
+**             (int *) error: Set to 1 if an error occurred, 0 otherwise.
+** Returns   : (char *), Message that was read from the input file
+**                 descriptor. It points into the input buffer of the pipe
+**                 and stays valid until the next call for the pipe.
+**             NULL, if an error occurred or the time ran out.
+*/
+
 #endif /* _PIPE_UNIX_H */
@@ -41,12 +41,30 @@ void pipe_win32_send(const char *m);
 ** Returns   : (void)
 */
 
+void pipe_win32_write(const char *m, int len);
+/* Sends a block of data, which may contain several messages, with as few
+** system calls as possible.
+** Parameters: (char *) m: Data to be sent.
+**             (int) len: Length of the data in bytes.
+** Returns   : (void)
+*/
+
 char *pipe_win32_poll(int *error);
 /* Polls the I/O library for input.
-** Parameters: (void)
+** Parameters: (int *) error: Set to 1 if an error occurred, 0 otherwise.
 ** Returns   : (char *), Message that was read from the input handle
-**                 (if any).
+**                 (if any). It points into the input buffer and stays valid
+**                 until the next call to the I/O library.
 **             NULL, otherwise.
 */
 
+char *pipe_win32_receive(int *error);
+/* Waits for input from the I/O library.
+** Parameters: (int *) error: Set to 1 if an error occurred, 0 otherwise.
+** Returns   : (char *), Message that was read from the input handle. It
+**                 points into the input buffer and stays valid until the
+**                 next call to the I/O library.
+**             NULL, if an error occurred.
+*/
+
 #endif /* _PIPE_WIN32_H */
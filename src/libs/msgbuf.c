@@ -23,80 +23,78 @@
 
 #include "msgbuf.h"
 
-/* Pointer to message that's being received.
-** Note: message refers to a series of characters followed by a newline.
-*/
-static char *msg;
+void msgbuf_init(msgbuf_t *buf, int size)
+{
+    buf->data = malloc(size);
+    buf->size = size;
+    buf->start = 0;
+    buf->scan = 0;
+    buf->end = 0;
+}
 
-char *msgbuf_process(char *buf)
+void msgbuf_exit(msgbuf_t *buf)
 {
-    int buf_len = strlen(buf);
+    free(buf->data);
+    buf->data = NULL;
+}
 
-    if (buf_len > 0)
+char *msgbuf_space(msgbuf_t *buf, int *len)
+{
+    if (buf->start == buf->end)
     {
-        /* Characters from buf to end-1 will be added to the message. */
-        char *end = strchr(buf, '\n');
-        int in_size, i;
-
-        if (end)
-            /* Include newline in message. */
-            end++;
-        else
-            /* No newline, add everything to the message. */
-            end = buf + buf_len;
-
-        /* Size of data (in bytes) that will be added to the message. */
-        in_size = end - buf;
+        /* Buffer is empty, start over at the front. */
+        buf->start = 0;
+        buf->scan = 0;
+        buf->end = 0;
+    }
+    else if (buf->start > 0 && buf->size - buf->end < buf->size / 4)
+    {
+        /* Move the partial line to the front. As lines are consumed in
+        ** between, this happens at most once per buffer full of data.
+        */
+        int used = buf->end - buf->start;
 
-        if (msg)
-        {
-            /* We already have part of a message, realloc it and append
-            ** data.
-            */
-            int len = strlen(msg);
-            msg = (char *) realloc(msg, len + in_size + 1);
-            strncpy(msg + len, buf, in_size);
-            msg[len + in_size] = '\0';
-        }
-        else
-        {
-            /* Allocate a new string for the message. */
-            msg = (char *) malloc(in_size + 1);
-            strncpy(msg, buf, in_size);
-            msg[in_size] = '\0';
-        }
+        memmove(buf->data, buf->data + buf->start, used);
+        buf->scan -= buf->start;
+        buf->start = 0;
+        buf->end = used;
+    }
 
-        /* Move the remaining data (if any) and a '\0' to the front of the
-        ** buffer.
-        */
-        for (i = 0; i < buf_len - in_size + 1; i++)
-            buf[i] = end[i];
+    if (buf->end == buf->size)
+    {
+        /* A single line fills the whole buffer. */
+        buf->size *= 2;
+        buf->data = realloc(buf->data, buf->size);
+    }
 
-        end = strchr(msg, '\n');
-        if (end)
-        {
-            char *retval = msg;
+    *len = buf->size - buf->end;
+    return buf->data + buf->end;
+}
 
-            /* Full message has been received. Chop off the newline. */
-            *end = '\0';
+void msgbuf_commit(msgbuf_t *buf, int len)
+{
+    buf->end += len;
+}
 
-            /* Chop off carriage return if it is present. */
-            end = strrchr(msg, '\r');
-            if (end && *end == '\r')
-                *end = '\0';
+char *msgbuf_process(msgbuf_t *buf)
+{
+    char *msg = buf->data + buf->start;
+    char *end = memchr(buf->data + buf->scan, '\n', buf->end - buf->scan);
 
-            msg = NULL;
-            return retval;
-        }
+    if (!end)
+    {
+        /* Don't search the same data again next time. */
+        buf->scan = buf->end;
+        return NULL;
     }
 
-    return NULL;
-}
+    buf->start = end - buf->data + 1;
+    buf->scan = buf->start;
 
-void msgbuf_exit(void)
-{
-    if (msg)
-        free(msg);
+    /* Chop off the newline and carriage return, if present. */
+    *end = '\0';
+    if (end > msg && end[-1] == '\r')
+        end[-1] = '\0';
 
-    msg = NULL;
+    return msg;
 }
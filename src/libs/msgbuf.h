@@ -18,6 +18,59 @@
 **  along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-char *msgbuf_process(char *buf);
-void msgbuf_exit(void);
+#ifndef MSGBUF_H
+#define MSGBUF_H
 
+/* Line reader for the pipe layers. Data is read straight into the buffer and
+** complete lines are handed out as pointers into it, so nothing is copied or
+** allocated per message.
+*/
+typedef struct msgbuf
+{
+    char *data;
+    int size;
+    int start;  /* Start of the first unread line. */
+    int scan;   /* Everything before this has been searched for a newline. */
+    int end;    /* End of the data. */
+}
+msgbuf_t;
+
+void msgbuf_init(msgbuf_t *buf, int size);
+/* Initializes a line buffer.
+** Parameters: (msgbuf_t *) buf: The buffer to initialize.
+**             (int) size: The initial size in bytes. The buffer grows when
+**                 a single line doesn't fit.
+** Returns   : (void)
+*/
+
+void msgbuf_exit(msgbuf_t *buf);
+/* Frees a line buffer.
+** Parameters: (msgbuf_t *) buf: The buffer to free.
+** Returns   : (void)
+*/
+
+char *msgbuf_space(msgbuf_t *buf, int *len);
+/* Returns the free space at the end of the buffer, for reading new data
+** into. Invalidates messages returned by msgbuf_process.
+** Parameters: (msgbuf_t *) buf: The buffer.
+**             (int *) len: Set to the size of the free space in bytes.
+** Returns   : (char *) Start of the free space.
+*/
+
+void msgbuf_commit(msgbuf_t *buf, int len);
+/* Adds data that was read into the space returned by msgbuf_space.
+** Parameters: (msgbuf_t *) buf: The buffer.
+**             (int) len: Number of bytes that were read.
+** Returns   : (void)
+*/
+
+char *msgbuf_process(msgbuf_t *buf);
+/* Removes the next complete line from the buffer. The newline and a
+** carriage return before it are chopped off.
+** Parameters: (msgbuf_t *) buf: The buffer.
+** Returns   : (char *), The line, which stays valid until the next call to
+**                 msgbuf_process or msgbuf_space.
+**             NULL, if no complete line is available.
+*/
+
+#endif /* MSGBUF_H */
@@ -0,0 +1,152 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Measures the throughput of the unix pipe layer. A child process sends
+** xboard "post" lines through a pipe, either with one write() per line or
+** batched into a buffer, and the parent reads them back line by line.
+**
+** Usage: pipe_bench [lines]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#include "pipe_unix.h"
+
+#define DEFAULT_LINES 1000000
+
+/* Size at which the batched sender flushes its buffer. */
+#define FLUSH_SIZE 4096
+
+static const char *pv = "e2e4 e7e5 g1f3 b8c6 f1b5 a7a6 b5a4 g8f6";
+
+static double now(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static void send_lines(int lines, int batch)
+{
+    char buf[FLUSH_SIZE + 256];
+    int len = 0;
+    int i;
+
+    for (i = 0; i < lines; i++)
+    {
+        len += sprintf(buf + len, "%3i %7i %i %i %s\n", i % 30 + 1,
+                       i % 200 - 100, i * 7, i / 10, pv);
+
+        if (!batch || len >= FLUSH_SIZE)
+        {
+            pipe_unix_write(buf, len);
+            len = 0;
+        }
+    }
+
+    len += sprintf(buf + len, "done\n");
+    pipe_unix_write(buf, len);
+}
+
+static void run(int lines, int batch)
+{
+    int fd[2];
+    int received = 0;
+    double start;
+    double elapsed;
+    pid_t pid;
+
+    if (pipe(fd))
+    {
+        perror("pipe");
+        exit(1);
+    }
+
+    start = now();
+    pid = fork();
+
+    if (pid < 0)
+    {
+        perror("fork");
+        exit(1);
+    }
+
+    if (pid == 0)
+    {
+        close(fd[0]);
+        pipe_unix_init(-1, fd[1]);
+        send_lines(lines, batch);
+        _exit(0);
+    }
+
+    close(fd[1]);
+    pipe_unix_init(fd[0], -1);
+
+    while (1)
+    {
+        int error;
+        char *msg = pipe_unix_receive(&error);
+
+        if (error)
+        {
+            fprintf(stderr, "Error reading from pipe\n");
+            exit(1);
+        }
+
+        if (!strcmp(msg, "done"))
+            break;
+
+        received++;
+    }
+
+    elapsed = now() - start;
+
+    waitpid(pid, NULL, 0);
+    pipe_unix_exit();
+    close(fd[0]);
+
+    if (received != lines)
+    {
+        fprintf(stderr, "Received %i lines, expected %i\n", received, lines);
+        exit(1);
+    }
+
+    printf("%-8s %9i lines %8.3f s %12.0f lines/s\n",
+           batch ? "batched" : "per-line", lines, elapsed, lines / elapsed);
+}
+
+int main(int argc, char **argv)
+{
+    int lines = DEFAULT_LINES;
+
+    if (argc > 1)
+        lines = atoi(argv[1]);
+
+    run(lines, 0);
+    run(lines, 1);
+
+    return 0;
+}
@@ -31,10 +31,10 @@
 #include "pipe_unix.h"
 #include "msgbuf.h"
 
-#define BUF_LEN 1024
+#define BUF_LEN 4096
 
-/* Static buffer. */
-static char buf[BUF_LEN];
+/* Input buffer. */
+static msgbuf_t buf;
 
 static int fd_in, fd_out;
 
@@ -44,16 +44,38 @@ void pipe_unix_init(int in, int out)
     fd_out = out;
 
     fcntl(fd_in, F_SETFL, O_NONBLOCK);
+    msgbuf_init(&buf, BUF_LEN);
 }
 
 void pipe_unix_exit(void)
 {
-    msgbuf_exit();
+    msgbuf_exit(&buf);
 }
 
-void pipe_unix_send(char *m)
+void pipe_unix_send(const char *m)
 {
-    write(fd_out, m, strlen(m));
+    pipe_unix_write(m, strlen(m));
+}
+
+void pipe_unix_write(const char *m, int len)
+{
+    while (len > 0)
+    {
+        int bytes = write(fd_out, m, len);
+
+        if (bytes < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            fprintf(stderr, "%s, L%d: %s\n", __FILE__, __LINE__,
+                    strerror(errno));
+            return;
+        }
+
+        m += bytes;
+        len -= bytes;
+    }
 }
 
 char *pipe_unix_poll(void)
@@ -64,14 +86,15 @@ char *pipe_unix_poll(void)
     while (1)
     {
         char *msg;
+        char *space;
         int len, bytes;
 
-        if ((msg = msgbuf_process(buf)))
+        if ((msg = msgbuf_process(&buf)))
             return msg;
 
         /* Poll for data. */
-        len = strlen(buf);
-        bytes = read(fd_in, buf + len, BUF_LEN - len - 1);
+        space = msgbuf_space(&buf, &len);
+        bytes = read(fd_in, space, len);
 
         if (bytes < 0)
         {
@@ -94,8 +117,21 @@ char *pipe_unix_poll(void)
             exit(-1);
         }
         else
-            buf[len + bytes] = '\0';
+            msgbuf_commit(&buf, bytes);
     }
 
     return NULL;
 }
+
+char *pipe_unix_receive(int *error)
+{
+    char *msg;
+
+    *error = 0;
+
+    /* Our input is non-blocking, so we have to poll. */
+    while (!(msg = pipe_unix_poll()))
+        usleep(1000);
+
+    return msg;
+}
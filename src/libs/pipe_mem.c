@@ -0,0 +1,233 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "pipe_mem.h"
+
+/* Messages up to this size (including the '\0') are stored in the slot
+** itself. Longer ones are allocated on the heap.
+*/
+#define SLOT_SIZE 256
+
+/* Assumed size of a cache line. */
+#define CACHE_LINE 64
+
+typedef struct slot
+{
+    char *msg;
+    char data[SLOT_SIZE - sizeof(char *)];
+}
+slot_t;
+
+struct pipe_mem
+{
+    slot_t *slots;
+    unsigned int mask;
+
+    /* Next slot to be written, only modified by the sender. The padding
+    ** keeps the two indices on separate cache lines.
+    */
+    char pad1[CACHE_LINE];
+    unsigned int head;
+
+    /* Next slot to be read, only modified by the receiver. */
+    char pad2[CACHE_LINE];
+    unsigned int tail;
+
+    /* Set when the receiver is holding on to the slot at tail. */
+    int held;
+
+    /* Number of threads sleeping on cond. Both threads can be in
+    ** wait_until() for a moment, when one is about to wake up just as the
+    ** other goes to sleep.
+    */
+    char pad3[CACHE_LINE];
+    int waiting;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+};
+
+static unsigned int load_acquire(unsigned int *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static void store_release(unsigned int *p, unsigned int val)
+{
+    __atomic_store_n(p, val, __ATOMIC_RELEASE);
+}
+
+static void wake(pipe_mem_t *pipe)
+{
+    /* Pairs with the store to waiting in wait_until(). Either the sleeping
+    ** thread sees our index update, or we see its flag.
+    */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&pipe->waiting, __ATOMIC_RELAXED))
+    {
+        pthread_mutex_lock(&pipe->mutex);
+        pthread_cond_broadcast(&pipe->cond);
+        pthread_mutex_unlock(&pipe->mutex);
+    }
+}
+
+static int is_full(pipe_mem_t *pipe)
+{
+    return pipe->head - load_acquire(&pipe->tail) > pipe->mask;
+}
+
+static int is_empty(pipe_mem_t *pipe)
+{
+    return load_acquire(&pipe->head) == pipe->tail;
+}
+
+static void wait_until(pipe_mem_t *pipe, int (*done)(pipe_mem_t *pipe))
+{
+    pthread_mutex_lock(&pipe->mutex);
+    __atomic_add_fetch(&pipe->waiting, 1, __ATOMIC_SEQ_CST);
+
+    while (!done(pipe))
+        pthread_cond_wait(&pipe->cond, &pipe->mutex);
+
+    __atomic_sub_fetch(&pipe->waiting, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&pipe->mutex);
+}
+
+static int not_full(pipe_mem_t *pipe)
+{
+    return !is_full(pipe);
+}
+
+static int not_empty(pipe_mem_t *pipe)
+{
+    return !is_empty(pipe);
+}
+
+pipe_mem_t *pipe_mem_new(int slots)
+{
+    pipe_mem_t *pipe = malloc(sizeof(pipe_mem_t));
+    unsigned int size = 1;
+
+    while (size < (unsigned int)slots)
+        size <<= 1;
+
+    pipe->slots = malloc(size * sizeof(slot_t));
+    pipe->mask = size - 1;
+    pipe->head = 0;
+    pipe->tail = 0;
+    pipe->held = 0;
+    pipe->waiting = 0;
+    pthread_mutex_init(&pipe->mutex, NULL);
+    pthread_cond_init(&pipe->cond, NULL);
+
+    return pipe;
+}
+
+void pipe_mem_free(pipe_mem_t *pipe)
+{
+    while (pipe_mem_poll(pipe))
+        ;
+
+    pthread_mutex_destroy(&pipe->mutex);
+    pthread_cond_destroy(&pipe->cond);
+    free(pipe->slots);
+    free(pipe);
+}
+
+static void send_msg(pipe_mem_t *pipe, const char *m, int len)
+{
+    slot_t *slot;
+
+    if (is_full(pipe))
+        wait_until(pipe, not_full);
+
+    slot = &pipe->slots[pipe->head & pipe->mask];
+
+    if (len < (int)sizeof(slot->data))
+        slot->msg = slot->data;
+    else
+        slot->msg = malloc(len + 1);
+
+    memcpy(slot->msg, m, len);
+    slot->msg[len] = '\0';
+
+    store_release(&pipe->head, pipe->head + 1);
+    wake(pipe);
+}
+
+void pipe_mem_write(pipe_mem_t *pipe, const char *m, int len)
+{
+    while (len > 0)
+    {
+        const char *end = memchr(m, '\n', len);
+        int msg_len = (end ? end - m : len);
+
+        send_msg(pipe, m, msg_len);
+
+        if (!end)
+            break;
+
+        len -= msg_len + 1;
+        m = end + 1;
+    }
+}
+
+void pipe_mem_send(pipe_mem_t *pipe, const char *m)
+{
+    pipe_mem_write(pipe, m, strlen(m));
+}
+
+char *pipe_mem_poll(pipe_mem_t *pipe)
+{
+    slot_t *slot;
+
+    if (pipe->held)
+    {
+        /* Hand the previous message's slot back to the sender. */
+        slot = &pipe->slots[pipe->tail & pipe->mask];
+
+        if (slot->msg != slot->data)
+            free(slot->msg);
+
+        pipe->held = 0;
+        store_release(&pipe->tail, pipe->tail + 1);
+        wake(pipe);
+    }
+
+    if (is_empty(pipe))
+        return NULL;
+
+    pipe->held = 1;
+    return pipe->slots[pipe->tail & pipe->mask].msg;
+}
+
+char *pipe_mem_receive(pipe_mem_t *pipe)
+{
+    char *msg;
+
+    while (!(msg = pipe_mem_poll(pipe)))
+        wait_until(pipe, not_empty);
+
+    return msg;
+}
@@ -0,0 +1,192 @@
+/*  DreamChess
+**
+**  DreamChess is the legal property of its developers, whose names are too
+**  numerous to list here. Please refer to the COPYRIGHT file distributed
+**  with this source distribution.
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Measures ui frame times while an engine thread streams thinking output
+** to it, once through the lock-free message pipe and once through a
+** mutex-protected message list, as the in-process transport used to do.
+**
+** Usage: pipe_mem_bench [seconds]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "pipe_mem.h"
+#include "msglist.h"
+
+#define FRAME_US 16667
+#define RENDER_US 2000
+#define LINES_PER_BURST 20
+
+static volatile int running;
+static int use_list;
+
+static pipe_mem_t *to_ui;
+static msglist_t list;
+static pthread_mutex_t list_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static long long now(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+static void *engine(void *data)
+{
+    char line[256];
+    long long sent = 0;
+
+    while (running)
+    {
+        int i;
+
+        for (i = 0; i < LINES_PER_BURST; i++)
+        {
+            sprintf(line, "%3i %7i %lli %i e2e4 e7e5 g1f3 b8c6 f1b5 a7a6\n",
+                    (int)(sent % 30) + 1, (int)(sent % 200) - 100, sent * 7,
+                    (int)(sent / 10));
+            sent++;
+
+            if (use_list)
+            {
+                pthread_mutex_lock(&list_mutex);
+                msglist_add(&list, line);
+                pthread_mutex_unlock(&list_mutex);
+            }
+            else
+                pipe_mem_send(to_ui, line);
+        }
+
+        usleep(100);
+    }
+
+    *(long long *)data = sent;
+    return NULL;
+}
+
+static int poll_messages(void)
+{
+    int received = 0;
+
+    if (use_list)
+    {
+        char *s;
+
+        while (1)
+        {
+            pthread_mutex_lock(&list_mutex);
+            s = msglist_remove(&list);
+            pthread_mutex_unlock(&list_mutex);
+
+            if (!s)
+                break;
+
+            free(s);
+            received++;
+        }
+    }
+    else
+        while (pipe_mem_poll(to_ui))
+            received++;
+
+    return received;
+}
+
+static void run(int seconds, int list_mode)
+{
+    pthread_t thread;
+    long long sent, received = 0;
+    long long end, next;
+    double sum = 0, sum_sq = 0, max = 0, poll_max = 0, poll_sum = 0;
+    int frames = 0;
+
+    use_list = list_mode;
+    to_ui = pipe_mem_new(4096);
+    msglist_init(&list);
+    running = 1;
+    pthread_create(&thread, NULL, engine, &sent);
+
+    next = now();
+    end = next + seconds * 1000000LL;
+
+    while (next < end)
+    {
+        long long start = now();
+        double frame, poll;
+
+        received += poll_messages();
+
+        poll = (now() - start) / 1000.0;
+        poll_sum += poll;
+        if (poll > poll_max)
+            poll_max = poll;
+
+        /* Pretend to render. */
+        while (now() - start < RENDER_US)
+            ;
+
+        frame = (now() - start) / 1000.0;
+        sum += frame;
+        sum_sq += frame * frame;
+        if (frame > max)
+            max = frame;
+        frames++;
+
+        next += FRAME_US;
+        if (next > now())
+            usleep(next - now());
+    }
+
+    running = 0;
+    pthread_join(thread, NULL);
+    received += poll_messages();
+
+    printf("%-9s %7lli lines/s  poll %6.3f ms max %6.3f ms  "
+           "frame %6.3f ms stddev %6.3f ms max %6.3f ms\n",
+           list_mode ? "mutex" : "lock-free", received / seconds,
+           poll_sum / frames, poll_max, sum / frames,
+           sqrt(sum_sq / frames - (sum / frames) * (sum / frames)), max);
+
+    if (received != sent)
+        fprintf(stderr, "Sent %lli lines, received %lli\n", sent, received);
+
+    msglist_free(&list);
+    pipe_mem_free(to_ui);
+}
+
+int main(int argc, char **argv)
+{
+    int seconds = 5;
+
+    if (argc > 1)
+        seconds = atoi(argv[1]);
+
+    run(seconds, 1);
+    run(seconds, 0);
+
+    return 0;
+}
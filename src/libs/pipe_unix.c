@@ -24,38 +24,68 @@
 #include <errno.h>
 #include <string.h>
 #include <sys/select.h>
+#include <sys/time.h>
 
 #include "pipe_unix.h"
 #include "msgbuf.h"
 
-#define BUF_LEN 1024
+#define BUF_LEN 4096
 
-/* Static buffer. */
-static char buf[BUF_LEN];
+struct pipe_unix
+{
+    msgbuf_t buf; /* Input buffer. */
+    int fd_in, fd_out;
+};
 
-static fd_set in_set;
-static int fd_in, fd_out;
+/* The pipe of the functions without a pipe argument. */
+static pipe_unix_t pipe_default;
 
-void pipe_unix_init(int in, int out)
+pipe_unix_t *pipe_unix_open(int in, int out)
 {
-    fd_in = in;
-    fd_out = out;
+    pipe_unix_t *pipe = malloc(sizeof(pipe_unix_t));
+
+    pipe->fd_in = in;
+    pipe->fd_out = out;
+    msgbuf_init(&pipe->buf, BUF_LEN);
+
+    return pipe;
 }
 
-void pipe_unix_exit(void)
+void pipe_unix_close(pipe_unix_t *pipe)
 {
-    msgbuf_exit();
+    msgbuf_exit(&pipe->buf);
+    free(pipe);
 }
 
-void pipe_unix_send(const char *m)
+void pipe_unix_send_to(pipe_unix_t *pipe, const char *m)
 {
-    write(fd_out, m, strlen(m));
+    pipe_unix_write_to(pipe, m, strlen(m));
 }
 
-char *pipe_unix_poll(int *error)
+void pipe_unix_write_to(pipe_unix_t *pipe, const char *m, int len)
+{
+    while (len > 0)
+    {
+        int bytes = write(pipe->fd_out, m, len);
+
+        if (bytes < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            fprintf(stderr, "%s, L%d: %s\n", __FILE__, __LINE__,
+                    strerror(errno));
+            return;
+        }
+
+        m += bytes;
+        len -= bytes;
+    }
+}
+
+char *pipe_unix_poll_from(pipe_unix_t *pipe, int *error)
 {
-    FD_ZERO(&in_set);
-    FD_SET(fd_in, &in_set);
+    fd_set in_set;
 
     *error = 0;
 
@@ -67,17 +97,21 @@ char *pipe_unix_poll(int *error)
         struct timeval timeout;
         char *msg;
 
-        if ((msg = msgbuf_process(buf)))
+        if ((msg = msgbuf_process(&pipe->buf)))
             return msg;
 
+        FD_ZERO(&in_set);
+        FD_SET(pipe->fd_in, &in_set);
+
         timeout.tv_sec = 0;
         timeout.tv_usec = 0;
 
         /* Poll for data. */
-        if (select(fd_in + 1, &in_set, NULL, NULL, &timeout) == 1)
+        if (select(pipe->fd_in + 1, &in_set, NULL, NULL, &timeout) == 1)
         {
-            int len = strlen(buf);
-            int bytes = read(fd_in, buf + len, BUF_LEN - len - 1);
+            int len;
+            char *space = msgbuf_space(&pipe->buf, &len);
+            int bytes = read(pipe->fd_in, space, len);
 
             if (bytes < 0)
             {
@@ -97,7 +131,7 @@ char *pipe_unix_poll(int *error)
                 break;
             }
             else
-                buf[len + bytes] = '\0';
+                msgbuf_commit(&pipe->buf, bytes);
         }
         else
             /* No data available. */
@@ -106,3 +140,94 @@ char *pipe_unix_poll(int *error)
     }
     return NULL;
 }
+
+char *pipe_unix_wait_from(pipe_unix_t *pipe, int msec, int *error)
+{
+    struct timeval end;
+
+    if (msec >= 0)
+    {
+        gettimeofday(&end, NULL);
+        end.tv_sec += msec / 1000;
+        end.tv_usec += msec % 1000 * 1000;
+
+        if (end.tv_usec >= 1000000)
+        {
+            end.tv_sec++;
+            end.tv_usec -= 1000000;
+        }
+    }
+
+    while (1)
+    {
+        fd_set in_set;
+        struct timeval timeout, now;
+        char *msg = pipe_unix_poll_from(pipe, error);
+
+        if (msg || *error)
+            return msg;
+
+        if (msec >= 0)
+        {
+            gettimeofday(&now, NULL);
+            timeout.tv_sec = end.tv_sec - now.tv_sec;
+            timeout.tv_usec = end.tv_usec - now.tv_usec;
+
+            if (timeout.tv_usec < 0)
+            {
+                timeout.tv_sec--;
+                timeout.tv_usec += 1000000;
+            }
+
+            /* Timed out. */
+            if (timeout.tv_sec < 0)
+                return NULL;
+        }
+
+        /* Wait for more data. */
+        FD_ZERO(&in_set);
+        FD_SET(pipe->fd_in, &in_set);
+
+        if ((select(pipe->fd_in + 1, &in_set, NULL, NULL,
+                    msec >= 0 ? &timeout : NULL) < 0)
+            && (errno != EINTR))
+        {
+            fprintf(stderr, "%s, L%d: %s\n", __FILE__, __LINE__,
+                    strerror(errno));
+            *error = 1;
+            return NULL;
+        }
+    }
+}
+
+void pipe_unix_init(int in, int out)
+{
+    pipe_default.fd_in = in;
+    pipe_default.fd_out = out;
+    msgbuf_init(&pipe_default.buf, BUF_LEN);
+}
+
+void pipe_unix_exit(void)
+{
+    msgbuf_exit(&pipe_default.buf);
+}
+
+void pipe_unix_send(const char *m)
+{
+    pipe_unix_send_to(&pipe_default, m);
+}
+
+void pipe_unix_write(const char *m, int len)
+{
+    pipe_unix_write_to(&pipe_default, m, len);
+}
+
+char *pipe_unix_poll(int *error)
+{
+    return pipe_unix_poll_from(&pipe_default, error);
+}
+
+char *pipe_unix_receive(int *error)
+{
+    return pipe_unix_wait_from(&pipe_default, -1, error);
+}
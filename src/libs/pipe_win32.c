@@ -24,10 +24,10 @@
 #include "pipe_win32.h"
 #include "msgbuf.h"
 
-#define BUF_LEN 1024
+#define BUF_LEN 4096
 
-/* Static buffer. */
-static char buf[BUF_LEN];
+/* Input buffer. */
+static msgbuf_t buf;
 
 static HANDLE h_in, h_out;
 
@@ -39,19 +39,24 @@ void pipe_win32_init(HANDLE in, HANDLE out, int console)
     h_in = in;
     h_out = out;
     console_mode = console;
+    msgbuf_init(&buf, BUF_LEN);
 }
 
 void pipe_win32_exit(void)
 {
-    msgbuf_exit();
+    msgbuf_exit(&buf);
 }
 
 void pipe_win32_send(const char *m)
+{
+    pipe_win32_write(m, strlen(m));
+}
+
+void pipe_win32_write(const char *m, int len)
 {
     DWORD written;
 
-    if (!WriteFile(h_out, m, strlen(m), &written, NULL) ||
-        (written < strlen(m)))
+    if (!WriteFile(h_out, m, len, &written, NULL) || (written < len))
     {
         fprintf(stderr, "%s, L%d: Error writing to pipe.\n", __FILE__,
             __LINE__);
@@ -70,13 +75,12 @@ char *pipe_win32_poll(int *error)
     {
         DWORD bytes;
         char *msg;
+        char *space;
         int len;
 
-        if ((msg = msgbuf_process(buf)))
+        if ((msg = msgbuf_process(&buf)))
             return msg;
 
-        len = strlen(buf);
-
         /* Check whether data is available. */
         if (console_mode)
         {
@@ -98,7 +102,9 @@ char *pipe_win32_poll(int *error)
         if (bytes > 0)
         {
             /* Read data. */
-            if (!ReadFile(h_in, buf + len, BUF_LEN - len - 1, &bytes, NULL))
+            space = msgbuf_space(&buf, &len);
+
+            if (!ReadFile(h_in, space, len, &bytes, NULL))
             {
                 /* Error reading pipe. */
                 fprintf(stderr, "%s, L%d: Broken pipe.\n", __FILE__, __LINE__);
@@ -114,7 +120,7 @@ char *pipe_win32_poll(int *error)
                 return NULL;
             }
 
-            buf[len + bytes] = '\0';
+            msgbuf_commit(&buf, bytes);
         }
         else
             /* No data available. */
@@ -122,3 +128,17 @@ char *pipe_win32_poll(int *error)
     }
     return NULL;
 }
+
+char *pipe_win32_receive(int *error)
+{
+    while (1)
+    {
+        char *msg = pipe_win32_poll(error);
+
+        if (msg || *error)
+            return msg;
+
+        /* Anonymous pipes can't be waited on, so we poll. */
+        Sleep(1);
+    }
+}